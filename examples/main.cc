@@ -54,7 +54,7 @@ template <typename WriterTy> void testSVG() {
 
 int main(int argc, const char **argv) {
   if (argc != 2) {
-    std::cerr << "USAGE: test [raw|formatted|js]" << std::endl;
+    std::cerr << "USAGE: test [raw|formatted|js|jstable]" << std::endl;
     return 1;
   }
   std::string command = argv[1];
@@ -64,6 +64,8 @@ int main(int argc, const char **argv) {
     testSVG<svg::SVGFormattedWriter>();
   else if (command == "js")
     testSVG<svg::SVGJSWriter>();
+  else if (command == "jstable")
+    testSVG<svg::SVGJSTableWriter>();
   else {
     std::cerr << "Unknown format specified: " << command << std::endl;
     return 1;
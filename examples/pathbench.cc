@@ -0,0 +1,57 @@
+#include "svgutils/svg_document.h"
+#include "svgutils/svg_path_data.h"
+#include "svgutils/svg_reader_writer.h"
+#include "svgutils/svgz_stream.h"
+
+#include <chrono>
+#include <iostream>
+
+// Measures PathData::parse on the path data of a document, e.g.
+//   pathbench test/Inputs/Creative_Commons_mapa_mundial.svg
+using namespace svg;
+
+static void collectPaths(const SVGNode &node, std::vector<std::string> &paths) {
+  if (node.is(SVGNode::TagType::path))
+    if (const std::string *d = node.getAttr("d"))
+      paths.push_back(*d);
+  for (const auto &child : node.children)
+    collectPaths(*child, paths);
+}
+
+int main(int argc, const char **argv) {
+  if (argc < 2) {
+    std::cerr << "Usage: " << argv[0] << " <svg file> [iterations]\n";
+    return 1;
+  }
+  unsigned iterations = argc > 2 ? std::atoi(argv[2]) : 20;
+  std::unique_ptr<std::istream> in = openSVGInput(argv[1]);
+  if (!in) {
+    std::cerr << "Unable to read " << argv[1] << "\n";
+    return 1;
+  }
+  SVGDocumentBuilder builder;
+  SVGReaderWriterBase reader(builder);
+  if (auto err = reader.parse(*in)) {
+    std::cerr << *err << "\n";
+    return 1;
+  }
+  std::vector<std::string> paths;
+  collectPaths(builder.getDocument().getRoot(), paths);
+  size_t bytes = 0;
+  for (const std::string &d : paths)
+    bytes += d.size();
+
+  size_t segments = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (unsigned i = 0; i < iterations; ++i)
+    for (const std::string &d : paths)
+      segments += PathData::parse(d).getVerbs().size();
+  std::chrono::duration<double> time = std::chrono::steady_clock::now() - start;
+
+  double perIteration = time.count() / iterations;
+  std::cout << paths.size() << " paths, " << bytes << " bytes, "
+            << segments / iterations << " segments\n"
+            << perIteration * 1000. << " ms per iteration, "
+            << bytes / perIteration / (1 << 20) << " MiB/s\n";
+  return 0;
+}
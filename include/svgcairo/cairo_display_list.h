@@ -0,0 +1,94 @@
+#ifndef SVGCAIRO_CAIRO_DISPLAY_LIST_H
+#define SVGCAIRO_CAIRO_DISPLAY_LIST_H
+
+#include "svgcairo/svg_cairo.h"
+#include "svgutils/svg_display_list.h"
+
+#include <thread>
+
+namespace svg {
+/// Draws an SVGDisplayList with Cairo. The display list is only read, so
+/// one document can be rendered to any number of outputs (e.g. thumbnails
+/// of several sizes and a PDF) in parallel, and every added output only
+/// costs the time to rasterize it.
+///
+/// Small outputs don't need all the detail of the document. With a level
+/// of detail set, paths are simplified to the tolerance at the scale they
+/// are drawn at, and paths and groups smaller than a minimum size are not
+/// drawn at all.
+class CairoDisplayListRenderer {
+public:
+  struct Target {
+    fs::path outfile;
+    CairoSVGWriter::OutputFormat fmt = CairoSVGWriter::PNG;
+    /// Size of the output relative to the document
+    double scale = 1.;
+  };
+  /// The error budget, in device units (i.e. pixels for PNG)
+  struct LevelOfDetail {
+    /// How far simplified paths may deviate from the original. 0 draws
+    /// paths as they are.
+    double tolerance = 0.;
+    /// Paths and groups whose bounds are smaller than this in both
+    /// directions are dropped
+    double minSize = 0.;
+  };
+  struct Statistics {
+    CullingStatistics culling;
+    /// Vertices of the paths drawn, before and after simplification
+    size_t vertices = 0;
+    size_t simplifiedVertices = 0;
+    /// Paths dropped because they were smaller than the minimum size
+    size_t dropped = 0;
+
+    /// Vertices removed by simplification. Flattening curves adds some.
+    long long getRemovedVertices() const {
+      return static_cast<long long>(vertices) -
+             static_cast<long long>(simplifiedVertices);
+    }
+    Statistics &operator+=(const Statistics &other) {
+      culling += other.culling;
+      vertices += other.vertices;
+      simplifiedVertices += other.simplifiedVertices;
+      dropped += other.dropped;
+      return *this;
+    }
+    friend inline outstream_t &operator<<(outstream_t &os,
+                                          const Statistics &stats) {
+      os << stats.culling << ", vertices: " << stats.vertices
+         << ", removed vertices: " << stats.getRemovedVertices()
+         << ", dropped: " << stats.dropped;
+      return os;
+    }
+  };
+
+  explicit CairoDisplayListRenderer(const SVGDisplayList &list)
+      : list(list) {}
+
+  void setLevelOfDetail(const LevelOfDetail &lod) { this->lod = lod; }
+
+  /// Draw the display list onto @p cr, whose user space is in px. Text is
+  /// set with fonts from @p fonts. Items and groups outside of the clip
+  /// are skipped.
+  Statistics draw(_cairo *cr, Freetype &fonts) const;
+  /// Draw only the path and text items at @p indices, in drawing order,
+  /// e.g. from SVGDisplayListIndex::query. They are drawn whether visible
+  /// or not.
+  Statistics draw(_cairo *cr, Freetype &fonts,
+                  const std::vector<uint32_t> &indices) const;
+  /// Write the display list to @p target. Returns false and prints the
+  /// reason if that failed.
+  bool render(const Target &target, Statistics *stats = nullptr) const;
+  /// Write the display list to all of @p targets, rendering up to
+  /// @p numThreads of them at the same time. Returns whether all
+  /// succeeded. The statistics of all targets are added to @p stats.
+  bool render(const std::vector<Target> &targets,
+              unsigned numThreads = std::thread::hardware_concurrency(),
+              Statistics *stats = nullptr) const;
+
+private:
+  const SVGDisplayList &list;
+  LevelOfDetail lod;
+};
+} // namespace svg
+#endif // SVGCAIRO_CAIRO_DISPLAY_LIST_H
@@ -0,0 +1,92 @@
+#ifndef SVGCAIRO_CAIRO_PATH_CACHE_H
+#define SVGCAIRO_CAIRO_PATH_CACHE_H
+
+#include "svgutils/svg_writer.h"
+
+#include <list>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+struct cairo_path;
+
+namespace svg {
+/// Paths built by CairoSVGWriter, so path data that is drawn again (e.g.
+/// markers, symbols or the same shape in several documents) is appended to
+/// the context in one call instead of being parsed again.
+///
+/// Paths are keyed by a hash of their path data and the scale lengths are
+/// converted with, which depends on the output format. The least recently
+/// used paths are dropped when the cache exceeds its memory limit.
+/// Writers on the same thread may share a cache.
+class CairoPathCache {
+public:
+  static constexpr size_t DefaultCapacity = 32 << 20;
+
+  struct Statistics {
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t evictions = 0;
+    size_t entries = 0;
+    /// Memory used by the cached paths and their keys
+    size_t bytes = 0;
+
+    double getHitRate() const {
+      return hits + misses ? static_cast<double>(hits) / (hits + misses) : 0.;
+    }
+    friend inline outstream_t &operator<<(outstream_t &os,
+                                          const Statistics &stats) {
+      os << "hits: " << stats.hits << ", misses: " << stats.misses
+         << " (hit rate " << stats.getHitRate() * 100.
+         << "%), evictions: " << stats.evictions
+         << ", entries: " << stats.entries << ", bytes: " << stats.bytes;
+      return os;
+    }
+  };
+
+  /// Keep at most @p capacity bytes of paths
+  explicit CairoPathCache(size_t capacity = DefaultCapacity)
+      : capacity(capacity) {}
+  CairoPathCache(const CairoPathCache &) = delete;
+  CairoPathCache &operator=(const CairoPathCache &) = delete;
+  ~CairoPathCache() { clear(); }
+
+  /// The path of @p d at @p scale, nullptr if it isn't cached. Counts a hit
+  /// or a miss.
+  const cairo_path *find(std::string_view d, double scale);
+  /// Add @p path, built from @p d at @p scale. The cache takes ownership.
+  void insert(std::string_view d, double scale, cairo_path *path);
+  void clear();
+
+  const Statistics &getStatistics() const { return stats; }
+
+private:
+  friend class CairoPathCacheTest;
+
+  struct Entry {
+    size_t hash;
+    std::string d;
+    double scale;
+    cairo_path *path;
+    size_t bytes;
+  };
+  using EntryList = std::list<Entry>;
+
+  static size_t hash(std::string_view d, double scale);
+  /// Memory accounted for @p path built from @p d
+  static size_t getBytes(std::string_view d, const cairo_path *path);
+  /// find() and insert() with @p key as the hash of @p d and @p scale
+  const cairo_path *find(size_t key, std::string_view d, double scale);
+  void insert(size_t key, std::string_view d, double scale, cairo_path *path);
+  /// Drop least recently used paths until @p bytes more fit
+  void makeRoom(size_t bytes);
+  void erase(EntryList::iterator it);
+
+  size_t capacity;
+  /// Most recently used first
+  EntryList entries;
+  std::unordered_multimap<size_t, EntryList::iterator> index;
+  Statistics stats;
+};
+} // namespace svg
+#endif // SVGCAIRO_CAIRO_PATH_CACHE_H
@@ -0,0 +1,63 @@
+#ifndef SVGCAIRO_CAIRO_TILE_PYRAMID_H
+#define SVGCAIRO_CAIRO_TILE_PYRAMID_H
+
+#include "svgcairo/cairo_display_list.h"
+
+namespace svg {
+/// Renders a display list as a pyramid of square PNG tiles, like the z/x/y
+/// tiles of slippy maps or deep zoom viewers. At zoom level 0 the whole
+/// document fits into one tile, and every further level doubles the scale.
+/// The items are indexed once, so every tile only draws the items
+/// intersecting it instead of the whole document.
+class CairoTilePyramid {
+public:
+  struct Tile {
+    unsigned z, x, y;
+  };
+  static constexpr unsigned DefaultTileSize = 256;
+  /// The index gets no finer than this many cells across the document, so
+  /// large items don't fill too many cells
+  static constexpr double MaxIndexCells = 256.;
+  /// Every level has four times the tiles of the one before, so deeper
+  /// pyramids can't be rendered in reasonable time
+  static constexpr unsigned MaxZoomLevel = 20;
+
+  /// Tiles of @p tileSize pixels, up to zoom level @p maxZoom, which must
+  /// not exceed MaxZoomLevel
+  CairoTilePyramid(const SVGDisplayList &list, unsigned maxZoom,
+                   unsigned tileSize = DefaultTileSize);
+
+  void setLevelOfDetail(const CairoDisplayListRenderer::LevelOfDetail &lod) {
+    renderer.setLevelOfDetail(lod);
+  }
+  const SVGDisplayListIndex &getIndex() const { return index; }
+  /// Size of the tiles relative to the document at zoom level @p z
+  double getScale(unsigned z) const;
+  unsigned getColumns(unsigned z) const;
+  unsigned getRows(unsigned z) const;
+  size_t getNumTiles(unsigned z) const {
+    return static_cast<size_t>(getColumns(z)) * getRows(z);
+  }
+
+  /// Write @p tile to @p outfile, with fonts from @p fonts. Returns false
+  /// and prints the reason if that failed.
+  bool render(const Tile &tile, const fs::path &outfile, Freetype &fonts,
+              CairoDisplayListRenderer::Statistics *stats = nullptr) const;
+  /// Write the tiles of the zoom levels from @p minZoom up to the maximum
+  /// to `<outdir>/<z>/<x>/<y>.png`, rendering up to @p numThreads of them
+  /// at the same time. Tiles are enumerated level by level as they are
+  /// rendered. Returns whether all succeeded. The statistics of all tiles
+  /// are added to @p stats.
+  bool render(unsigned minZoom, const fs::path &outdir,
+              unsigned numThreads = std::thread::hardware_concurrency(),
+              CairoDisplayListRenderer::Statistics *stats = nullptr) const;
+
+private:
+  const SVGDisplayList &list;
+  unsigned maxZoom;
+  unsigned tileSize;
+  SVGDisplayListIndex index;
+  CairoDisplayListRenderer renderer;
+};
+} // namespace svg
+#endif // SVGCAIRO_CAIRO_TILE_PYRAMID_H
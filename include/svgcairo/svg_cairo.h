@@ -1,8 +1,11 @@
 #ifndef SVGCAIRO_SVG_CAIRO_H
 #define SVGCAIRO_SVG_CAIRO_H
 
+#include "svgcairo/cairo_path_cache.h"
 #include "svgcairo/freetype.h"
 #include "svgutils/css_utils.h"
+#include "svgutils/svg_path_data.h"
+#include "svgutils/svg_viewport.h"
 #include "svgutils/svg_writer.h"
 
 #include <filesystem>
@@ -11,9 +14,31 @@ struct _cairo;
 struct _cairo_surface;
 
 namespace svg {
-
 namespace fs = std::filesystem;
 
+/// Elements that were not drawn because they are outside of the visible
+/// area
+struct CullingStatistics {
+  /// Shapes and text runs, drawn or not
+  size_t elements = 0;
+  size_t culled = 0;
+  /// Groups skipped as a whole. Their elements count as culled.
+  size_t culledGroups = 0;
+
+  CullingStatistics &operator+=(const CullingStatistics &other) {
+    elements += other.elements;
+    culled += other.culled;
+    culledGroups += other.culledGroups;
+    return *this;
+  }
+  friend inline outstream_t &operator<<(outstream_t &os,
+                                        const CullingStatistics &stats) {
+    os << "elements: " << stats.elements << ", culled: " << stats.culled
+       << ", culled groups: " << stats.culledGroups;
+    return os;
+  }
+};
+
 class CairoSVGWriter {
 public:
   using self_t = CairoSVGWriter;
@@ -21,6 +46,8 @@ public:
   using RetTy = SVGWriterErrorOr<CairoSVGWriter *>;
 
   enum OutputFormat { PDF, PNG };
+  /// How the document is sized to the dimensions given to the constructor
+  using Fit = SVGViewport::Fit;
 
   /// Try to extract the document size from the first <svg> tag written later
   /// using the writer. It is possible to set different default output
@@ -68,16 +95,53 @@ public:
 
   void setDefaultWidth(double w) { dfltWidth = w; }
   void setDefaultHeight(double h) { dfltHeight = h; }
+  /// Has to be called before anything is written
+  void setFit(Fit fit) { this->fit = fit; }
+
+  static constexpr unsigned DefaultTileSize = 512;
+  /// Record PNG output and rasterize it in tiles of @p tileSize pixels on
+  /// @p numThreads threads when the document is finished. The pixels are
+  /// the same for any number of threads. Has to be called before anything
+  /// is written.
+  void setTiling(unsigned numThreads, unsigned tileSize = DefaultTileSize);
+
+  const StyleTracker::Statistics &getStyleStatistics() const {
+    return styles.getStatistics();
+  }
+  /// Draw paths through @p cache, e.g. to share it between the writers of
+  /// a batch of documents. Every writer starts with a cache of its own.
+  void setPathCache(std::shared_ptr<CairoPathCache> cache) {
+    pathCache = std::move(cache);
+  }
+  const CairoPathCache::Statistics &getPathCacheStatistics() const {
+    return pathCache->getStatistics();
+  }
+  /// Shapes and text outside of the surface are skipped before anything is
+  /// sent to Cairo
+  const CullingStatistics &getCullingStatistics() const { return culling; }
 
 private:
   const fs::path outfile;
   const OutputFormat fmt;
   Freetype fonts;
   StyleTracker styles;
+  std::shared_ptr<CairoPathCache> pathCache =
+      std::make_shared<CairoPathCache>();
   double dfltWidth = 300;
   double dfltHeight = 200;
   double width = 0;
   double height = 0;
+  Fit fit = Fit::VIEWPORT;
+  /// Size of the user space of the document that percentages refer to, 0
+  /// until the root element is read
+  double userWidth = 0;
+  double userHeight = 0;
+  /// Scale of the viewBox transform. Cairo keeps paths in device space, so
+  /// cached paths are only reused at the same scale.
+  double viewScale = 1.;
+  /// Threads rasterizing tiles, 0 to render to the image directly
+  unsigned tileThreads = 0;
+  unsigned tileSize = DefaultTileSize;
   using SurfaceDestroyTy = void(*)(_cairo_surface *);
   using OwnedSurface =
       std::unique_ptr<_cairo_surface, SurfaceDestroyTy>;
@@ -85,9 +149,17 @@ private:
   using OwnedCairo = std::unique_ptr<_cairo, CairoDestroyTy>;
   OwnedSurface surface = {nullptr, nullptr};
   OwnedCairo cairo = {nullptr, nullptr};
+  /// The area of the surface, in output units
+  PathData::Bounds visible{};
+  CullingStatistics culling;
+  /// Text of the current text element that was culled. It's only needed to
+  /// know where text following it starts.
+  std::string culledText;
 
   enum class TagType;
   friend outstream_t &operator<<(outstream_t &os, TagType tag);
+  /// The name of @p tag, nullptr for custom tags
+  static const char *getTagName(TagType tag);
   TagType currentTag;
   /// When a custom tag is opened, we ignore it. However, we still want
   /// to allow entering the custom tag and inserting even more tags (which
@@ -106,66 +178,24 @@ private:
   void applyCSSStroke(bool preserve);
   void applyCSSFillAndStroke(bool preserve);
   void initCairo();
-
-  struct PathError {
-    explicit PathError(const std::string &what) : msg(what) {}
-    PathError(const PathError &) = default;
-    PathError &operator=(const PathError &) = default;
-    PathError(PathError &&) = default;
-    PathError &operator=(PathError &&) = default;
-    const std::string &what() const { return msg; }
-  private:
-    std::string msg;
-  };
-  template<typename T>
-  struct PathErrorOr {
-    // Initialize-from-value ctors
-    PathErrorOr(const T &val) : content(val) {}
-    PathErrorOr(T &&val) : content(std::move(val)) {}
-    PathErrorOr(const PathError &err) : content(err) {}
-    PathErrorOr(PathError &&err) : content(std::move(err)) {}
-    // Default/Copy/Assignment ctors
-    PathErrorOr() = delete;
-    PathErrorOr(const PathErrorOr &) = default;
-    PathErrorOr &operator=(const PathErrorOr &) = default;
-    PathErrorOr(PathErrorOr &&) = default;
-    PathErrorOr &operator=(PathErrorOr &&) = default;
-    // Inspection
-    operator bool() const { return std::holds_alternative<PathError>(content); }
-    const T& operator*() const { return std::get<T>(content); }
-    operator const T&() const { return std::get<T>(content); }
-    const PathError &to_error() const { return std::get<PathError>(content); }
-  private:
-    std::variant<PathError, T> content;
-  };
-  struct PathErrorOrVoid {
-    PathErrorOrVoid() = default;
-    PathErrorOrVoid(const PathError &err) : err(err) {}
-    PathErrorOrVoid(PathError &&err) : err(std::move(err)) {}
-    // Default/Copy/Assignment ctors
-    PathErrorOrVoid(const PathErrorOrVoid &) = default;
-    PathErrorOrVoid &operator=(const PathErrorOrVoid &) = default;
-    PathErrorOrVoid(PathErrorOrVoid &&) = default;
-    PathErrorOrVoid &operator=(PathErrorOrVoid &&) = default;
-    // Inspection
-    operator bool() const { return !!err; }
-    const PathError &to_error() const { return *err; }
-  private:
-    std::optional<PathError> err;
-  };
-
-  using ControlPoint = std::pair<double, double>;
-
-  PathErrorOr<ControlPoint> CairoExecuteCubicBezier(std::string_view args, bool rel);
-  PathErrorOr<ControlPoint> CairoExecuteSmoothCubicBezier(std::string_view args, bool rel, const std::optional<ControlPoint> &PrevCP);
-  PathErrorOr<ControlPoint> CairoExecuteQuadraticBezier(std::string_view args, bool rel);
-  PathErrorOr<ControlPoint> CairoExecuteSmoothQuadraticBezier(std::string_view args, bool rel, const std::optional<ControlPoint> &PrevCP);
-  PathErrorOrVoid CairoExecuteArc(std::string_view args, bool rel);
-  PathErrorOrVoid CairoExecuteHLine(std::string_view length, bool rel);
-  PathErrorOrVoid CairoExecuteVLine(std::string_view length, bool rel);
-  PathErrorOrVoid CairoExecuteLineTo(std::string_view points, bool rel);
-  PathErrorOrVoid CairoExecuteMoveTo(std::string_view points, bool rel);
-  PathErrorOrVoid CairoExecutePath(const char *pathRaw);
+  /// Size the output for the root element with @p attrs and map its viewBox
+  /// onto the viewport
+  void initViewport(const AttrContainer &attrs);
+  /// Rasterize the recorded document into a new image surface
+  OwnedSurface rasterizeTiles();
+  /// Scale from user units to output units
+  double getUnitScale() const;
+  /// Append @p path to the current path, converted to output units
+  void appendPath(const PathData &path);
+  /// Draw a `<polyline>` or (with @p close) `<polygon>`
+  void drawPoints(const AttrContainer &attrs, bool close);
+  /// Whether a shape with @p bounds (in output units) may be visible when
+  /// stroked with the current styles. Shapes without corners (@p joins)
+  /// need less space for their stroke. Counts the shape for the culling
+  /// statistics.
+  bool isVisible(const PathData::Bounds &bounds, bool joins);
+  /// Move the current point past @p text, without drawing it
+  void skipText(const std::string &text);
 };
 } // namespace svg
 #endif // SVGCAIRO_SVG_CAIRO_H
@@ -0,0 +1,147 @@
+#ifndef SVGUTILS_CANVAS_WRITER_H
+#define SVGUTILS_CANVAS_WRITER_H
+
+#include "svgutils/css_utils.h"
+#include "svgutils/js_writer.h"
+
+#include <unordered_map>
+
+namespace svg {
+class PathData;
+
+/// Writer producing JavaScript that draws the document on an HTML canvas
+/// (via its 2D context) instead of creating DOM elements, so even huge
+/// documents don't cost the browser any memory for elements.
+/// Styles are resolved with StyleTracker while writing, like
+/// CairoSVGWriter does, so the output only contains drawing calls. Canvas
+/// state (fill and stroke style, line width, ...) is only set when it
+/// changes.
+///
+/// There are two modes:
+/// * `CALLS` writes the drawing calls (`ctx.beginPath()`, `ctx.moveTo(..)`,
+///   ...) directly.
+/// * `COMMANDS` writes a table of opcodes and numbers plus a table of
+///   strings, which a small replay function turns into the same calls. This
+///   is much more compact.
+/// In both modes, the output expects the 2D context to be in a variable
+/// named `ContextName`.
+///
+/// Supported are the same elements as in CairoSVGWriter (plus ellipse,
+/// polyline and polygon), and like there, transforms are not applied yet.
+/// The contents of elements that don't render directly (e.g. defs or
+/// clipPath) and of custom tags are ignored.
+struct SVGCanvasWriter : public SVGWriterBase<SVGCanvasWriter> {
+  using self_t = SVGCanvasWriter;
+  using base_t = SVGWriterBase<self_t>;
+  using RetTy = SVGWriterErrorOr<self_t *>;
+
+  enum class Mode { CALLS, COMMANDS };
+  static constexpr unsigned DefaultPrecision = 2;
+
+  explicit SVGCanvasWriter(outstream_t &os, Mode mode = Mode::COMMANDS,
+                           const char *ContextName = "ctx",
+                           unsigned precision = DefaultPrecision);
+
+  RetTy enter();
+  RetTy leave();
+  RetTy finish();
+  RetTy content(const char *text);
+  RetTy comment(const char *) { return this; }
+
+  const StyleTracker::Statistics &getStyleStatistics() const {
+    return styles.getStatistics();
+  }
+
+  /// Drawing operations. In `COMMANDS` mode, these are the opcodes.
+  enum class Op {
+    BEGIN_PATH = 0,
+    MOVE_TO,
+    LINE_TO,
+    CUBIC_TO,
+    RECT,
+    ELLIPSE,
+    CLOSE_PATH,
+    FILL,
+    STROKE,
+    FILL_STYLE,
+    STROKE_STYLE,
+    LINE_WIDTH,
+    LINE_DASH,
+    FONT,
+    TEXT_ALIGN,
+    FILL_TEXT,
+    STROKE_TEXT,
+  };
+  /// The replay function for `COMMANDS` mode, defined once per page
+  static const char *const Interpreter;
+
+private:
+  friend base_t;
+  /// Canvas state as last set by the output
+  struct CanvasState {
+    std::string fillStyle;
+    std::string strokeStyle;
+    double lineWidth = 1.;
+    std::vector<double> lineDash;
+    std::string font;
+    std::string textAlign;
+  };
+
+  template <typename container_t>
+  void openTag(const char *tagname, const container_t &attrs) {
+    std::vector<SVGAttribute> attrsVec(attrs.begin(), attrs.end());
+    openTag(tagname, attrsVec);
+  }
+  void openTag(const char *tagname, const std::vector<SVGAttribute> &attrs);
+  void closeTag();
+
+  // Elements
+  void readDimensions(const std::vector<SVGAttribute> &attrs);
+  void drawRect(const std::vector<SVGAttribute> &attrs);
+  void drawEllipse(const std::vector<SVGAttribute> &attrs, bool circle);
+  void drawLine(const std::vector<SVGAttribute> &attrs);
+  void drawPath(const PathData &path);
+  void startText(const std::vector<SVGAttribute> &attrs);
+  /// Whether the current element is filled (if @p fill) or stroked at all
+  bool hasPaint(bool fill = true) const;
+  /// Fill (if @p fill) and stroke the current path
+  void paint(bool fill = true);
+
+  // Conversion
+  /// What percentages of stroke-width and stroke-dasharray refer to: the
+  /// diagonal of the document normalized by sqrt(2)
+  double getDiagonal() const;
+  std::string getFont() const;
+
+  // Output
+  void emit(Op op, std::initializer_list<double> args = {});
+  void emit(Op op, const std::string &str,
+            std::initializer_list<double> args = {});
+  void setFillStyle(const CSSColor &color);
+  void setStrokeStyle(const CSSColor &color, double width);
+  void writeNumber(double value);
+  /// Separate the next number (or opcode) from the last one
+  void separate();
+  /// Write the start of the output before the first drawing call
+  void start();
+  size_t intern(const std::string &str);
+
+  Mode mode;
+  const char *contextName;
+  unsigned precision;
+  StyleTracker styles;
+  CanvasState state;
+  /// Size of the document for lengths in percent. Defaults are the same as
+  /// CairoSVGWriter's.
+  double docWidth = 300., docHeight = 200.;
+  /// Position of the current text element
+  double textX = 0., textY = 0.;
+  /// Depth of ignored elements entered, like in CairoSVGWriter
+  size_t ignore = 0;
+  bool started = false;
+  size_t valuesInLine = 0;
+  std::unordered_map<std::string, size_t> stringIndices;
+  std::vector<const std::string *> strings;
+};
+} // namespace svg
+#endif // SVGUTILS_CANVAS_WRITER_H
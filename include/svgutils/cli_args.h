@@ -52,6 +52,7 @@
 #include <cassert>
 #include <cctype>
 #include <charconv>
+#include <cstdlib>
 #include <deque>
 #include <filesystem>
 #include <map>
@@ -734,6 +735,15 @@ template <> std::optional<unsigned> CliParseValue(std::string_view value) {
     return std::nullopt;
   return u;
 }
+/// Definition of CliParseValue<double>
+template <> std::optional<double> CliParseValue(std::string_view value) {
+  std::string str(value);
+  char *end;
+  double d = std::strtod(str.c_str(), &end);
+  if (str.empty() || end != str.c_str() + str.size())
+    return std::nullopt;
+  return d;
+}
 
 /// We specialize option parsing for booleans since they should only be
 /// set implicitly (just the flag) or using an inline value
@@ -0,0 +1,114 @@
+#ifndef SVGUTILS_CSS_STYLESHEET_H
+#define SVGUTILS_CSS_STYLESHEET_H
+
+#include "svgutils/css_utils.h"
+#include "svgutils/utils.h"
+
+#include <deque>
+#include <unordered_map>
+
+namespace svg {
+/// Calls `fn(name, value)` for every declaration of the declaration block
+/// @p block, e.g. the contents of a `style` attribute. Names and values are
+/// trimmed, a trailing `!important` is dropped.
+template <typename Fn>
+void forEachCSSDeclaration(std::string_view block, Fn fn) {
+  while (block.size()) {
+    size_t end = block.find(';');
+    std::string_view decl = block.substr(0, end);
+    block = end == block.npos ? std::string_view() : block.substr(end + 1);
+    size_t split = decl.find(':');
+    if (split == decl.npos)
+      continue;
+    std::string_view name = strview_trim(decl.substr(0, split));
+    std::string_view value = strview_trim(decl.substr(split + 1));
+    size_t bang = value.rfind('!');
+    if (bang != value.npos &&
+        strview_trim(value.substr(bang + 1)) == "important")
+      value = strview_trim(value.substr(0, bang));
+    fn(name, value);
+  }
+}
+
+/// The rules of `<style>` elements, indexed for matching.
+///
+/// Like the rule hashes of browsers, every selector is put into a single
+/// bucket by its most specific part: its id, else its first class, else its
+/// tag. Matching an element then only tests the rules in the buckets of
+/// its id, its classes and its tag plus the few universal rules, instead of
+/// every rule of the sheet.
+///
+/// Supported are compound selectors of a tag (or `*`), ids and classes, like
+/// `path.land#fr`, and lists of them. Selectors with combinators, attribute
+/// selectors or pseudo-classes can't be decided from the element alone
+/// and are skipped, as are at-rules. Declarations of properties
+/// StyleTracker doesn't know are dropped.
+class CSSStylesheet {
+public:
+  using Style = StyleTracker::Style;
+  struct Declaration {
+    Style style;
+    std::string value;
+  };
+  /// The parts of an element selectors can refer to
+  struct Element {
+    std::string_view tag;
+    std::string_view id;
+    /// Whitespace-separated class names, as in the `class` attribute
+    std::string_view classes;
+  };
+  /// Specificity and index of a matching rule
+  using Match = std::pair<uint32_t, uint32_t>;
+
+  CSSStylesheet() = default;
+  CSSStylesheet(const CSSStylesheet &) = delete;
+  CSSStylesheet &operator=(const CSSStylesheet &) = delete;
+
+  /// Add the rules of @p css
+  void parse(std::string_view css);
+
+  /// Find the rules matching @p element. @p matches is overwritten with
+  /// them in cascade order, i.e. by ascending specificity, then source
+  /// order.
+  void match(const Element &element, std::vector<Match> &matches) const;
+  const std::vector<Declaration> &getDeclarations(uint32_t rule) const {
+    return Rules[rule];
+  }
+
+  bool empty() const { return Selectors.empty(); }
+  /// Whether the id of an element can matter
+  bool hasIdSelectors() const { return !ById.empty(); }
+  size_t getNumRules() const { return Rules.size(); }
+  size_t getNumSelectors() const { return Selectors.size(); }
+
+private:
+  /// A compound selector. Empty parts match anything.
+  struct Selector {
+    std::string tag;
+    std::string id;
+    std::vector<std::string> classes;
+    uint32_t specificity;
+    uint32_t rule;
+  };
+  using Bucket = std::vector<uint32_t>;
+
+  static bool parseSelector(std::string_view text, Selector &selector);
+  void addSelector(Selector &&selector);
+  static bool matches(const Selector &selector, const Element &element);
+  void addMatches(const Bucket *bucket, const Element &element,
+                  std::vector<Match> &matches) const;
+  template <typename MapTy>
+  static const Bucket *find(const MapTy &map, std::string_view key) {
+    auto it = map.find(key);
+    return it == map.end() ? nullptr : &it->second;
+  }
+
+  /// Declarations of each rule
+  std::vector<std::vector<Declaration>> Rules;
+  /// A deque, so the keys of the buckets can refer to the selectors' names
+  std::deque<Selector> Selectors;
+  std::unordered_map<std::string_view, Bucket> ById, ByClass, ByTag;
+  Bucket Universal;
+};
+} // namespace svg
+#endif // SVGUTILS_CSS_STYLESHEET_H
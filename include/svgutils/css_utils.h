@@ -1,15 +1,20 @@
 #ifndef SVGUTILS_CSS_UTILS_H
 #define SVGUTILS_CSS_UTILS_H
 
+#include <array>
 #include <cassert>
+#include <deque>
 #include <iostream>
-#include <list>
-#include <map>
+#include <memory>
+#include <optional>
+#include <string>
 #include <string_view>
+#include <variant>
 #include <vector>
 
 namespace svg {
 struct SVGAttribute;
+class CSSStylesheet;
 
 struct CSSColor {
   double r = 0.;
@@ -22,7 +27,7 @@ struct CSSColor {
   CSSColor &operator=(const CSSColor &) = default;
   CSSColor(CSSColor &&) = default;
   CSSColor &operator=(CSSColor &&) = default;
-  CSSColor(double r, double g, double b, double a = 1.)
+  constexpr CSSColor(double r, double g, double b, double a = 1.)
       : r(r), g(g), b(b), a(a) {}
 
   double &operator[](size_t idx) {
@@ -54,7 +59,11 @@ struct CSSColor {
     return os;
   }
 
+  /// Parse a named, hex, `rgb()`/`rgba()` or `hsl()`/`hsla()` color.
+  /// Invalid colors are black.
   static CSSColor parse(std::string_view str);
+  /// The color named @p name (case-insensitively), if there is one
+  static std::optional<CSSColor> fromName(std::string_view name);
 };
 
 struct CSSUnit {
@@ -104,14 +113,44 @@ struct CSSDashArray {
 
 enum class CSSTextAnchor { START, MIDDLE, END };
 
+/// Tracks the styles in effect while walking down an svg document.
+/// Writers `push` the attributes of every element they open and `pop` them
+/// when it's closed.
+///
+/// The current value of every property lives in a fixed array indexed by
+/// `Style`. Pushing an element records the previous value of each property
+/// it sets in an undo log, and popping restores them, so both only cost
+/// O(properties set by the element). Values are copied into a single
+/// buffer that is truncated again on pop, so no allocations are needed once
+/// the buffers have grown to the depth of the document.
+///
+/// Getters parse a value the first time it is asked for and keep the result
+/// until the value changes, so shapes sharing their parent's styles don't
+/// parse them again. The parsed value of the parent is restored on pop.
+///
+/// Siblings in maps and charts mostly carry the same styling attributes.
+/// The styles the last few children of an element resolved to are kept
+/// with everything they were resolved from (styling attributes, classes,
+/// tag, ...), and a sibling with the same ones reuses them, parsed values
+/// included, without matching stylesheet rules or parsing anything.
 class StyleTracker {
 public:
+  enum class Style {
+#define CSS_PROPERTY(NAME, STR) NAME,
+#include "svgutils/css_properties.def"
+    NUM_STYLES
+  };
+  static constexpr size_t NumStyles = static_cast<size_t>(Style::NUM_STYLES);
+
   StyleTracker();
-  StyleTracker(StyleTracker &&);
-  StyleTracker &operator=(StyleTracker &&);
-  ~StyleTracker();
+  StyleTracker(StyleTracker &&) = default;
+  StyleTracker &operator=(StyleTracker &&) = default;
+  ~StyleTracker() = default;
   using AttrContainer = std::vector<SVGAttribute>;
-  void push(const AttrContainer &attrs);
+  /// Apply the styles of an element with tag @p tag (if given). Presentation
+  /// attributes are overridden by matching stylesheet rules, which are
+  /// overridden by the `style` attribute.
+  void push(const AttrContainer &attrs, const char *tag = nullptr);
   void pop();
   CSSColor getColor() const;
   CSSColor getFill() const;
@@ -124,12 +163,128 @@ public:
   CSSTextAnchor getTextAnchor() const;
   CSSUnit getWidth() const;
 
-  struct StyleDiff;
-  enum class Style;
+  /// Set @p style to @p value until the next pop
+  void set(Style style, std::string_view value);
+  /// The style with the CSS property name @p name, if it is supported
+  static std::optional<Style> findStyle(std::string_view name);
+
+  /// Add the rules of the stylesheet @p css, e.g. the contents of a
+  /// `<style>` element. They apply to the elements pushed afterwards.
+  void addStylesheet(std::string_view css);
+  /// The rules added so far, nullptr if there are none
+  const CSSStylesheet *getStylesheet() const { return Sheet.get(); }
+  /// Use the rules of @p sheet, which may be shared with other trackers
+  /// (e.g. on other threads) as long as none of them adds rules.
+  void setStylesheet(std::shared_ptr<CSSStylesheet> sheet);
+
+  /// A tracker whose initial styles are the current ones of this tracker,
+  /// e.g. to resolve a subtree on another thread. The stylesheet is shared.
+  StyleTracker fork() const;
+
+  struct Statistics {
+    /// Number of calls to the typed getters
+    size_t lookups = 0;
+    /// Number of values the getters had to parse
+    size_t parses = 0;
+    /// Number of pushed elements that reused the styles of a sibling
+    size_t sharingHits = 0;
+    /// Number of pushed elements whose styles had to be resolved
+    size_t sharingMisses = 0;
+
+    Statistics &operator+=(const Statistics &other) {
+      lookups += other.lookups;
+      parses += other.parses;
+      sharingHits += other.sharingHits;
+      sharingMisses += other.sharingMisses;
+      return *this;
+    }
+    double getSharingHitRate() const {
+      size_t pushes = sharingHits + sharingMisses;
+      return pushes ? static_cast<double>(sharingHits) / pushes : 0.;
+    }
+
+    friend inline std::ostream &operator<<(std::ostream &os,
+                                           const Statistics &stats) {
+      os << "lookups: " << stats.lookups << ", parses: " << stats.parses
+         << ", sharing hits: " << stats.sharingHits
+         << ", sharing misses: " << stats.sharingMisses;
+      return os;
+    }
+  };
+  const Statistics &getStatistics() const { return stats; }
 
 private:
-  std::list<StyleDiff> Cascade; // std::list does not relocate
-  std::map<Style, std::string_view> CurrentStyle;
+  /// Location of a value in `Values`
+  struct ValueRef {
+    static constexpr size_t Unset = static_cast<size_t>(-1);
+    size_t offset = Unset;
+    size_t size = 0;
+  };
+  /// A value of `Values` as parsed by the getters
+  using Computed = std::variant<std::monostate, CSSColor, CSSUnit,
+                                CSSDashArray, CSSTextAnchor>;
+  struct UndoEntry {
+    Style style;
+    ValueRef previous;
+    Computed previousComputed;
+  };
+  /// The styles a recent child of an element set, for reuse by siblings
+  struct SharedStyle {
+    bool complete = false;
+    /// Serial of the parent's frame
+    uint64_t parentSerial = 0;
+    /// Everything the styles were resolved from, see `push`
+    std::string key;
+    /// The styles set, with their values in `values`
+    std::vector<std::pair<Style, ValueRef>> styles;
+    std::string values;
+    /// Parsed values, filled in when the element is popped
+    std::vector<Computed> computed;
+  };
+  static constexpr size_t SharingCacheSize = 4;
+  /// Shared styles of the children of the current element at some depth,
+  /// most recent first
+  using SharingSlots = std::array<SharedStyle, SharingCacheSize>;
+
+  /// Sizes of the undo log and the value buffer before each push
+  struct Frame {
+    size_t undoSize;
+    size_t valuesSize;
+    /// Identifies the pushed element, for sharing styles with its siblings
+    uint64_t serial;
+    /// The styles shared with siblings
+    SharedStyle *shared = nullptr;
+    /// Size of the undo log after the push
+    size_t pushedUndoSize = 0;
+  };
+
+  /// The current value of @p style, or nullopt if it isn't set at all
+  std::optional<std::string_view> get(Style style) const {
+    const ValueRef &ref = Current[static_cast<size_t>(style)];
+    if (ref.offset == ValueRef::Unset)
+      return std::nullopt;
+    return std::string_view(Values.data() + ref.offset, ref.size);
+  }
+  /// The current value of @p style parsed with @p parse, or nullptr if it
+  /// isn't set at all
+  template <typename T, typename ParseFn>
+  const T *getComputed(Style style, ParseFn parse) const;
+
+  std::array<ValueRef, NumStyles> Current;
+  /// Parsed values of `Current`, filled in lazily
+  mutable std::array<Computed, NumStyles> CurrentComputed;
+  std::vector<UndoEntry> UndoLog;
+  std::vector<Frame> Frames;
+  std::string Values;
+  mutable Statistics stats;
+  std::shared_ptr<CSSStylesheet> Sheet;
+  /// Specificity and index of the rules matching the pushed element
+  std::vector<std::pair<uint32_t, uint32_t>> Matches;
+  /// Everything the styles of the pushed element are resolved from
+  std::string Key;
+  uint64_t NextSerial = 0;
+  /// By depth. A deque, so frames can point to their entries.
+  std::deque<SharingSlots> SharingCache;
 };
 } // namespace svg
 #endif // SVGUTILS_CSS_UTILS_H
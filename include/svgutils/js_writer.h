@@ -3,8 +3,26 @@
 
 #include "svg_writer.h"
 
+#include <unordered_map>
+
 namespace svg {
 
+/// Write @p str as a JavaScript string literal that is safe to embed in a
+/// <script> element
+inline void writeJSString(outstream_t &os, std::string_view str) {
+  static constexpr char Hex[] = "0123456789abcdef";
+  os << '"';
+  for (unsigned char c : str) {
+    if (c == '"' || c == '\\')
+      os << '\\' << c;
+    else if (c < 0x20 || c == '<')
+      os << "\\x" << Hex[c >> 4] << Hex[c & 0xf];
+    else
+      os << c;
+  }
+  os << '"';
+}
+
 struct SVGJSWriter : public svg::SVGWriterBase<SVGJSWriter> {
   using self_t = SVGJSWriter;
   using base_t = svg::SVGWriterBase<self_t>;
@@ -96,5 +114,142 @@ private:
   size_t indentWidth = 2;
   size_t indent = 0;
 };
+
+/// Compact alternative to SVGJSWriter. Instead of code for every element, it
+/// writes the document as a table of opcodes and a table of strings (tag
+/// names, attribute names and values, text), which a small interpreter turns
+/// into elements. The elements are built inside a DocumentFragment and the
+/// top-level ones are pushed to the list named `CreatedTagsListName`, just
+/// like with SVGJSWriter. Unlike SVGJSWriter, attribute values are plain
+/// strings, not template strings.
+///
+/// Opcodes: TAG nameIdx attrCount (attrNameIdx valueIdx)*, ENTER, LEAVE,
+/// CONTENT textIdx. Every distinct string is only written once.
+struct SVGJSTableWriter : public svg::SVGWriterBase<SVGJSTableWriter> {
+  using self_t = SVGJSTableWriter;
+  using base_t = svg::SVGWriterBase<self_t>;
+  using RetTy = SVGWriterErrorOr<SVGJSTableWriter *>;
+  using outstream_t = svg::outstream_t;
+  enum Opcode { TAG = 0, ENTER = 1, LEAVE = 2, CONTENT = 3 };
+
+  SVGJSTableWriter(outstream_t &outstream,
+                   const char *CreatedTagsListName = "rootTags")
+      : base_t(outstream), rootTagsName(CreatedTagsListName) {}
+  RetTy enter() {
+    writeValue(ENTER);
+    return base_t::enter();
+  }
+  RetTy leave() {
+    writeValue(LEAVE);
+    return base_t::leave();
+  }
+  RetTy finish() {
+    // Nothing to do if nothing was written at all
+    if (!started)
+      return this;
+    output() << "],\n[";
+    for (size_t i = 0; i < strings.size(); ++i) {
+      if (i)
+        output() << ",";
+      writeJSString(output(), *strings[i]);
+    }
+    output() << "]);\n";
+    started = false;
+    stringIndices.clear();
+    strings.clear();
+    return this;
+  }
+  RetTy content(const char *text) {
+    writeValue(CONTENT);
+    writeValue(intern(text));
+    return this;
+  }
+  RetTy comment(const char *) { return this; }
+
+  /// The interpreter, defined once per page
+  static constexpr const char *Interpreter =
+      R"(if (typeof SVGWriterTable === 'undefined')
+  var SVGWriterTable = function(roots, ops, strs) {
+    var ns = 'http://www.w3.org/2000/svg', doc = document;
+    var frag = doc.createDocumentFragment();
+    var parents = [frag], parent = frag, cur = null;
+    for (var i = 0; i < ops.length;) {
+      switch (ops[i++]) {
+      case 0:
+        cur = doc.createElementNS(ns, strs[ops[i++]]);
+        for (var n = ops[i++]; n > 0; --n, i += 2)
+          cur.setAttributeNS(null, strs[ops[i]], strs[ops[i + 1]]);
+        parent.appendChild(cur);
+        break;
+      case 1:
+        parents.push(parent = cur);
+        break;
+      case 2:
+        parents.pop();
+        parent = parents[parents.length - 1];
+        break;
+      case 3:
+        if (parent === frag)
+          frag.appendChild(doc.createTextNode(strs[ops[i++]]));
+        else
+          parent.insertAdjacentHTML('beforeend', strs[ops[i++]]);
+        break;
+      }
+    }
+    for (var c = frag.firstChild; c; c = c.nextSibling)
+      roots.push(c);
+    return frag;
+  };
+)";
+
+private:
+  friend base_t;
+  template <typename container_t>
+  void openTag(const char *tagname, const container_t &attrs) {
+    writeValue(TAG);
+    writeValue(intern(tagname));
+    size_t count = 0;
+    for (const svg::SVGAttribute &attr : attrs)
+      count += attr.getName() != svg::xmlns().getName();
+    writeValue(count);
+    for (const svg::SVGAttribute &attr : attrs) {
+      if (attr.getName() == svg::xmlns().getName())
+        continue;
+      writeValue(intern(attr.getName()));
+      writeValue(intern(attr.getValueStr()));
+    }
+    currentTag = tagname;
+  }
+  void closeTag() { currentTag = nullptr; }
+  outstream_t &output() { return this->base_t::output(); }
+
+  size_t intern(std::string str) {
+    auto it = stringIndices.emplace(std::move(str), strings.size()).first;
+    if (it->second == strings.size())
+      strings.push_back(&it->first);
+    return it->second;
+  }
+  void writeValue(size_t value) {
+    if (!started) {
+      output() << Interpreter << "SVGWriterTable(" << rootTagsName << ",\n[";
+      started = true;
+      valuesInLine = 0;
+    } else if (valuesInLine == ValuesPerLine) {
+      output() << ",\n";
+      valuesInLine = 0;
+    } else
+      output() << ",";
+    output() << value;
+    ++valuesInLine;
+  }
+  static constexpr size_t ValuesPerLine = 64;
+  const char *rootTagsName;
+  /// True once the interpreter call has been started
+  bool started = false;
+  size_t valuesInLine = 0;
+  std::unordered_map<std::string, size_t> stringIndices;
+  /// Strings in the order of their indices
+  std::vector<const std::string *> strings;
+};
 } // namespace svg
 #endif // SVGUTILS_JSWRITER_H
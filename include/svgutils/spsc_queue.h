@@ -0,0 +1,116 @@
+#ifndef SVGUTILS_SPSC_QUEUE_H
+#define SVGUTILS_SPSC_QUEUE_H
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <thread>
+
+namespace svg {
+/// What blocking SPSCQueue calls do while the queue is full (producer) or
+/// empty (consumer).
+enum class SPSCBackpressure {
+  SPIN,  ///< Busy-wait. Lowest latency, but burns a core.
+  YIELD, ///< Yield the cpu to other threads between retries.
+  SLEEP  ///< Sleep for `sleepTime` between retries.
+};
+
+/// Waits between two retries of a blocking SPSCQueue call.
+struct SPSCWait {
+  SPSCBackpressure backpressure = SPSCBackpressure::YIELD;
+  std::chrono::microseconds sleepTime{50};
+
+  void operator()() const {
+    switch (backpressure) {
+    case SPSCBackpressure::SPIN:
+      break;
+    case SPSCBackpressure::YIELD:
+      std::this_thread::yield();
+      break;
+    case SPSCBackpressure::SLEEP:
+      std::this_thread::sleep_for(sleepTime);
+      break;
+    }
+  }
+};
+
+/// Bounded, lock-free queue for exactly one producer and one consumer
+/// thread.
+/// The capacity is rounded up to the next power of two so that slot indices
+/// can be computed with a mask. Producer and consumer positions live on
+/// separate cache lines to avoid false sharing.
+template <typename T> class SPSCQueue {
+public:
+  explicit SPSCQueue(size_t minCapacity) {
+    size_t capacity = 2;
+    while (capacity < minCapacity)
+      capacity <<= 1;
+    mask = capacity - 1;
+    slots = std::make_unique<T[]>(capacity);
+  }
+  SPSCQueue(const SPSCQueue &) = delete;
+  SPSCQueue &operator=(const SPSCQueue &) = delete;
+
+  /// Producer side. Leaves @p val untouched and returns false if the queue
+  /// is full.
+  bool tryPush(T &&val) {
+    const size_t t = tail.load(std::memory_order_relaxed);
+    if (t - headCache > mask) {
+      headCache = head.load(std::memory_order_acquire);
+      if (t - headCache > mask)
+        return false;
+    }
+    slots[t & mask] = std::move(val);
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+  }
+  /// Producer side. Retries after @p wait while the queue is full.
+  void push(T val, const SPSCWait &wait = SPSCWait()) {
+    while (!tryPush(std::move(val)))
+      wait();
+  }
+
+  /// Consumer side. Returns false if the queue is empty.
+  bool tryPop(/* out */ T &val) {
+    const size_t h = head.load(std::memory_order_relaxed);
+    if (h == tailCache) {
+      tailCache = tail.load(std::memory_order_acquire);
+      if (h == tailCache)
+        return false;
+    }
+    val = std::move(slots[h & mask]);
+    head.store(h + 1, std::memory_order_release);
+    return true;
+  }
+  /// Consumer side. Retries after @p wait while the queue is empty.
+  T pop(const SPSCWait &wait = SPSCWait()) {
+    T val;
+    while (!tryPop(val))
+      wait();
+    return val;
+  }
+
+  size_t capacity() const { return mask + 1; }
+  /// Approximate number of queued elements. Exact only if called while
+  /// neither side is active.
+  size_t size() const {
+    return tail.load(std::memory_order_acquire) -
+           head.load(std::memory_order_acquire);
+  }
+
+private:
+  static constexpr size_t CacheLineSize = 64;
+
+  std::unique_ptr<T[]> slots;
+  size_t mask;
+  /// Consumer-owned
+  alignas(CacheLineSize) std::atomic<size_t> head{0};
+  size_t tailCache = 0;
+  /// Producer-owned
+  alignas(CacheLineSize) std::atomic<size_t> tail{0};
+  size_t headCache = 0;
+};
+} // namespace svg
+#endif // SVGUTILS_SPSC_QUEUE_H
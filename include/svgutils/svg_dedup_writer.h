@@ -0,0 +1,195 @@
+#ifndef SVGUTILS_SVG_DEDUP_WRITER_H
+#define SVGUTILS_SVG_DEDUP_WRITER_H
+
+#include "svgutils/svg_event.h"
+#include "svgutils/svg_reader_writer.h"
+
+#include <deque>
+#include <map>
+#include <unordered_map>
+
+namespace svg {
+/// Writer stage that replaces repeated subtrees with `<use>` elements.
+/// Every completed subtree is hashed bottom-up from its tag, attributes and
+/// the hashes of its children. When a hash repeats (and the subtrees really
+/// are equal), the subtree is added to a `<defs>` element written at the end
+/// of the root element, and the repeat is replaced by a `<use>` referencing
+/// it. If the first instance is still buffered, it is replaced as well.
+/// The transform of the root element of a subtree is not part of the
+/// definition but kept on the `<use>`, so copies at different positions are
+/// shared as well.
+///
+/// Memory is bounded: Only the most recent `bufferSize` events are held back
+/// (older ones are forwarded and can't be replaced anymore) and candidate
+/// subtrees are kept up to `candidateBudget` events in total, evicting the
+/// oldest.
+///
+/// Only graphics elements in plain containers (svg, g, a) are replaced, and
+/// only if their subtree has no id or class, which a `<use>` copy wouldn't
+/// preserve. References are written as `xlink:href`, which SVG 1.1 and 2
+/// consumers both understand. Its namespace is declared on the root element
+/// if a `<use>` is known by the time the root is forwarded, otherwise on
+/// every `<use>`. Documents without any `<use>` stay as they are.
+class SVGDedupWriter : public virtual WriterConcept {
+public:
+  struct Options {
+    /// Number of events held back before forwarding them
+    size_t bufferSize = 16384;
+    /// Number of events of candidate subtrees kept for comparison
+    size_t candidateBudget = 65536;
+    /// Larger subtrees are not deduplicated
+    size_t maxSubtreeEvents = 4096;
+    /// Subtrees with less text in their attributes and contents are not
+    /// worth replacing with a `<use>`
+    size_t minSubtreeBytes = 32;
+    /// Prefix of generated ids. Must not clash with ids of the document.
+    std::string idPrefix = "dedup";
+  };
+  struct Statistics {
+    /// Number of subtrees considered for deduplication
+    size_t subtrees = 0;
+    /// Number of subtrees kept for comparison
+    size_t candidates = 0;
+    /// Number of candidates evicted to stay within the budget
+    size_t evictions = 0;
+    /// Number of subtrees moved to `<defs>`
+    size_t defs = 0;
+    /// Number of subtrees replaced by `<use>`
+    size_t uses = 0;
+
+    friend inline outstream_t &operator<<(outstream_t &os,
+                                          const Statistics &stats) {
+      os << "subtrees: " << stats.subtrees
+         << ", candidates: " << stats.candidates
+         << ", evictions: " << stats.evictions << ", defs: " << stats.defs
+         << ", uses: " << stats.uses;
+      return os;
+    }
+  };
+
+  explicit SVGDedupWriter(WriterConcept &writer)
+      : SVGDedupWriter(writer, Options()) {}
+  SVGDedupWriter(WriterConcept &writer, const Options &options)
+      : writer(writer), options(options) {}
+  SVGDedupWriter(const SVGDedupWriter &) = delete;
+  SVGDedupWriter &operator=(const SVGDedupWriter &) = delete;
+
+  const Options &getOptions() const { return options; }
+  const Statistics &getStatistics() const { return stats; }
+
+#define SVG_TAG(NAME, STR, ...)                                                \
+  RetTy NAME(const std::vector<SVGAttribute> &attrs) override {                \
+    return addTag(SVGEvent(SVGEvent::TagType::NAME, attrs));                   \
+  }
+#include "svgutils/svg_entities.def"
+  RetTy custom_tag(const char *tag,
+                   const std::vector<SVGAttribute> &attrs) override {
+    return addTag(SVGEvent(tag, attrs));
+  }
+  RetTy enter() override;
+  RetTy leave() override;
+  RetTy content(const char *text) override {
+    return addText(SVGEvent(SVGEvent::Kind::CONTENT, text));
+  }
+  RetTy comment(const char *text) override {
+    return addText(SVGEvent(SVGEvent::Kind::COMMENT, text));
+  }
+  RetTy finish() override;
+
+private:
+  using TagType = SVGEvent::TagType;
+  /// Events are addressed by their position in the whole event stream
+  using Position = uint64_t;
+
+  /// An element whose subtree isn't complete yet
+  struct Node {
+    Position start;
+    uint64_t hash;
+    size_t bytes;
+    TagType tag;
+    /// The subtree has no ids, classes or custom tags
+    bool eligible;
+    /// All ancestors are plain containers
+    bool inPlainContainers;
+  };
+  struct Candidate {
+    std::vector<SVGEvent> events;
+    /// Position of the first instance
+    Position start;
+    /// Id of the definition, empty while the subtree wasn't repeated
+    std::string id;
+    /// Number of `<use>` elements referring to the definition
+    size_t uses = 0;
+  };
+  /// A buffered subtree that is replaced by a `<use>`
+  struct Replacement {
+    Position end;
+    /// Hash of the candidate to refer to
+    uint64_t hash;
+    /// Transform of the replaced element, moved to the `<use>`
+    std::string transform;
+  };
+
+  RetTy addTag(SVGEvent &&event);
+  RetTy addText(SVGEvent &&event);
+  /// Completes the last element if it turned out to have no children
+  void completePending();
+  void complete(const Node &node);
+  void addChild(uint64_t hash, size_t bytes, bool eligible);
+  void addCandidate(uint64_t hash, Position start);
+  /// Replace the buffered events in [@p start, @p end) by a `<use>`
+  void replace(Position start, Position end, uint64_t hash);
+  void push(SVGEvent &&event);
+  void pushDefs();
+  /// Forward all buffered events before @p target
+  void flush(Position target);
+  void forward(const SVGEvent &event);
+  RetTy status() const {
+    if (error)
+      return *error;
+    return {};
+  }
+
+  WriterConcept &writer;
+  Options options;
+  Statistics stats;
+  std::optional<SVGWriterError> error;
+
+  std::deque<SVGEvent> buffer;
+  /// Position of buffer.front()
+  Position base = 0;
+  std::vector<Node> parents;
+  /// Position of the root element while it is buffered
+  std::optional<Position> root;
+  /// The xlink namespace is declared for all elements still to come
+  bool xlinkDeclared = false;
+  /// The last element, until it is known whether it has children
+  std::optional<Node> pending;
+  std::map<Position, Replacement> replacements;
+
+  std::unordered_map<uint64_t, Candidate> candidates;
+  /// Hashes of candidates in insertion order, for eviction
+  std::deque<uint64_t> candidateOrder;
+  size_t candidateEvents = 0;
+  /// Hashes of repeated subtrees in order of their first repeat
+  std::vector<uint64_t> definitions;
+};
+
+/// Like SVGReaderWriter, but repeated subtrees are replaced by `<use>`
+/// before they reach the writer.
+template <typename WriterTy>
+struct SVGDedupReaderWriter : public SVGReaderWriterBase {
+  using base_t = SVGReaderWriterBase;
+  template <typename... args_t>
+  SVGDedupReaderWriter(args_t &&... args)
+      : base_t(dedup), writer(std::forward<args_t>(args)...), dedup(writer) {}
+
+  WriterTy &getWriter() { return writer.getWriter(); }
+  SVGDedupWriter &getDedup() { return dedup; }
+
+private:
+  WriterModel<WriterTy> writer;
+  SVGDedupWriter dedup;
+};
+} // namespace svg
+#endif // SVGUTILS_SVG_DEDUP_WRITER_H
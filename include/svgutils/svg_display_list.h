@@ -0,0 +1,243 @@
+#ifndef SVGUTILS_SVG_DISPLAY_LIST_H
+#define SVGUTILS_SVG_DISPLAY_LIST_H
+
+#include "svgutils/css_utils.h"
+#include "svgutils/svg_path_data.h"
+#include "svgutils/svg_viewport.h"
+#include "svgutils/svg_writer.h"
+
+#include <stack>
+#include <unordered_map>
+
+namespace svg {
+/// The drawing operations of a document with styles resolved and geometry
+/// parsed, so it can be drawn any number of times (at different scales, to
+/// different backends) without parsing the document again.
+///
+/// Everything is stored in a few flat arrays: one item per shape or text
+/// run, the verbs and coordinates of all paths back to back (in the layout
+/// of PathData) and a table of the distinct paints. Lengths are in px, with
+/// percentages resolved against the document size. Text is kept as runs of
+/// characters, since glyphs depend on the fonts of the backend.
+///
+/// Every item has the bounds of the area it may paint on, so renderers can
+/// skip items outside of the visible area. Groups are items as well, which
+/// are followed by their contents and have the union of their bounds, so
+/// whole subtrees can be skipped at once.
+class SVGDisplayList {
+public:
+  /// How a shape is painted. Like in CairoSVGWriter, shapes are stroked
+  /// first and filled afterwards. Transparent colors are not painted.
+  struct Paint {
+    CSSColor fill;
+    CSSColor stroke;
+    double strokeWidth = 0.;
+    /// Range of the dash lengths in getDashes()
+    uint32_t firstDash = 0;
+    uint32_t numDashes = 0;
+
+    bool hasFill() const { return static_cast<bool>(fill); }
+    bool hasStroke() const { return strokeWidth != 0. && stroke; }
+  };
+  struct TextRun {
+    std::string text;
+    std::string fontFamily;
+    double fontSize;
+    CSSTextAnchor anchor;
+    /// Where the text starts, unless it continues the previous run
+    double x, y;
+    /// Whether the text starts at the end of the previous run, e.g. after
+    /// a comment in the middle of a `<text>` element
+    bool continues;
+  };
+  enum class Kind : uint8_t { PATH, TEXT, GROUP };
+  struct Item {
+    Kind kind;
+    /// Index of the paint in getPaints()
+    uint32_t paint;
+    /// PATH: Index of the first verb in getVerbs(). TEXT: Index of the run
+    /// in getTextRuns(). GROUP: Number of items in the group, which follow
+    /// it.
+    uint32_t first;
+    /// Number of verbs of a path
+    uint32_t numVerbs;
+    /// Index of the first coordinate of a path in getCoords()
+    uint32_t firstCoord;
+    /// Area the item may paint on, strokes included
+    PathData::Bounds bounds;
+  };
+
+  /// How far the outline of a stroke of width 1 may be from its path, at
+  /// the sharpest join Cairo's default miter limit of 10 allows
+  static constexpr double MaxMiterExtent = 5.;
+  /// @p bounds of a path grown by the area its stroke of @p strokeWidth
+  /// covers. Paths without corners (@p joins) only grow by half the width.
+  static PathData::Bounds getStrokeBounds(const PathData::Bounds &bounds,
+                                          double strokeWidth, bool joins) {
+    return bounds.inflate(strokeWidth * (joins ? MaxMiterExtent : .5));
+  }
+  /// Area text of @p length bytes starting at (@p x, @p y) may cover with
+  /// any anchor, stroked with @p strokeWidth. The glyphs are only known to
+  /// the backend, so this assumes that no glyph is wider or taller than
+  /// twice the font size.
+  static PathData::Bounds getTextBounds(double x, double y, size_t length,
+                                        double fontSize, double strokeWidth);
+
+  double getWidth() const { return width; }
+  double getHeight() const { return height; }
+  const std::vector<Item> &getItems() const { return items; }
+  const std::vector<Paint> &getPaints() const { return paints; }
+  const std::vector<double> &getDashes() const { return dashes; }
+  const std::vector<PathData::Verb> &getVerbs() const { return verbs; }
+  const std::vector<double> &getCoords() const { return coords; }
+  const std::vector<TextRun> &getTextRuns() const { return textRuns; }
+  /// Number of bytes used by the arrays
+  size_t getMemoryUsage() const;
+
+  /// Call the methods of PathData::visit on @p visitor for the segments
+  /// of the path @p item
+  template <typename VisitorTy>
+  void visitPath(const Item &item, VisitorTy &visitor) const {
+    using Verb = PathData::Verb;
+    const double *c = coords.data() + item.firstCoord;
+    const Verb *verb = verbs.data() + item.first;
+    for (const Verb *end = verb + item.numVerbs; verb != end; ++verb) {
+      switch (*verb) {
+      case Verb::MOVE:
+        visitor.moveTo(c[0], c[1]);
+        break;
+      case Verb::LINE:
+        visitor.lineTo(c[0], c[1]);
+        break;
+      case Verb::CUBIC:
+        visitor.cubicTo(c[0], c[1], c[2], c[3], c[4], c[5]);
+        break;
+      case Verb::CLOSE:
+        visitor.close();
+        break;
+      }
+      c += PathData::numCoords(*verb);
+    }
+  }
+
+private:
+  friend class SVGDisplayListBuilder;
+
+  double width = 300.;
+  double height = 200.;
+  std::vector<Item> items;
+  std::vector<Paint> paints;
+  std::vector<double> dashes;
+  std::vector<PathData::Verb> verbs;
+  std::vector<double> coords;
+  std::vector<TextRun> textRuns;
+};
+
+/// Grid of square cells over the document of a display list, listing the
+/// path and text items whose bounds touch each cell. Finds the items to draw
+/// for a small part of a large document (e.g. a map tile) without testing
+/// every item. Items beyond the document are listed in the cells at its
+/// edges.
+class SVGDisplayListIndex {
+public:
+  SVGDisplayListIndex(const SVGDisplayList &list, double cellSize);
+
+  /// Indices of the path and text items whose bounds intersect @p area, in
+  /// the order they are drawn
+  std::vector<uint32_t> query(const PathData::Bounds &area) const;
+  /// Number of path and text items in the display list
+  size_t getNumItems() const { return numItems; }
+  double getCellSize() const { return cellSize; }
+  /// Number of bytes used by the grid
+  size_t getMemoryUsage() const;
+
+private:
+  /// First and last cell covering @p v0 to @p v1 out of @p cells
+  std::pair<size_t, size_t> getCellRange(double v0, double v1,
+                                         size_t cells) const;
+
+  const SVGDisplayList &list;
+  double cellSize;
+  size_t columns, rows;
+  size_t numItems = 0;
+  /// The items of cell i are cellItems[cellStarts[i]] up to
+  /// cellItems[cellStarts[i + 1]], in drawing order
+  std::vector<uint32_t> cellStarts;
+  std::vector<uint32_t> cellItems;
+};
+
+/// Writer recording a document into an SVGDisplayList, e.g. with
+/// SVGReaderWriterBase. Styles are resolved with StyleTracker while
+/// writing, and the same elements as in CairoSVGWriter (plus ellipse) are
+/// recorded. The contents of elements that don't render directly (e.g. defs
+/// or clipPath) and of custom tags are ignored.
+class SVGDisplayListBuilder : public virtual WriterConcept {
+public:
+  SVGDisplayList &getDisplayList() { return list; }
+  /// Document size if the first `<svg>` element doesn't set it
+  void setDefaultSize(double w, double h) {
+    list.width = w;
+    list.height = h;
+    viewport = {w, h, {}, w, h};
+  }
+  const StyleTracker::Statistics &getStyleStatistics() const {
+    return styles.getStatistics();
+  }
+
+#define SVG_TAG(NAME, STR, ...)                                                \
+  RetTy NAME(const std::vector<SVGAttribute> &attrs) override {                \
+    return openTag(STR, attrs);                                                \
+  }
+#include "svgutils/svg_entities.def"
+  RetTy custom_tag(const char *tag,
+                   const std::vector<SVGAttribute> &attrs) override;
+  RetTy enter() override;
+  RetTy leave() override;
+  RetTy content(const char *text) override;
+  RetTy comment(const char *) override { return {}; }
+  RetTy finish() override;
+
+private:
+  RetTy openTag(const char *tag, const std::vector<SVGAttribute> &attrs);
+  void closeTag();
+
+  void readDimensions(const std::vector<SVGAttribute> &attrs);
+  void addRect(const std::vector<SVGAttribute> &attrs);
+  void addEllipse(const std::vector<SVGAttribute> &attrs, bool circle);
+  void addLine(const std::vector<SVGAttribute> &attrs);
+  /// Add @p path painted with the current styles, without filling it
+  /// unless @p fill is set. Whether the path has corners (@p joins)
+  /// determines how far its stroke reaches.
+  void addPath(PathData path, bool fill = true, bool joins = true);
+  /// Append @p item and add its bounds to the enclosing group
+  void addItem(const SVGDisplayList::Item &item);
+  /// Index of the paint of the current styles
+  uint32_t getPaint(bool fill);
+  /// sqrt((width^2 + height^2) / 2) of the user space, the reference for
+  /// percentages in stroke widths and dashes
+  double getDiagonal() const;
+
+  SVGDisplayList list;
+  StyleTracker styles;
+  /// Name of the open element, nullptr if there is none
+  const char *currentTag = nullptr;
+  std::stack<const char *> parents;
+  /// Depth of ignored elements entered, like in CairoSVGWriter
+  size_t ignore = 0;
+  bool sizeRead = false;
+  /// Maps the user space of the document onto the recorded px. The default
+  /// size until the root element is read.
+  SVGViewport viewport{300., 200., {}, 300., 200.};
+  /// Position of the current text element
+  double textX = 0., textY = 0.;
+  /// Whether the current text element already has a run
+  bool textStarted = false;
+  /// Bytes of text in the runs of the current text element so far
+  size_t textLength = 0;
+  /// Open groups with the depth of their element
+  std::stack<std::pair<uint32_t, size_t>> groups;
+  /// Index of every paint by its components
+  std::unordered_map<std::string, uint32_t> paintIndices;
+};
+} // namespace svg
+#endif // SVGUTILS_SVG_DISPLAY_LIST_H
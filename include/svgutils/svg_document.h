@@ -0,0 +1,110 @@
+#ifndef SVGUTILS_SVG_DOCUMENT_H
+#define SVGUTILS_SVG_DOCUMENT_H
+
+#include "svgutils/svg_event.h"
+
+namespace svg {
+/// A node of an in-memory svg document: an element, text or a comment.
+/// All strings are owned by the node, so nodes can be modified, moved
+/// around and processed on any thread.
+struct SVGNode {
+  enum class Kind { DOCUMENT, ELEMENT, CONTENT, COMMENT };
+  using TagType = SVGEvent::TagType;
+  using Attr = std::pair<std::string, std::string>;
+
+  explicit SVGNode(Kind kind) : kind(kind) {}
+  SVGNode(TagType tag, std::string name, const std::vector<SVGAttribute> &attrs)
+      : kind(Kind::ELEMENT), tag(tag), name(std::move(name)) {
+    this->attrs.reserve(attrs.size());
+    for (const SVGAttribute &attr : attrs)
+      this->attrs.emplace_back(attr.getName(), attr.getValueStr());
+  }
+  SVGNode(Kind kind, std::string text) : kind(kind), name(std::move(text)) {}
+  SVGNode(const SVGNode &) = delete;
+  SVGNode &operator=(const SVGNode &) = delete;
+
+  bool isElement() const { return kind == Kind::ELEMENT; }
+  bool is(TagType tag) const { return isElement() && this->tag == tag; }
+
+  /// Returns nullptr if the attribute isn't set
+  const std::string *getAttr(std::string_view name) const;
+  void setAttr(std::string_view name, std::string value);
+  /// Returns true if the attribute was set
+  bool removeAttr(std::string_view name);
+
+  SVGNode &appendChild(std::unique_ptr<SVGNode> child) {
+    child->parent = this;
+    return *children.emplace_back(std::move(child));
+  }
+  /// Number of elements in this subtree, including this node
+  size_t countElements() const;
+
+  Kind kind;
+  /// Type of elements. Elements with a custom tag have type NONE.
+  TagType tag = TagType::NONE;
+  /// The tag name of elements, the text of content and comments
+  std::string name;
+  std::vector<Attr> attrs;
+  std::vector<std::unique_ptr<SVGNode>> children;
+  SVGNode *parent = nullptr;
+};
+
+/// A complete svg document in memory. Built from writer calls by
+/// SVGDocumentBuilder (e.g. while parsing) and written to any writer.
+class SVGDocument {
+public:
+  SVGDocument() : root(std::make_unique<SVGNode>(SVGNode::Kind::DOCUMENT)) {}
+
+  /// The document node. Its children are the top-level nodes, usually a
+  /// single svg element.
+  SVGNode &getRoot() { return *root; }
+  const SVGNode &getRoot() const { return *root; }
+  size_t countElements() const { return root->countElements(); }
+
+  /// Issue the calls for the whole document on @p writer, including finish.
+  SVGWriterErrorOr<void> write(WriterConcept &writer) const;
+
+private:
+  std::unique_ptr<SVGNode> root;
+};
+
+/// Writer that records all calls as an SVGDocument.
+class SVGDocumentBuilder : public virtual WriterConcept {
+public:
+  SVGDocumentBuilder() : current(&document.getRoot()) {}
+
+  SVGDocument &getDocument() { return document; }
+
+#define SVG_TAG(NAME, STR, ...)                                                \
+  RetTy NAME(const std::vector<SVGAttribute> &attrs) override {                \
+    return add(std::make_unique<SVGNode>(SVGNode::TagType::NAME, STR, attrs)); \
+  }
+#include "svgutils/svg_entities.def"
+  RetTy custom_tag(const char *tag,
+                   const std::vector<SVGAttribute> &attrs) override {
+    return add(std::make_unique<SVGNode>(SVGNode::TagType::NONE, tag, attrs));
+  }
+  RetTy enter() override;
+  RetTy leave() override;
+  RetTy content(const char *text) override {
+    return add(std::make_unique<SVGNode>(SVGNode::Kind::CONTENT, text));
+  }
+  RetTy comment(const char *text) override {
+    return add(std::make_unique<SVGNode>(SVGNode::Kind::COMMENT, text));
+  }
+  RetTy finish() override { return {}; }
+
+private:
+  RetTy add(std::unique_ptr<SVGNode> node) {
+    last = &current->appendChild(std::move(node));
+    return {};
+  }
+
+  SVGDocument document;
+  /// Node new nodes are appended to
+  SVGNode *current;
+  /// The most recently added node, i.e. the one enter() descends into
+  SVGNode *last = nullptr;
+};
+} // namespace svg
+#endif // SVGUTILS_SVG_DOCUMENT_H
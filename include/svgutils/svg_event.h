@@ -0,0 +1,97 @@
+#ifndef SVGUTILS_SVG_EVENT_H
+#define SVGUTILS_SVG_EVENT_H
+
+#include "svgutils/svg_writer.h"
+
+namespace svg {
+/// A self-contained copy of a single writer call (a tag, enter, leave,
+/// content, comment or finish).
+/// All strings the call refers to (custom attribute names, string attribute
+/// values, text) are copied into storage owned by the event, so events can
+/// outlive the buffers of whoever produced them and be handed over to other
+/// threads. Names of attributes from svg_entities.def are not copied to keep
+/// their identity intact. Custom tag names are not copied either: Writers
+/// refer to tag names until the tag is closed, so they already have to
+/// outlive the call.
+class SVGEvent {
+public:
+  enum class Kind { TAG, CUSTOM_TAG, ENTER, LEAVE, CONTENT, COMMENT, FINISH };
+  enum class TagType {
+    NONE = 0,
+#define SVG_TAG(NAME, STR, ...) NAME,
+#include "svg_entities.def"
+  };
+
+  /// ENTER, LEAVE or FINISH
+  explicit SVGEvent(Kind kind);
+  /// CONTENT or COMMENT
+  SVGEvent(Kind kind, const char *text);
+  SVGEvent(TagType tag, const std::vector<SVGAttribute> &attrs);
+  SVGEvent(const char *customTag, const std::vector<SVGAttribute> &attrs);
+  SVGEvent() = default;
+  SVGEvent(SVGEvent &&) = default;
+  SVGEvent &operator=(SVGEvent &&) = default;
+  SVGEvent(const SVGEvent &) = delete;
+  SVGEvent &operator=(const SVGEvent &) = delete;
+
+  Kind getKind() const { return kind; }
+  TagType getTagType() const { return tag; }
+  /// The tag name of CUSTOM_TAG events
+  const char *getTagName() const { return text; }
+  /// The text of CONTENT and COMMENT events
+  const char *getText() const { return text; }
+  const std::vector<SVGAttribute> &getAttrs() const { return attrs; }
+
+  /// Issue the recorded call on @p writer. Works with both WriterConcept and
+  /// concrete writer types.
+  template <typename WriterTy>
+  SVGWriterErrorOr<void> replay(WriterTy &writer) const {
+    switch (kind) {
+    case Kind::TAG:
+      switch (tag) {
+#define SVG_TAG(NAME, STR, ...)                                                \
+  case TagType::NAME:                                                          \
+    return discardValue(writer.NAME(attrs));
+#include "svg_entities.def"
+      case TagType::NONE:
+        break;
+      }
+      svg_unreachable("Tag event without tag type");
+    case Kind::CUSTOM_TAG:
+      return discardValue(writer.custom_tag(text, attrs));
+    case Kind::ENTER:
+      return discardValue(writer.enter());
+    case Kind::LEAVE:
+      return discardValue(writer.leave());
+    case Kind::CONTENT:
+      return discardValue(writer.content(text));
+    case Kind::COMMENT:
+      return discardValue(writer.comment(text));
+    case Kind::FINISH:
+      return discardValue(writer.finish());
+    }
+    svg_unreachable("Unknown event kind");
+  }
+
+private:
+  SVGEvent(Kind kind, TagType tag, const char *text,
+           const std::vector<SVGAttribute> &attrs);
+
+  static SVGWriterErrorOr<void> discardValue(SVGWriterErrorOr<void> res) {
+    return res;
+  }
+  template <typename T>
+  static SVGWriterErrorOr<void> discardValue(const SVGWriterErrorOr<T> &res) {
+    return res.without_value();
+  }
+
+  Kind kind = Kind::FINISH;
+  TagType tag = TagType::NONE;
+  const char *text = nullptr;
+  std::vector<SVGAttribute> attrs;
+  /// Backing storage for all copied strings. Pointers into it stay valid
+  /// when the event is moved.
+  std::unique_ptr<char[]> strings;
+};
+} // namespace svg
+#endif // SVGUTILS_SVG_EVENT_H
@@ -55,6 +55,11 @@ private:
   }
 
   friend base_t;
+  self_t forkWriter(outstream_t &os) const {
+    self_t fragment(os, indentChar, indentWidth);
+    fragment.indent = indent;
+    return fragment;
+  }
   template <typename container_t>
   void openTag(const char *tagname, container_t attrs) {
     closeTag();
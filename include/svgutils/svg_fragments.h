@@ -0,0 +1,33 @@
+#ifndef SVGUTILS_SVG_FRAGMENTS_H
+#define SVGUTILS_SVG_FRAGMENTS_H
+
+#include "svgutils/svg_writer.h"
+#include "svgutils/utils.h"
+
+#include <thread>
+
+namespace svg {
+/// Generate @p count independent subtrees on up to @p numThreads threads and
+/// splice them into @p writer in index order. The output is the same as
+/// calling `generate(i, writer)` for i = 0, ..., count - 1 on @p writer
+/// itself. @p generate receives the index and a fragment writer and must not
+/// touch any writer other than the one it was given.
+template <typename WriterTy, typename FnTy>
+SVGWriterErrorOr<void>
+generateFragments(WriterTy &writer, size_t count, FnTy &&generate,
+                  unsigned numThreads = std::thread::hardware_concurrency()) {
+  std::vector<SVGFragment<WriterTy>> fragments;
+  fragments.reserve(count);
+  for (size_t i = 0; i < count; ++i)
+    fragments.push_back(writer.fork());
+
+  parallelFor(count, numThreads,
+              [&](size_t i) { generate(i, fragments[i].getWriter()); });
+
+  for (SVGFragment<WriterTy> &fragment : fragments)
+    if (auto res = writer.splice(fragment))
+      return res.without_value();
+  return {};
+}
+} // namespace svg
+#endif // SVGUTILS_SVG_FRAGMENTS_H
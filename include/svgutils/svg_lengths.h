@@ -0,0 +1,26 @@
+#ifndef SVGUTILS_SVG_LENGTHS_H
+#define SVGUTILS_SVG_LENGTHS_H
+
+#include "svgutils/css_utils.h"
+#include "svgutils/svg_writer.h"
+
+namespace svg {
+/// Elements whose children are rendered. The contents of all others (e.g.
+/// defs, clipPath, custom tags) are ignored.
+bool rendersChildren(const char *tagname);
+/// The attribute called @p name in @p attrs, nullptr if there is none
+const SVGAttribute *findAttr(const std::vector<SVGAttribute> &attrs,
+                             const char *name);
+/// Utility function to extract a CSS unit from the value of an
+/// SVGAttribute
+CSSUnit CSSUnitFrom(const SVGAttribute &attr);
+/// @p unit in px at 90dpi. Percentages refer to @p reference.
+double toPixels(const CSSUnit &unit, double reference);
+/// The length attribute @p name in px, 0 if it is missing
+double getLength(const std::vector<SVGAttribute> &attrs, const char *name,
+                 double reference);
+/// sqrt((width^2 + height^2) / 2), what percentages of lengths that are
+/// neither horizontal nor vertical (e.g. stroke-width) refer to
+double getDiagonal(double width, double height);
+} // namespace svg
+#endif // SVGUTILS_SVG_LENGTHS_H
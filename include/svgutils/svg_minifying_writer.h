@@ -0,0 +1,90 @@
+#ifndef SVGUTILS_SVG_MINIFYING_WRITER_H
+#define SVGUTILS_SVG_MINIFYING_WRITER_H
+
+#include "svgutils/svg_writer.h"
+
+namespace svg {
+/// SVG document writer that produces output as small as possible in a
+/// single streaming pass:
+/// * Path data is rewritten to its shortest form: For every segment the
+///   shorter of the absolute and the relative command is chosen, repeated
+///   commands are left out and separators are only written where required.
+///   Straight lines become H/V commands where possible.
+/// * Numbers are rounded to a fixed number of decimals (`precision`).
+///   Relative path coordinates are computed from the rounded positions, so
+///   rounding errors don't accumulate along a path.
+/// * Attributes equal to their default from svg_entities.def are dropped.
+/// * Colors are written as the shortest of #rgb, #rrggbb and color names.
+/// * Elements without children are self-closed and comments are dropped.
+struct SVGMinifyingWriter : public SVGWriterBase<SVGMinifyingWriter> {
+  using self_t = SVGMinifyingWriter;
+  using base_t = SVGWriterBase<self_t>;
+  using RetTy = SVGWriterErrorOr<self_t *>;
+
+  static constexpr unsigned DefaultPrecision = 3;
+  static constexpr unsigned MaxPrecision = 12;
+
+  explicit SVGMinifyingWriter(outstream_t &os,
+                              unsigned precision = DefaultPrecision)
+      : base_t(os), precision(std::min(precision, MaxPrecision)) {}
+
+  RetTy leave() {
+    assert(parents.size() && "Cannot leave: No parent tag");
+    // Don't complete the start tag of elements without children, so that
+    // closeTag() can self-close them
+    if (currentTag)
+      closeTag();
+    currentTag = parents.top();
+    parents.pop();
+    return this;
+  }
+  RetTy content(const char *text) {
+    closeTag();
+    output() << text;
+    return this;
+  }
+  RetTy comment(const char *) { return this; }
+
+  /// Shortest equivalent of the path data @p d. Returns @p d unchanged if
+  /// it can't be parsed.
+  static std::string minifyPathData(std::string_view d, unsigned precision);
+  /// Round all numbers in a list of numbers, lengths or transform functions
+  /// and drop redundant whitespace. Returns @p value unchanged if it
+  /// contains anything else.
+  static std::string minifyNumbers(std::string_view value,
+                                   unsigned precision);
+  /// Shortest notation of a hex, rgb() or named color. Other paint values
+  /// (e.g. `none` or `url(#id)`) are returned unchanged.
+  static std::string minifyColor(std::string_view color);
+  /// @p value rounded to @p precision decimals without trailing zeros or a
+  /// leading zero, e.g. `.5` or `-12.25`.
+  static std::string formatNumber(double value, unsigned precision);
+
+private:
+  friend base_t;
+  self_t forkWriter(outstream_t &os) const { return self_t(os, precision); }
+  template <typename container_t>
+  void openTag(const char *tagname, const container_t &attrs) {
+    std::vector<SVGAttribute> attrsVec(attrs.begin(), attrs.end());
+    openTag(tagname, attrsVec);
+  }
+  void openTag(const char *tagname, const std::vector<SVGAttribute> &attrs);
+  /// Closes the current element. Without a current element, completes the
+  /// start tag of the parent instead.
+  void closeTag();
+  void writeAttr(const SVGAttribute &attr);
+  /// Completes the start tag of the innermost open element before its first
+  /// child or text is written
+  void finishStartTag() {
+    if (startPending) {
+      output() << '>';
+      startPending = false;
+    }
+  }
+
+  unsigned precision;
+  /// True while the last start tag written lacks its closing `>`
+  bool startPending = false;
+};
+} // namespace svg
+#endif // SVGUTILS_SVG_MINIFYING_WRITER_H
@@ -0,0 +1,80 @@
+#ifndef SVGUTILS_SVG_OPTIMIZER_H
+#define SVGUTILS_SVG_OPTIMIZER_H
+
+#include "svgutils/svg_document.h"
+
+#include <thread>
+
+namespace svg {
+/// Structural optimizations on an in-memory svg document that don't change
+/// how the document renders. Passes:
+/// * Remove `<defs>` content that isn't referenced by `url(#id)` or `href`.
+/// * Collapse `<g>` wrappers: Groups without attributes are replaced by their
+///   children. Attributes of a group with a single child are pushed down to
+///   the child if they only affect inheritance (or are a transform).
+/// * Fold presentation attributes that all children of a group share into
+///   the group.
+/// * Merge consecutive `<path>` siblings with identical attributes into a
+///   single path, as long as their bounding boxes don't overlap (so painting
+///   order doesn't matter).
+/// Elements with an id are never removed or merged since they may be
+/// referenced. Groups with a class or style are kept since a stylesheet may
+/// match them.
+///
+/// The subtrees below the outermost svg element are independent for all
+/// passes except defs removal and are optimized in parallel.
+class SVGOptimizer {
+public:
+  struct Options {
+    bool removeUnusedDefs = true;
+    bool collapseGroups = true;
+    bool foldAttributes = true;
+    bool mergePaths = true;
+    /// Threads to optimize subtrees of the root element with
+    unsigned numThreads = std::thread::hardware_concurrency();
+  };
+  struct Statistics {
+    size_t elementsBefore = 0;
+    size_t elementsAfter = 0;
+    size_t defsRemoved = 0;
+    size_t groupsCollapsed = 0;
+    size_t attributesFolded = 0;
+    size_t pathsMerged = 0;
+
+    Statistics &operator+=(const Statistics &other);
+    friend inline outstream_t &operator<<(outstream_t &os,
+                                          const Statistics &stats) {
+      os << "elements: " << stats.elementsBefore << " -> "
+         << stats.elementsAfter << ", defs removed: " << stats.defsRemoved
+         << ", groups collapsed: " << stats.groupsCollapsed
+         << ", attributes folded: " << stats.attributesFolded
+         << ", paths merged: " << stats.pathsMerged;
+      return os;
+    }
+  };
+
+  SVGOptimizer() = default;
+  explicit SVGOptimizer(const Options &options) : options(options) {}
+
+  /// Run all enabled passes on @p document
+  Statistics optimize(SVGDocument &document) const;
+
+  /// True for presentation attributes that are inherited by child elements
+  /// and can therefore be moved between a group and its children.
+  static bool isInheritedAttribute(std::string_view name);
+
+private:
+  void removeUnusedDefs(SVGNode &root, Statistics &stats) const;
+  /// Optimize the subtree below @p node bottom-up
+  void optimizeSubtree(SVGNode &node, Statistics &stats) const;
+  /// Passes over the children list of @p node. Assumes the children have
+  /// already been optimized.
+  void optimizeChildren(SVGNode &node, Statistics &stats) const;
+  void collapseGroups(SVGNode &node, Statistics &stats) const;
+  void foldAttributes(SVGNode &node, Statistics &stats) const;
+  void mergePaths(SVGNode &node, Statistics &stats) const;
+
+  Options options;
+};
+} // namespace svg
+#endif // SVGUTILS_SVG_OPTIMIZER_H
@@ -0,0 +1,121 @@
+#ifndef SVGUTILS_SVG_PATH_DATA_H
+#define SVGUTILS_SVG_PATH_DATA_H
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace svg {
+/// Path geometry normalized to four kinds of segments in absolute
+/// coordinates: moveto, lineto, cubic Bézier curveto and closepath.
+/// Relative commands are resolved, H/V become lines, quadratic curves are
+/// raised to cubic ones and elliptical arcs are approximated by cubic
+/// curves. Backends drawing paths only need to support these four.
+///
+/// The segments are stored as two arrays, one byte per verb and all
+/// coordinates back to back, so passes over the geometry (transforms,
+/// bounds, ...) are plain loops over the coordinates that the compiler can
+/// vectorize.
+class PathData {
+public:
+  enum class Verb : uint8_t { MOVE, LINE, CUBIC, CLOSE };
+  /// The affine transform `(x, y) -> (a x + c y + e, b x + d y + f)`, as in
+  /// `matrix(a b c d e f)`
+  struct Matrix {
+    double a = 1., b = 0., c = 0., d = 1., e = 0., f = 0.;
+    static Matrix scale(double sx, double sy) { return {sx, 0., 0., sy}; }
+    static Matrix translate(double tx, double ty) {
+      return {1., 0., 0., 1., tx, ty};
+    }
+  };
+  struct Bounds {
+    double x0, y0, x1, y1;
+
+    Bounds inflate(double margin) const {
+      return {x0 - margin, y0 - margin, x1 + margin, y1 + margin};
+    }
+    bool intersects(const Bounds &other) const {
+      return x0 <= other.x1 && other.x0 <= x1 && y0 <= other.y1 &&
+             other.y0 <= y1;
+    }
+    /// Grow to contain @p other as well
+    void unite(const Bounds &other) {
+      x0 = std::min(x0, other.x0);
+      y0 = std::min(y0, other.y0);
+      x1 = std::max(x1, other.x1);
+      y1 = std::max(y1, other.y1);
+    }
+  };
+
+  /// Parse the path data @p d. Like renderers do, parsing stops at the
+  /// first error and the segments before it are kept.
+  static PathData parse(std::string_view d);
+  /// The outline of a `<polyline>` or (with @p close) `<polygon>`
+  static PathData fromPoints(std::string_view points, bool close);
+
+  void moveTo(double x, double y);
+  void lineTo(double x, double y);
+  void cubicTo(double x1, double y1, double x2, double y2, double x,
+               double y);
+  void close();
+
+  bool empty() const { return verbs.empty(); }
+  const std::vector<Verb> &getVerbs() const { return verbs; }
+  /// Coordinates of all segments, in the order of their verbs
+  const std::vector<double> &getCoords() const { return coords; }
+  /// Description of the error parsing stopped at, empty if there was none
+  const std::string &getError() const { return error; }
+
+  /// Apply @p matrix to all coordinates
+  void transform(const Matrix &matrix);
+  /// Bounds of all end and control points, which contain the filled area
+  /// of the path. Empty paths have no bounds.
+  std::optional<Bounds> getBounds() const;
+  /// The path with every curve replaced by lines that deviate at most
+  /// @p tolerance from it
+  PathData flatten(double tolerance) const;
+  /// The path with curves flattened and every vertex removed that isn't
+  /// needed to stay within @p tolerance of the original outline
+  /// (Douglas-Peucker), e.g. to draw a detailed map at a small size.
+  PathData simplify(double tolerance) const;
+
+  /// Number of coordinates a segment of kind @p verb has
+  static constexpr size_t numCoords(Verb verb) {
+    return verb == Verb::CUBIC ? 6 : verb == Verb::CLOSE ? 0 : 2;
+  }
+
+  /// Call `moveTo(x, y)`, `lineTo(x, y)`, `cubicTo(x1, y1, x2, y2, x, y)`
+  /// and `close()` on @p visitor for all segments in order
+  template <typename VisitorTy> void visit(VisitorTy &visitor) const {
+    const double *c = coords.data();
+    for (Verb verb : verbs) {
+      switch (verb) {
+      case Verb::MOVE:
+        visitor.moveTo(c[0], c[1]);
+        break;
+      case Verb::LINE:
+        visitor.lineTo(c[0], c[1]);
+        break;
+      case Verb::CUBIC:
+        visitor.cubicTo(c[0], c[1], c[2], c[3], c[4], c[5]);
+        break;
+      case Verb::CLOSE:
+        visitor.close();
+        break;
+      }
+      c += numCoords(verb);
+    }
+  }
+
+private:
+  friend class PathDataParser;
+
+  std::vector<Verb> verbs;
+  std::vector<double> coords;
+  std::string error;
+};
+} // namespace svg
+#endif // SVGUTILS_SVG_PATH_DATA_H
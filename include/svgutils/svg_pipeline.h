@@ -0,0 +1,133 @@
+#ifndef SVGUTILS_SVG_PIPELINE_H
+#define SVGUTILS_SVG_PIPELINE_H
+
+#include "svgutils/spsc_queue.h"
+#include "svgutils/svg_event.h"
+#include "svgutils/svg_reader_writer.h"
+
+#include <atomic>
+#include <chrono>
+#include <optional>
+#include <thread>
+
+namespace svg {
+/// Writer that hands every call over to another writer running on a
+/// separate consumer thread.
+/// Calls are materialized as SVGEvents and passed through a bounded
+/// lock-free ring buffer. This way, the producer (e.g. the svg parser) and
+/// an expensive writer (e.g. CairoSVGWriter) run in parallel.
+///
+/// Errors of the wrapped writer are reported asynchronously: Calls only fail
+/// if the consumer already reported an error and finish() reports the first
+/// error. The wrapped writer must not be accessed by other code before
+/// finish() returned.
+class SVGPipelineWriter : public virtual WriterConcept {
+public:
+  /// What to do while the queue is full (producer) or empty (consumer).
+  using Backpressure = SPSCBackpressure;
+  struct Options {
+    /// Capacity of the ring buffer in events. Rounded up to a power of two.
+    size_t queueSize = 4096;
+    Backpressure backpressure = Backpressure::YIELD;
+    std::chrono::microseconds sleepTime{50};
+  };
+  struct Statistics {
+    /// Number of events handed over to the consumer
+    size_t events = 0;
+    /// Number of pushes that found the queue full
+    size_t producerStalls = 0;
+    /// Number of pops that found the queue empty
+    size_t consumerStalls = 0;
+    /// Maximum number of queued events, sampled on every push
+    size_t maxOccupancy = 0;
+    /// Average number of queued events, sampled on every push
+    double avgOccupancy = 0.;
+
+    friend inline outstream_t &operator<<(outstream_t &os,
+                                          const Statistics &stats) {
+      os << "events: " << stats.events
+         << ", producer stalls: " << stats.producerStalls
+         << ", consumer stalls: " << stats.consumerStalls
+         << ", max occupancy: " << stats.maxOccupancy
+         << ", avg occupancy: " << stats.avgOccupancy;
+      return os;
+    }
+  };
+
+  explicit SVGPipelineWriter(WriterConcept &writer)
+      : SVGPipelineWriter(writer, Options()) {}
+  SVGPipelineWriter(WriterConcept &writer, const Options &options)
+      : writer(writer), options(options) {}
+  ~SVGPipelineWriter() override;
+  SVGPipelineWriter(const SVGPipelineWriter &) = delete;
+  SVGPipelineWriter &operator=(const SVGPipelineWriter &) = delete;
+
+  /// Can only be changed before the first call.
+  void setOptions(const Options &options);
+  const Options &getOptions() const { return options; }
+  /// Only complete after finish() returned.
+  Statistics getStatistics() const;
+
+#define SVG_TAG(NAME, STR, ...)                                                \
+  RetTy NAME(const std::vector<SVGAttribute> &attrs) override {                \
+    return post(SVGEvent(SVGEvent::TagType::NAME, attrs));                     \
+  }
+#include "svgutils/svg_entities.def"
+  RetTy custom_tag(const char *tag,
+                   const std::vector<SVGAttribute> &attrs) override {
+    return post(SVGEvent(tag, attrs));
+  }
+  RetTy enter() override { return post(SVGEvent(SVGEvent::Kind::ENTER)); }
+  RetTy leave() override { return post(SVGEvent(SVGEvent::Kind::LEAVE)); }
+  RetTy content(const char *text) override {
+    return post(SVGEvent(SVGEvent::Kind::CONTENT, text));
+  }
+  RetTy comment(const char *text) override {
+    return post(SVGEvent(SVGEvent::Kind::COMMENT, text));
+  }
+  RetTy finish() override;
+
+private:
+  RetTy post(SVGEvent &&event);
+  void start();
+  void stop();
+  void work();
+  void wait() const;
+
+  WriterConcept &writer;
+  Options options;
+  std::unique_ptr<SPSCQueue<SVGEvent>> queue;
+  std::thread consumer;
+  bool running = false;
+  std::atomic<bool> stopping{false};
+  std::optional<SVGWriterError> error;
+  std::atomic<bool> failed{false};
+
+  // Producer-side statistics
+  size_t events = 0;
+  size_t producerStalls = 0;
+  size_t maxOccupancy = 0;
+  size_t occupancySum = 0;
+  // Consumer-side statistics
+  size_t consumerStalls = 0;
+};
+
+/// Like SVGReaderWriter, but the wrapped writer runs on its own thread
+/// while the parser keeps tokenizing the input.
+template <typename WriterTy>
+struct SVGPipelinedReaderWriter : public SVGReaderWriterBase {
+  using base_t = SVGReaderWriterBase;
+  template <typename... args_t>
+  SVGPipelinedReaderWriter(args_t &&... args)
+      : base_t(pipeline), writer(std::forward<args_t>(args)...),
+        pipeline(writer) {}
+
+  WriterTy &getWriter() { return writer.getWriter(); }
+  SVGPipelineWriter &getPipeline() { return pipeline; }
+
+private:
+  WriterModel<WriterTy> writer;
+  SVGPipelineWriter pipeline;
+};
+} // namespace svg
+#endif // SVGUTILS_SVG_PIPELINE_H
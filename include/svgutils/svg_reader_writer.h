@@ -37,6 +37,9 @@ private:
 
   enum class TagType;
   std::stack<TagType> parents;
+  /// Writers may hold on to tag names until the tag is closed, so the names
+  /// of custom tags need to outlive the parsing of the tag itself.
+  std::set<std::string, std::less<>> customTagNames;
 
   bool readUntil(instream_t &is, const std::string_view &delim,
                  /* out */ std::stringstream &os);
@@ -49,6 +52,7 @@ private:
   static TagType parseTagType(const std::string &name);
   void dispatchTag(TagType tag, const std::vector<SVGAttribute> &attrs);
   std::string parseName(instream_t &is);
+  const char *internCustomTagName(const std::string &name);
   MaybeError parseAttributes(instream_t &is,
                              /*out*/ std::vector<RawAttr> &attrs);
   static MaybeError convertAttrs(const std::vector<RawAttr> &raw,
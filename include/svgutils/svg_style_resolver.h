@@ -0,0 +1,112 @@
+#ifndef SVGUTILS_SVG_STYLE_RESOLVER_H
+#define SVGUTILS_SVG_STYLE_RESOLVER_H
+
+#include "svgutils/css_utils.h"
+#include "svgutils/svg_document.h"
+
+#include <thread>
+#include <unordered_map>
+
+namespace svg {
+/// The styles of an element after the cascade, as returned by the getters
+/// of StyleTracker.
+struct SVGComputedStyle {
+  CSSColor color;
+  CSSColor fill;
+  CSSColor stroke;
+  CSSUnit strokeWidth;
+  CSSDashArray strokeDasharray;
+  CSSUnit fontSize;
+  std::string fontFamily;
+  CSSTextAnchor textAnchor = CSSTextAnchor::START;
+  CSSUnit width;
+  CSSUnit height;
+
+  /// The current styles of @p styles
+  static SVGComputedStyle from(const StyleTracker &styles);
+};
+
+/// Computes the styles of all elements of an in-memory document at once.
+///
+/// StyleTracker resolves styles while walking the document, which is
+/// inherently serial. Since a subtree only depends on the styles of its
+/// root's parent, the resolver instead splits the document into tasks of
+/// consecutive sibling subtrees of roughly equal size. Each task starts from
+/// a fork of the cascade at its parent, and the tasks run in parallel.
+/// Larger subtrees are split further, walking down from the root.
+///
+/// The results are stored in one array in document order, so after
+/// resolve() they can be read from any thread without locking. The rules of
+/// all `<style>` elements apply to the whole document, as in browsers.
+class SVGStyleResolver {
+public:
+  struct Options {
+    /// Threads to resolve subtrees with
+    unsigned numThreads = std::thread::hardware_concurrency();
+    /// Subtrees with fewer elements are not split into several tasks
+    size_t minTaskElements = 256;
+  };
+  struct Statistics {
+    size_t elements = 0;
+    size_t tasks = 0;
+    size_t threads = 0;
+    /// Combined statistics of the trackers of all tasks
+    StyleTracker::Statistics styles;
+
+    friend inline outstream_t &operator<<(outstream_t &os,
+                                          const Statistics &stats) {
+      os << "elements: " << stats.elements << ", tasks: " << stats.tasks
+         << ", threads: " << stats.threads << ", " << stats.styles;
+      return os;
+    }
+  };
+
+  SVGStyleResolver() = default;
+  explicit SVGStyleResolver(const Options &options) : options(options) {}
+
+  /// Compute the styles of all elements of @p document, replacing the
+  /// results of previous calls. The document must not be modified while
+  /// the results are in use.
+  Statistics resolve(const SVGDocument &document);
+
+  /// The styles of the element @p node, nullptr if it isn't part of the
+  /// resolved document
+  const SVGComputedStyle *get(const SVGNode &node) const {
+    auto it = indices.find(&node);
+    return it == indices.end() ? nullptr : &styles[it->second];
+  }
+  /// The elements and their styles, in document order
+  const std::vector<const SVGNode *> &getNodes() const { return nodes; }
+  const std::vector<SVGComputedStyle> &getStyles() const { return styles; }
+
+private:
+  /// Consecutive element children of `parent`, which are resolved together
+  struct Task {
+    std::vector<const SVGNode *> roots;
+    /// Index of the first element of the task
+    size_t index;
+    /// The cascade at the parent
+    StyleTracker styles;
+  };
+
+  /// Assign indices to the elements below @p node. Returns the number of
+  /// elements of the subtree.
+  size_t number(const SVGNode &node, std::string &css);
+  /// Create the tasks for the children of @p node, whose styles are
+  /// current in @p styles
+  void plan(const SVGNode &node, StyleTracker &styles, size_t grain,
+            std::vector<Task> &tasks);
+  /// Resolve @p node and its descendants, the first of which has index
+  /// @p index. Advances @p index past the subtree.
+  void resolveSubtree(const SVGNode &node, StyleTracker &styles,
+                      size_t &index);
+
+  Options options;
+  std::vector<const SVGNode *> nodes;
+  /// Number of elements in the subtree of each element
+  std::vector<size_t> sizes;
+  std::vector<SVGComputedStyle> styles;
+  std::unordered_map<const SVGNode *, size_t> indices;
+};
+} // namespace svg
+#endif // SVGUTILS_SVG_STYLE_RESOLVER_H
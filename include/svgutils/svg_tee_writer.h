@@ -0,0 +1,159 @@
+#ifndef SVGUTILS_SVG_TEE_WRITER_H
+#define SVGUTILS_SVG_TEE_WRITER_H
+
+#include "svgutils/spsc_queue.h"
+#include "svgutils/svg_event.h"
+#include "svgutils/svg_writer.h"
+
+#include <deque>
+#include <thread>
+#include <tuple>
+
+namespace svg {
+/// Writer that forwards every call to all of its wrapped writers, in order.
+/// This allows e.g. a single SVGReaderWriter parse to produce a formatted
+/// svg, a png and a pdf at the same time:
+///
+///   SVGReaderWriter<SVGTeeWriter<SVGFormattedWriter, CairoSVGWriter>>
+///       Reader(SVGFormattedWriter(os), CairoSVGWriter(png, PNG));
+///
+/// All writers receive every call, even if a previous writer failed. The
+/// first error is reported.
+template <typename... WritersTy> struct SVGTeeWriter {
+  using self_t = SVGTeeWriter<WritersTy...>;
+  using RetTy = SVGWriterErrorOr<self_t *>;
+
+  SVGTeeWriter(WritersTy &&... writers) : writers(std::move(writers)...) {}
+  SVGTeeWriter(self_t &&) = default;
+  self_t &operator=(self_t &&) = default;
+
+#define SVG_TAG(NAME, STR, ...)                                                \
+  template <typename... attrs_t> RetTy NAME(attrs_t... attrs) {                \
+    std::vector<SVGAttribute> attrsVec({std::forward<attrs_t>(attrs)...});     \
+    return NAME(attrsVec);                                                     \
+  }                                                                            \
+  template <typename container_t> RetTy NAME(const container_t &attrs) {       \
+    return forEach([&attrs](auto &writer) { return writer.NAME(attrs); });     \
+  }
+#include "svgutils/svg_entities.def"
+
+  template <typename... attrs_t>
+  RetTy custom_tag(const char *tagname, attrs_t... attrs) {
+    std::vector<SVGAttribute> attrsVec({std::forward<attrs_t>(attrs)...});
+    return custom_tag(tagname, attrsVec);
+  }
+  template <typename container_t>
+  RetTy custom_tag(const char *tagname, const container_t &attrs) {
+    return forEach([tagname, &attrs](auto &writer) {
+      return writer.custom_tag(tagname, attrs);
+    });
+  }
+  RetTy content(const char *text) {
+    return forEach([text](auto &writer) { return writer.content(text); });
+  }
+  RetTy comment(const char *comment) {
+    return forEach(
+        [comment](auto &writer) { return writer.comment(comment); });
+  }
+  RetTy enter() {
+    return forEach([](auto &writer) { return writer.enter(); });
+  }
+  RetTy leave() {
+    return forEach([](auto &writer) { return writer.leave(); });
+  }
+  RetTy finish() {
+    return forEach([](auto &writer) { return writer.finish(); });
+  }
+
+  template <size_t Idx> auto &getWriter() { return std::get<Idx>(writers); }
+
+private:
+  template <typename FnTy> RetTy forEach(FnTy &&fn) {
+    std::optional<SVGWriterError> err;
+    auto call = [&err, &fn](auto &writer) {
+      auto res = fn(writer);
+      if (res && !err)
+        err = res.to_error();
+    };
+    std::apply([&call](auto &... writer) { (call(writer), ...); }, writers);
+    if (err)
+      return *err;
+    return this;
+  }
+
+  std::tuple<WritersTy...> writers;
+};
+
+/// Type-erased counterpart of SVGTeeWriter. Writers are added at runtime
+/// before the first call is made.
+///
+/// In THREADED mode, every writer runs on its own thread and is fed through
+/// a lock-free single-producer/single-consumer queue of SVGEvents, so
+/// CPU-heavy backends (e.g. Cairo) work in parallel to the parser and to
+/// each other. Errors are reported asynchronously in this mode: Calls only
+/// fail if a backend already reported an error and finish() reports the
+/// first error of any backend. Wrapped writers must not be accessed by
+/// other code before finish() returned. @p wait decides how the parser and
+/// the worker threads wait for a full or empty queue, e.g. sleeping keeps
+/// idle workers of a slow parser from taking up cores.
+class SVGDynamicTeeWriter : public virtual WriterConcept {
+public:
+  enum class Mode { INLINE, THREADED };
+
+  explicit SVGDynamicTeeWriter(Mode mode = Mode::INLINE,
+                               size_t queueSize = 1024,
+                               const SPSCWait &wait = SPSCWait());
+  ~SVGDynamicTeeWriter() override;
+  SVGDynamicTeeWriter(const SVGDynamicTeeWriter &) = delete;
+  SVGDynamicTeeWriter &operator=(const SVGDynamicTeeWriter &) = delete;
+
+  /// Add a writer owned by someone else.
+  void addWriter(WriterConcept &writer);
+  /// Create and add a writer owned by this tee.
+  template <typename WriterTy, typename... args_t>
+  WriterTy &emplaceWriter(args_t &&... args) {
+    auto model =
+        std::make_unique<WriterModel<WriterTy>>(std::forward<args_t>(args)...);
+    WriterTy &writer = model->getWriter();
+    addWriter(*model);
+    backends.back().owned = std::move(model);
+    return writer;
+  }
+  size_t getNumWriters() const { return backends.size(); }
+
+#define SVG_TAG(NAME, STR, ...)                                                \
+  RetTy NAME(const std::vector<SVGAttribute> &attrs) override;
+#include "svgutils/svg_entities.def"
+  RetTy custom_tag(const char *tag,
+                   const std::vector<SVGAttribute> &attrs) override;
+  RetTy enter() override;
+  RetTy leave() override;
+  RetTy content(const char *text) override;
+  RetTy comment(const char *text) override;
+  RetTy finish() override;
+
+private:
+  using EventPtr = std::shared_ptr<const SVGEvent>;
+  struct Backend {
+    WriterConcept *writer = nullptr;
+    std::unique_ptr<WriterConcept> owned;
+    std::unique_ptr<SPSCQueue<EventPtr>> queue;
+    std::thread worker;
+    std::optional<SVGWriterError> error;
+    std::atomic<bool> failed{false};
+  };
+
+  template <typename FnTy> RetTy forEach(FnTy &&fn);
+  RetTy post(SVGEvent &&event);
+  void startWorkers();
+  void stopWorkers();
+  static void work(Backend &backend, SPSCWait wait);
+
+  const Mode mode;
+  const size_t queueSize;
+  const SPSCWait wait;
+  bool running = false;
+  std::deque<Backend> backends; // Backend is not movable
+};
+} // namespace svg
+#endif // SVGUTILS_SVG_TEE_WRITER_H
@@ -0,0 +1,78 @@
+#ifndef SVGUTILS_SVG_VIEWPORT_H
+#define SVGUTILS_SVG_VIEWPORT_H
+
+#include "svgutils/svg_path_data.h"
+#include "svgutils/svg_writer.h"
+
+namespace svg {
+/// The `viewBox` of an `<svg>` element: the rectangle of user space that is
+/// stretched onto the viewport
+struct SVGViewBox {
+  double x = 0., y = 0., width = 0., height = 0.;
+
+  /// Parse the value of @p attr, four numbers separated by whitespace and/or
+  /// commas. Returns nullopt if it isn't valid or the box is empty, in which
+  /// case renderers ignore it.
+  static std::optional<SVGViewBox> parse(const SVGAttribute &attr);
+};
+
+/// How a viewBox is fit into a viewport of a different aspect ratio, from
+/// the `preserveAspectRatio` attribute. Defaults to `xMidYMid meet`.
+struct SVGPreserveAspectRatio {
+  enum class Align : uint8_t { MIN, MID, MAX };
+  /// Scale both directions independently, `none`
+  bool none = false;
+  Align x = Align::MID;
+  Align y = Align::MID;
+  /// Cover the whole viewport (`slice`) instead of fitting into it (`meet`)
+  bool slice = false;
+
+  /// Parse @p value, returning the default if it isn't valid
+  static SVGPreserveAspectRatio parse(std::string_view value);
+  /// The transform from the user space of @p viewBox to a viewport of
+  /// @p width by @p height at the origin
+  PathData::Matrix getTransform(const SVGViewBox &viewBox, double width,
+                                double height) const;
+};
+
+/// Where the outermost `<svg>` element of a document is drawn on an output
+/// surface
+struct SVGViewport {
+  /// How the document is sized to the dimensions of the output
+  enum class Fit {
+    /// The dimensions are the viewport of the document, like the size of an
+    /// `<img>` showing it. Only documents with a viewBox are scaled.
+    VIEWPORT,
+    /// Scale the document to fit into the dimensions, keeping its aspect
+    /// ratio. The output gets the size of the scaled document, and a
+    /// dimension of 0 follows from the other one.
+    FIT,
+    /// Scale the document to cover the dimensions, keeping its aspect ratio
+    /// and cropping what sticks out on both sides evenly
+    FILL,
+  };
+
+  /// Size of the output in px
+  double width = 0., height = 0.;
+  /// From the user space of the document to the output in px
+  PathData::Matrix transform;
+  /// Size of the user space, which percentages refer to
+  double userWidth = 0., userHeight = 0.;
+
+  /// How much lengths in user space are scaled on the output
+  double getScale() const;
+
+  /// Place a document of @p docWidth by @p docHeight px on an output of
+  /// @p width by @p height px. Document dimensions of 0 (not given) follow
+  /// from the aspect ratio of @p viewBox or fall back to @p dfltWidth and
+  /// @p dfltHeight. If both output dimensions are 0 the output gets the
+  /// size of the document, otherwise a missing one is the default as well
+  /// unless @p fit computes it.
+  static SVGViewport compute(double docWidth, double docHeight,
+                             const std::optional<SVGViewBox> &viewBox,
+                             const SVGPreserveAspectRatio &aspect,
+                             double width, double height, Fit fit,
+                             double dfltWidth, double dfltHeight);
+};
+} // namespace svg
+#endif // SVGUTILS_SVG_VIEWPORT_H
@@ -3,8 +3,11 @@
 
 #include "svgutils/utils.h"
 
+#include <algorithm>
+#include <array>
 #include <cassert>
 #include <cstdint>
+#include <initializer_list>
 #include <iostream>
 #include <map>
 #include <memory>
@@ -21,6 +24,78 @@ namespace svg {
 /// just change this typedef to make use of your stream implementation.
 using outstream_t = std::ostream;
 
+/// A small, fixed-size list of numbers used as an attribute value, e.g.
+/// `viewBox="0 0 w h"` or `transform="matrix(a b c d e f)"`.
+/// The numbers are only formatted when the attribute is written, so there is
+/// no need to build (and keep alive) a string up front. Consumers that
+/// understand the value can also read the numbers without parsing text.
+struct SVGNumberTuple final {
+  static constexpr size_t MaxSize = 6;
+
+  SVGNumberTuple() = default;
+  SVGNumberTuple(const SVGNumberTuple &) = default;
+  SVGNumberTuple &operator=(const SVGNumberTuple &) = default;
+
+  static SVGNumberTuple List(double a, double b) { return {a, b}; }
+  static SVGNumberTuple List(double a, double b, double c, double d) {
+    return {a, b, c, d};
+  }
+  static SVGNumberTuple Translate(double tx, double ty) {
+    return {"translate", {tx, ty}};
+  }
+  static SVGNumberTuple Scale(double sx, double sy) {
+    return {"scale", {sx, sy}};
+  }
+  static SVGNumberTuple Rotate(double angle) { return {"rotate", {angle}}; }
+  static SVGNumberTuple Rotate(double angle, double cx, double cy) {
+    return {"rotate", {angle, cx, cy}};
+  }
+  static SVGNumberTuple Matrix(double a, double b, double c, double d,
+                               double e, double f) {
+    return {"matrix", {a, b, c, d, e, f}};
+  }
+
+  /// The name of the transform function wrapping the numbers or nullptr if
+  /// this is a plain, space-separated list.
+  const char *getFunction() const { return function; }
+  size_t size() const { return count; }
+  double operator[](size_t idx) const {
+    assert(idx < count && "Tried accessing out-of-range tuple element");
+    return numbers[idx];
+  }
+  const double *begin() const { return numbers.data(); }
+  const double *end() const { return numbers.data() + count; }
+
+  friend inline outstream_t &operator<<(outstream_t &os,
+                                        const SVGNumberTuple &tuple) {
+    if (tuple.function)
+      os << tuple.function << '(';
+    for (size_t i = 0; i < tuple.count; ++i) {
+      if (i)
+        os << ' ';
+      os << tuple.numbers[i];
+    }
+    if (tuple.function)
+      os << ')';
+    return os;
+  }
+
+private:
+  /// Only the factories above create tuples, so there are never more than
+  /// MaxSize numbers
+  SVGNumberTuple(std::initializer_list<double> numbers)
+      : SVGNumberTuple(nullptr, numbers) {}
+  SVGNumberTuple(const char *function, std::initializer_list<double> numbers)
+      : function(function), count(numbers.size()) {
+    assert(numbers.size() <= MaxSize && "Too many numbers for SVGNumberTuple");
+    std::copy(numbers.begin(), numbers.end(), this->numbers.begin());
+  }
+
+  const char *function = nullptr;
+  size_t count = 0;
+  std::array<double, MaxSize> numbers{};
+};
+
 /// Base class of all SVG attributes.
 struct SVGAttribute final {
   SVGAttribute(const SVGAttribute &) = default;
@@ -28,6 +103,9 @@ struct SVGAttribute final {
   const char *getName() const { return name; }
   std::string getValueStr() const;
   const char *cstrOrNull() const;
+  const SVGNumberTuple *tupleOrNull() const {
+    return std::get_if<SVGNumberTuple>(&value);
+  }
   double toDouble() const;
   template <typename T> void setValue(T value) { this->value = value; }
   inline friend outstream_t &operator<<(outstream_t &os,
@@ -44,6 +122,7 @@ struct SVGAttribute final {
   static SVGAttribute Create(const char *name, const char *value);
   static SVGAttribute Create(const char *name, int64_t value);
   static SVGAttribute Create(const char *name, double value);
+  static SVGAttribute Create(const char *name, const SVGNumberTuple &value);
 
 private:
   template <typename T> auto castToLegalType(T value) {
@@ -53,6 +132,8 @@ private:
       return static_cast<int64_t>(value);
     else if constexpr (std::is_floating_point_v<T>)
       return static_cast<double>(value);
+    else if constexpr (std::is_same_v<T, SVGNumberTuple>)
+      return value;
   }
 
   template <typename T>
@@ -60,13 +141,17 @@ private:
       : name(name), value(castToLegalType(value)) {}
 
   static const char *GetUniqueNameFor(const char *name);
+  /// Returns true if @p name is the unique name of an attribute from
+  /// svg_entities.def (pointer comparison only).
+  static bool IsUniqueName(const char *name);
 
   template <typename DerivedT> friend class SVGWriterBase;
+  friend class SVGEvent;
 #define SVG_ATTR(NAME, STR, DEFAULT) friend struct NAME;
 #include "svg_entities.def"
 
   const char *name;
-  using value_t = std::variant<const char *, int64_t, double>;
+  using value_t = std::variant<const char *, int64_t, double, SVGNumberTuple>;
   value_t value;
 };
 
@@ -80,6 +165,7 @@ private:
     const char *getName() const { return tagName; }                            \
     std::string getValueStr() const { return attr.getValueStr(); }             \
     const char *cstrOrNull() const { return attr.cstrOrNull(); }               \
+    const SVGNumberTuple *tupleOrNull() const { return attr.tupleOrNull(); }   \
                                                                                \
   private:                                                                     \
     friend class SVGAttribute;                                                 \
@@ -195,6 +281,32 @@ SVGWriterErrorOr<void> SVGWriterErrorOr<T>::without_value() const {
   return SVGWriterErrorOr<void>{};
 }
 
+/// A subtree written into a private buffer by its own writer. Created by
+/// SVGWriterBase::fork() and merged back with SVGWriterBase::splice().
+/// Fragments don't share any state with their parent writer, so each of
+/// them can be filled on a different thread.
+template <typename WriterTy> class SVGFragment {
+public:
+  SVGFragment(SVGFragment &&) = default;
+  SVGFragment &operator=(SVGFragment &&) = default;
+  SVGFragment(const SVGFragment &) = delete;
+  SVGFragment &operator=(const SVGFragment &) = delete;
+
+  WriterTy &getWriter() { return *writer; }
+
+private:
+  template <typename DerivedTy> friend class SVGWriterBase;
+  SVGFragment(std::unique_ptr<std::stringstream> buffer,
+              std::unique_ptr<WriterTy> writer, size_t depth)
+      : buffer(std::move(buffer)), writer(std::move(writer)), depth(depth) {}
+
+  /// Heap-allocated so the writer's stream pointer survives moves
+  std::unique_ptr<std::stringstream> buffer;
+  std::unique_ptr<WriterTy> writer;
+  /// Nesting depth of the parent writer at fork time
+  size_t depth;
+};
+
 /// Base implementation of a writer for svg documents.
 /// Allows overriding most member functions using CRTP.
 template <typename DerivedTy> class SVGWriterBase {
@@ -265,7 +377,32 @@ public:
     return static_cast<DerivedTy *>(this);
   }
 
+  /// Create a fragment for a subtree that is generated independently of
+  /// this writer. The fragment's writer starts at the current nesting depth
+  /// and must be spliced back at that same depth.
+  SVGFragment<DerivedTy> fork() const {
+    auto buffer = std::make_unique<std::stringstream>();
+    auto writer = std::make_unique<DerivedTy>(
+        static_cast<const DerivedTy *>(this)->forkWriter(*buffer));
+    return SVGFragment<DerivedTy>(std::move(buffer), std::move(writer),
+                                  parents.size());
+  }
+  /// Finish @p fragment and append its output to this document as if its
+  /// tags had been written here directly.
+  RetTy splice(SVGFragment<DerivedTy> &fragment) {
+    assert(fragment.depth == parents.size() &&
+           "Fragment must be spliced at the depth it was forked at");
+    if (auto res = fragment.getWriter().finish())
+      return res.to_error();
+    static_cast<DerivedTy *>(this)->closeTag();
+    output() << fragment.buffer->str();
+    return static_cast<DerivedTy *>(this);
+  }
+
 protected:
+  /// Create a writer for a fragment writing to @p os. Writers with
+  /// configuration or depth-dependent output override this.
+  DerivedTy forkWriter(outstream_t &os) const { return DerivedTy(os); }
   template <typename container_t> void writeAttrs(const container_t &attrs) {
     std::set<const char *> keys;
     for (const auto &attr : attrs) {
@@ -0,0 +1,137 @@
+#ifndef SVGUTILS_SVGZ_STREAM_H
+#define SVGUTILS_SVGZ_STREAM_H
+
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Keep zlib.h out of the public headers
+struct z_stream_s;
+
+namespace svg {
+/// Stream buffer that decompresses gzip or zlib data read from another
+/// stream on the fly. Only buffers of a fixed size are kept in memory, so
+/// arbitrarily large .svgz files can be parsed without a decompressed copy.
+/// Concatenated gzip members are decompressed one after the other.
+class InflateStreamBuf : public std::streambuf {
+public:
+  static constexpr size_t DefaultBufferSize = 1 << 16;
+
+  explicit InflateStreamBuf(std::istream &source,
+                            size_t bufferSize = DefaultBufferSize);
+  ~InflateStreamBuf() override;
+  InflateStreamBuf(const InflateStreamBuf &) = delete;
+  InflateStreamBuf &operator=(const InflateStreamBuf &) = delete;
+
+  /// Returns true if the compressed data was corrupt or truncated. The
+  /// decompressed stream delivers everything up to the first error and ends
+  /// there.
+  bool failed() const { return !error.empty(); }
+  const std::string &getError() const { return error; }
+
+protected:
+  int_type underflow() override;
+
+private:
+  std::istream &source;
+  std::unique_ptr<z_stream_s> zs;
+  std::vector<char> in, out;
+  bool streamEnded = false;
+  bool done = false;
+  std::string error;
+};
+
+/// Stream buffer that gzip-compresses everything written to it into another
+/// stream. Data is compressed in chunks of the buffer size; the gzip trailer
+/// is written by close() or the destructor.
+class DeflateStreamBuf : public std::streambuf {
+public:
+  static constexpr size_t DefaultBufferSize = 1 << 16;
+  /// zlib's default trade-off between speed and size (currently 6).
+  static constexpr int DefaultLevel = -1;
+
+  /// @p level ranges from 0 (store only) to 9 (best compression).
+  explicit DeflateStreamBuf(std::ostream &sink, int level = DefaultLevel,
+                            size_t bufferSize = DefaultBufferSize);
+  ~DeflateStreamBuf() override;
+  DeflateStreamBuf(const DeflateStreamBuf &) = delete;
+  DeflateStreamBuf &operator=(const DeflateStreamBuf &) = delete;
+
+  /// Compress all pending data and finish the gzip stream. Nothing may be
+  /// written afterwards. Returns false on failure.
+  bool close();
+
+protected:
+  int_type overflow(int_type c) override;
+  /// Hands all buffered data to zlib and flushes the sink. Does not force
+  /// zlib to emit a flush point, as that would hurt the compression ratio.
+  int sync() override;
+
+private:
+  bool compress(int flush);
+
+  std::ostream &sink;
+  std::unique_ptr<z_stream_s> zs;
+  std::vector<char> in, out;
+  bool closed = false;
+};
+
+/// Input stream reading decompressed data from a gzip-compressed source.
+class GzipInputStream : public std::istream {
+public:
+  explicit GzipInputStream(std::istream &source)
+      : std::istream(nullptr), buf(source) {
+    rdbuf(&buf);
+  }
+  explicit GzipInputStream(std::unique_ptr<std::istream> source)
+      : std::istream(nullptr), owned(std::move(source)), buf(*owned) {
+    rdbuf(&buf);
+  }
+
+  bool failed() const { return buf.failed(); }
+  const std::string &getError() const { return buf.getError(); }
+
+private:
+  std::unique_ptr<std::istream> owned;
+  InflateStreamBuf buf;
+};
+
+/// Output stream gzip-compressing everything written to it into a sink.
+class GzipOutputStream : public std::ostream {
+public:
+  explicit GzipOutputStream(std::ostream &sink,
+                            int level = DeflateStreamBuf::DefaultLevel)
+      : std::ostream(nullptr), buf(sink, level) {
+    rdbuf(&buf);
+  }
+  explicit GzipOutputStream(std::unique_ptr<std::ostream> sink,
+                            int level = DeflateStreamBuf::DefaultLevel)
+      : std::ostream(nullptr), owned(std::move(sink)), buf(*owned, level) {
+    rdbuf(&buf);
+  }
+
+  /// Finish the gzip stream. Called by the destructor if necessary.
+  void close() {
+    if (!buf.close())
+      setstate(badbit);
+  }
+
+private:
+  std::unique_ptr<std::ostream> owned;
+  DeflateStreamBuf buf;
+};
+
+/// Returns true if @p path ends in .svgz (ignoring case).
+bool isSVGZPath(const std::string &path);
+/// Open @p path for reading. gzip-compressed files are decompressed on the
+/// fly, whatever their extension. Returns nullptr if the file can't be read.
+std::unique_ptr<std::istream> openSVGInput(const std::string &path);
+/// Open @p path for writing. Files with an .svgz extension are compressed
+/// with @p level. Returns nullptr if the file can't be created.
+std::unique_ptr<std::ostream>
+openSVGOutput(const std::string &path,
+              int level = DeflateStreamBuf::DefaultLevel);
+} // namespace svg
+#endif // SVGUTILS_SVGZ_STREAM_H
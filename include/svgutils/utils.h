@@ -1,11 +1,16 @@
 #ifndef SVGUTILS_UTILS_H
 #define SVGUTILS_UTILS_H
+#include <algorithm>
+#include <atomic>
 #include <cctype>
 //#include <charconv>
 #include <cstdlib>
 #include <iostream>
 #include <optional>
 #include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
 
 namespace svg {
 [[noreturn]] inline void unreachable_internal(const char *msg = nullptr,
@@ -43,6 +48,36 @@ inline std::optional<double> strview_to_double(std::string_view str) {
   return d;
 }
 
+/// Length of the number at the front of @p str following the svg number
+/// grammar, or 0 if there is none.
+inline size_t strview_scan_number(std::string_view str) {
+  size_t pos = 0;
+  auto digits = [&]() {
+    size_t start = pos;
+    while (pos < str.size() && std::isdigit(str[pos]))
+      ++pos;
+    return pos - start;
+  };
+  if (pos < str.size() && (str[pos] == '+' || str[pos] == '-'))
+    ++pos;
+  size_t numDigits = digits();
+  if (pos < str.size() && str[pos] == '.') {
+    ++pos;
+    numDigits += digits();
+  }
+  if (!numDigits)
+    return 0;
+  if (pos < str.size() && (str[pos] == 'e' || str[pos] == 'E')) {
+    size_t mantissaEnd = pos++;
+    if (pos < str.size() && (str[pos] == '+' || str[pos] == '-'))
+      ++pos;
+    // "1em" is a number with a unit
+    if (!digits())
+      return mantissaEnd;
+  }
+  return pos;
+}
+
 template <typename container_t>
 inline void strview_split(std::string_view str, std::string_view splitchars,
                           /* out */ container_t &splits) {
@@ -57,6 +92,38 @@ inline void strview_split(std::string_view str, std::string_view splitchars,
     }
   } while (str.size());
 }
+
+/// Number of threads parallelFor uses for @p count items
+inline unsigned getNumWorkers(size_t count, unsigned numThreads) {
+  return static_cast<unsigned>(
+      std::min<size_t>(std::max(numThreads, 1u), count));
+}
+
+/// Call @p fn for every index in [0, @p count) on up to @p numThreads
+/// threads, the calling one included, handing out indices in order as the
+/// threads become free. @p fn is called as `fn(index, worker)` if it takes
+/// the number of the thread, which is below getNumWorkers(), and as
+/// `fn(index)` otherwise. Returns the number of threads used.
+template <typename FnTy>
+unsigned parallelFor(size_t count, unsigned numThreads, FnTy &&fn) {
+  std::atomic<size_t> next{0};
+  auto work = [&](unsigned worker) {
+    for (size_t i = next++; i < count; i = next++) {
+      if constexpr (std::is_invocable_v<FnTy &, size_t, unsigned>)
+        fn(i, worker);
+      else
+        fn(i);
+    }
+  };
+  unsigned workers = getNumWorkers(count, numThreads);
+  std::vector<std::thread> threads;
+  for (unsigned worker = 1; worker < workers; ++worker)
+    threads.emplace_back(work, worker);
+  work(0);
+  for (std::thread &thread : threads)
+    thread.join();
+  return workers;
+}
 } // namespace svg
 
 #ifndef NDEBUG
@@ -0,0 +1,318 @@
+#include "svgcairo/cairo_display_list.h"
+#include "svgutils/utils.h"
+#include <cairo/cairo-ft.h>
+#include <cairo/cairo-pdf.h>
+
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <map>
+
+using namespace svg;
+
+namespace {
+struct Appender {
+  cairo_t *cr;
+  void moveTo(double x, double y) { cairo_move_to(cr, x, y); }
+  void lineTo(double x, double y) { cairo_line_to(cr, x, y); }
+  void cubicTo(double x1, double y1, double x2, double y2, double x,
+               double y) {
+    cairo_curve_to(cr, x1, y1, x2, y2, x, y);
+  }
+  void close() { cairo_close_path(cr); }
+};
+
+void setSource(cairo_t *cr, const CSSColor &color) {
+  cairo_set_source_rgba(cr, color.r, color.g, color.b, color.a);
+}
+
+void setStroke(cairo_t *cr, const SVGDisplayList &list,
+               const SVGDisplayList::Paint &paint) {
+  cairo_set_dash(cr, list.getDashes().data() + paint.firstDash,
+                 paint.numDashes, 0.);
+  cairo_set_line_width(cr, paint.strokeWidth);
+  setSource(cr, paint.stroke);
+}
+
+/// Font faces of the families used by a document
+class FontFaces {
+public:
+  explicit FontFaces(Freetype &fonts) : fonts(fonts) {}
+  FontFaces(const FontFaces &) = delete;
+  FontFaces &operator=(const FontFaces &) = delete;
+  ~FontFaces() {
+    for (auto &[family, face] : faces)
+      cairo_font_face_destroy(face);
+  }
+
+  cairo_font_face_t *get(const std::string &family) {
+    auto [it, inserted] = faces.try_emplace(family, nullptr);
+    if (!inserted)
+      return it->second;
+    FT_Face ftFont = fonts.getFace(family.c_str());
+    if (!ftFont)
+      svg_unreachable("Error loading font");
+    return it->second = cairo_ft_font_face_create_for_ft_face(ftFont, 0);
+  }
+
+private:
+  Freetype &fonts;
+  std::map<std::string, cairo_font_face_t *> faces;
+};
+
+/// Draw @p run starting at (@p x, @p y) like CairoSVGWriter does, and move
+/// the position to its end. Only moves the position unless @p visible.
+void drawText(cairo_t *cr, const SVGDisplayList::TextRun &run,
+              const SVGDisplayList::Paint &paint, const SVGDisplayList &list,
+              cairo_font_face_t *face, double &x, double &y, bool visible) {
+  cairo_set_font_face(cr, face);
+  cairo_set_font_size(cr, run.fontSize);
+  cairo_scaled_font_t *scaledFont = cairo_get_scaled_font(cr);
+  if (cairo_scaled_font_status(scaledFont))
+    svg_unreachable("Error getting scaled font");
+
+  cairo_glyph_t *glyphs = nullptr;
+  cairo_text_cluster_t *clusters = nullptr;
+  int numGlyphs = 0, numClusters = 0;
+  cairo_text_cluster_flags_t clusterFlags;
+  if (cairo_scaled_font_text_to_glyphs(
+          scaledFont, x, y, run.text.data(), run.text.size(), &glyphs,
+          &numGlyphs, &clusters, &numClusters, &clusterFlags))
+    svg_unreachable("Failed to convert text to glyphs");
+  if (numGlyphs) {
+    if (run.anchor != CSSTextAnchor::START) {
+      cairo_text_extents_t extents;
+      cairo_scaled_font_glyph_extents(scaledFont, glyphs, numGlyphs,
+                                      &extents);
+      double shift = run.anchor == CSSTextAnchor::MIDDLE
+                         ? extents.x_advance / 2
+                         : extents.x_advance;
+      for (int i = 0; i < numGlyphs; ++i)
+        glyphs[i].x -= shift;
+    }
+    if (visible) {
+      setSource(cr, paint.fill);
+      cairo_show_text_glyphs(cr, run.text.data(), run.text.size(), glyphs,
+                             numGlyphs, clusters, numClusters, clusterFlags);
+    }
+    if (visible && paint.hasStroke()) {
+      cairo_new_path(cr);
+      cairo_glyph_path(cr, glyphs, numGlyphs);
+      setStroke(cr, list, paint);
+      cairo_stroke(cr);
+    }
+    cairo_text_extents_t extents;
+    cairo_glyph_extents(cr, &glyphs[numGlyphs - 1], 1, &extents);
+    x = glyphs[numGlyphs - 1].x + extents.x_advance;
+    y = glyphs[numGlyphs - 1].y + extents.y_advance;
+  }
+  cairo_glyph_free(glyphs);
+  cairo_text_cluster_free(clusters);
+}
+/// Draws path and text items of a display list at a level of detail
+class ItemPainter {
+public:
+  using Renderer = CairoDisplayListRenderer;
+
+  ItemPainter(cairo_t *cr, Freetype &fonts, const SVGDisplayList &list,
+              const Renderer::LevelOfDetail &lod, Renderer::Statistics &stats)
+      : cr(cr), appender{cr}, faces(fonts), list(list), stats(stats) {
+    // The level of detail in user units
+    double dx = 1., dy = 0.;
+    cairo_user_to_device_distance(cr, &dx, &dy);
+    double deviceScale = std::hypot(dx, dy);
+    tolerance = lod.tolerance / deviceScale;
+    minSize = lod.minSize / deviceScale;
+  }
+
+  /// Whether something of @p bounds is too small to be drawn
+  bool isTiny(const PathData::Bounds &bounds) const {
+    return bounds.x1 - bounds.x0 < minSize && bounds.y1 - bounds.y0 < minSize;
+  }
+
+  void drawPath(const SVGDisplayList::Item &item) {
+    if (isTiny(item.bounds)) {
+      ++stats.dropped;
+      return;
+    }
+    cairo_new_path(cr);
+    if (tolerance > 0.) {
+      PathData path;
+      list.visitPath(item, path);
+      PathData simplified = path.simplify(tolerance);
+      stats.vertices += path.getCoords().size() / 2;
+      stats.simplifiedVertices += simplified.getCoords().size() / 2;
+      simplified.visit(appender);
+    } else
+      list.visitPath(item, appender);
+    const SVGDisplayList::Paint &paint = list.getPaints()[item.paint];
+    // Stroked before filling, like CairoSVGWriter does
+    if (paint.hasStroke()) {
+      setStroke(cr, list, paint);
+      cairo_stroke_preserve(cr);
+    }
+    if (paint.hasFill()) {
+      setSource(cr, paint.fill);
+      cairo_fill_preserve(cr);
+    }
+  }
+
+  /// Draw the run of the text @p item, or only move past it unless
+  /// @p visible
+  void drawText(const SVGDisplayList::Item &item, bool visible) {
+    const SVGDisplayList::TextRun &run = list.getTextRuns()[item.first];
+    if (!run.continues) {
+      textX = run.x;
+      textY = run.y;
+    }
+    ::drawText(cr, run, list.getPaints()[item.paint], list,
+               faces.get(run.fontFamily), textX, textY, visible);
+  }
+
+private:
+  cairo_t *cr;
+  Appender appender;
+  FontFaces faces;
+  const SVGDisplayList &list;
+  Renderer::Statistics &stats;
+  double tolerance, minSize;
+  /// End of the last text run
+  double textX = 0., textY = 0.;
+};
+} // namespace
+
+CairoDisplayListRenderer::Statistics
+CairoDisplayListRenderer::draw(cairo_t *cr, Freetype &fonts) const {
+  const std::vector<SVGDisplayList::Item> &items = list.getItems();
+  Statistics stats;
+  ItemPainter painter(cr, fonts, list, lod, stats);
+  PathData::Bounds visible;
+  cairo_clip_extents(cr, &visible.x0, &visible.y0, &visible.x1, &visible.y1);
+  for (size_t i = 0; i < items.size(); ++i) {
+    const SVGDisplayList::Item &item = items[i];
+    if (item.kind == SVGDisplayList::Kind::GROUP) {
+      bool culled = !item.bounds.intersects(visible);
+      if (!culled && !painter.isTiny(item.bounds))
+        continue;
+      // Skip the whole group
+      for (size_t end = i + item.first; i < end;)
+        if (items[++i].kind != SVGDisplayList::Kind::GROUP) {
+          ++stats.culling.elements;
+          ++(culled ? stats.culling.culled : stats.dropped);
+        }
+      stats.culling.culledGroups += culled;
+      continue;
+    }
+    ++stats.culling.elements;
+    bool culled = !item.bounds.intersects(visible);
+    stats.culling.culled += culled;
+    if (item.kind == SVGDisplayList::Kind::TEXT) {
+      // Culled text is only set if text following it needs its end. Other
+      // children of the text element may be in between.
+      size_t next = i + 1;
+      while (next < items.size() &&
+             items[next].kind != SVGDisplayList::Kind::TEXT)
+        ++next;
+      bool followed = next < items.size() &&
+                      list.getTextRuns()[items[next].first].continues;
+      if (!culled || followed)
+        painter.drawText(item, !culled);
+    } else if (!culled)
+      painter.drawPath(item);
+  }
+  cairo_new_path(cr);
+  return stats;
+}
+
+CairoDisplayListRenderer::Statistics
+CairoDisplayListRenderer::draw(cairo_t *cr, Freetype &fonts,
+                               const std::vector<uint32_t> &indices) const {
+  const std::vector<SVGDisplayList::Item> &items = list.getItems();
+  Statistics stats;
+  ItemPainter painter(cr, fonts, list, lod, stats);
+  // Index after the last item drawn
+  size_t next = 0;
+  for (uint32_t i : indices) {
+    const SVGDisplayList::Item &item = items[i];
+    assert(i >= next && item.kind != SVGDisplayList::Kind::GROUP &&
+           "Expected path and text items in drawing order");
+    ++stats.culling.elements;
+    if (item.kind == SVGDisplayList::Kind::TEXT) {
+      // Text continuing runs that aren't drawn starts at their end. Other
+      // children of the text element may be in between.
+      size_t start = i;
+      while (start > next &&
+             (items[start].kind != SVGDisplayList::Kind::TEXT ||
+              list.getTextRuns()[items[start].first].continues))
+        --start;
+      for (; start < i; ++start)
+        if (items[start].kind == SVGDisplayList::Kind::TEXT)
+          painter.drawText(items[start], false);
+      painter.drawText(item, true);
+    } else
+      painter.drawPath(item);
+    next = i + 1;
+  }
+  cairo_new_path(cr);
+  return stats;
+}
+
+bool CairoDisplayListRenderer::render(const Target &target,
+                                      Statistics *stats) const {
+  std::optional<Freetype> fonts = Freetype::Create();
+  if (!fonts) {
+    std::cerr << "Unable to initialize fonts for " << target.outfile << "\n";
+    return false;
+  }
+  double w = list.getWidth() * target.scale;
+  double h = list.getHeight() * target.scale;
+  double scale = target.scale;
+  cairo_surface_t *surface;
+  if (target.fmt == CairoSVGWriter::PDF) {
+    // cairo pdf units are pt (= 1/72in)
+    scale /= 1.25;
+    surface = cairo_pdf_surface_create(target.outfile.c_str(), w / 1.25,
+                                       h / 1.25);
+  } else
+    surface = cairo_image_surface_create(
+        CAIRO_FORMAT_ARGB32, std::max(1, static_cast<int>(std::ceil(w))),
+        std::max(1, static_cast<int>(std::ceil(h))));
+  cairo_t *cr = cairo_create(surface);
+  cairo_scale(cr, scale, scale);
+  Statistics drawStats = draw(cr, *fonts);
+  if (stats)
+    *stats = drawStats;
+  if (target.fmt == CairoSVGWriter::PDF)
+    cairo_show_page(cr);
+  cairo_status_t status = cairo_status(cr);
+  cairo_destroy(cr);
+  if (!status) {
+    if (target.fmt == CairoSVGWriter::PDF) {
+      cairo_surface_finish(surface);
+      status = cairo_surface_status(surface);
+    } else
+      status = cairo_surface_write_to_png(surface, target.outfile.c_str());
+  }
+  cairo_surface_destroy(surface);
+  if (status) {
+    std::cerr << "Error writing " << target.outfile << ": "
+              << cairo_status_to_string(status) << "\n";
+    return false;
+  }
+  return true;
+}
+
+bool CairoDisplayListRenderer::render(const std::vector<Target> &targets,
+                                      unsigned numThreads,
+                                      Statistics *stats) const {
+  std::atomic<bool> success{true};
+  std::vector<Statistics> targetStats(targets.size());
+  parallelFor(targets.size(), numThreads, [&](size_t i) {
+    if (!render(targets[i], &targetStats[i]))
+      success = false;
+  });
+  if (stats)
+    for (const Statistics &targetStat : targetStats)
+      *stats += targetStat;
+  return success;
+}
@@ -0,0 +1,79 @@
+#include "svgcairo/cairo_path_cache.h"
+#include <cairo/cairo.h>
+
+using namespace svg;
+
+size_t CairoPathCache::hash(std::string_view d, double scale) {
+  size_t res = std::hash<std::string_view>()(d);
+  return res ^ (std::hash<double>()(scale) + 0x9e3779b97f4a7c15ull +
+                (res << 6) + (res >> 2));
+}
+
+size_t CairoPathCache::getBytes(std::string_view d, const cairo_path_t *path) {
+  return sizeof(Entry) + d.size() + sizeof(cairo_path_t) +
+         path->num_data * sizeof(cairo_path_data_t);
+}
+
+const cairo_path_t *CairoPathCache::find(std::string_view d, double scale) {
+  return find(hash(d, scale), d, scale);
+}
+
+const cairo_path_t *CairoPathCache::find(size_t key, std::string_view d,
+                                         double scale) {
+  auto range = index.equal_range(key);
+  for (auto it = range.first; it != range.second; ++it) {
+    Entry &entry = *it->second;
+    if (entry.scale != scale || entry.d != d)
+      continue;
+    ++stats.hits;
+    // Move to the front, iterators stay valid
+    entries.splice(entries.begin(), entries, it->second);
+    return entry.path;
+  }
+  ++stats.misses;
+  return nullptr;
+}
+
+void CairoPathCache::insert(std::string_view d, double scale,
+                            cairo_path_t *path) {
+  insert(hash(d, scale), d, scale, path);
+}
+
+void CairoPathCache::insert(size_t key, std::string_view d, double scale,
+                            cairo_path_t *path) {
+  size_t bytes = getBytes(d, path);
+  if (path->status != CAIRO_STATUS_SUCCESS || bytes > capacity) {
+    cairo_path_destroy(path);
+    return;
+  }
+  makeRoom(bytes);
+  entries.push_front({key, std::string(d), scale, path, bytes});
+  index.emplace(key, entries.begin());
+  ++stats.entries;
+  stats.bytes += bytes;
+}
+
+void CairoPathCache::makeRoom(size_t bytes) {
+  while (entries.size() && stats.bytes + bytes > capacity) {
+    erase(std::prev(entries.end()));
+    ++stats.evictions;
+  }
+}
+
+void CairoPathCache::erase(EntryList::iterator it) {
+  auto range = index.equal_range(it->hash);
+  for (auto indexIt = range.first; indexIt != range.second; ++indexIt)
+    if (indexIt->second == it) {
+      index.erase(indexIt);
+      break;
+    }
+  cairo_path_destroy(it->path);
+  --stats.entries;
+  stats.bytes -= it->bytes;
+  entries.erase(it);
+}
+
+void CairoPathCache::clear() {
+  while (entries.size())
+    erase(entries.begin());
+}
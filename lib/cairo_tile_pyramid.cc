@@ -0,0 +1,122 @@
+#include "svgcairo/cairo_tile_pyramid.h"
+#include "svgutils/utils.h"
+#include <cairo/cairo.h>
+
+#include <atomic>
+#include <cassert>
+#include <cmath>
+
+using namespace svg;
+
+namespace {
+/// Index cells the size of the tiles at the highest zoom level, unless
+/// that is too fine
+double getCellSize(const SVGDisplayList &list, unsigned maxZoom) {
+  double size = std::max(list.getWidth(), list.getHeight());
+  return std::max(std::ldexp(size, -static_cast<int>(maxZoom)),
+                  size / CairoTilePyramid::MaxIndexCells);
+}
+} // namespace
+
+CairoTilePyramid::CairoTilePyramid(const SVGDisplayList &list,
+                                   unsigned maxZoom, unsigned tileSize)
+    : list(list), maxZoom(maxZoom), tileSize(tileSize),
+      index(list, getCellSize(list, maxZoom)), renderer(list) {
+  assert(maxZoom <= MaxZoomLevel && "Too many zoom levels");
+}
+
+double CairoTilePyramid::getScale(unsigned z) const {
+  double base = tileSize / std::max(list.getWidth(), list.getHeight());
+  return std::ldexp(base, z);
+}
+
+unsigned CairoTilePyramid::getColumns(unsigned z) const {
+  return std::max(1., std::ceil(list.getWidth() * getScale(z) / tileSize));
+}
+
+unsigned CairoTilePyramid::getRows(unsigned z) const {
+  return std::max(1., std::ceil(list.getHeight() * getScale(z) / tileSize));
+}
+
+bool CairoTilePyramid::render(
+    const Tile &tile, const fs::path &outfile, Freetype &fonts,
+    CairoDisplayListRenderer::Statistics *stats) const {
+  double scale = getScale(tile.z);
+  double size = tileSize / scale;
+  PathData::Bounds area{tile.x * size, tile.y * size, (tile.x + 1) * size,
+                        (tile.y + 1) * size};
+  std::vector<uint32_t> items = index.query(area);
+
+  cairo_surface_t *surface =
+      cairo_image_surface_create(CAIRO_FORMAT_ARGB32, tileSize, tileSize);
+  cairo_t *cr = cairo_create(surface);
+  cairo_scale(cr, scale, scale);
+  cairo_translate(cr, -area.x0, -area.y0);
+  CairoDisplayListRenderer::Statistics drawStats =
+      renderer.draw(cr, fonts, items);
+  // Items the index didn't return are culled
+  size_t culled = index.getNumItems() - items.size();
+  drawStats.culling.elements += culled;
+  drawStats.culling.culled += culled;
+  if (stats)
+    *stats = drawStats;
+  cairo_status_t status = cairo_status(cr);
+  cairo_destroy(cr);
+  if (!status)
+    status = cairo_surface_write_to_png(surface, outfile.c_str());
+  cairo_surface_destroy(surface);
+  if (status) {
+    std::cerr << "Error writing " << outfile << ": "
+              << cairo_status_to_string(status) << "\n";
+    return false;
+  }
+  return true;
+}
+
+bool CairoTilePyramid::render(
+    unsigned minZoom, const fs::path &outdir, unsigned numThreads,
+    CairoDisplayListRenderer::Statistics *stats) const {
+  // Each thread uses its own fonts and statistics. The last level has the
+  // most tiles.
+  unsigned numWorkers = getNumWorkers(getNumTiles(maxZoom), numThreads);
+  std::vector<Freetype> fonts;
+  for (unsigned i = 0; i < numWorkers; ++i) {
+    std::optional<Freetype> threadFonts = Freetype::Create();
+    if (!threadFonts) {
+      std::cerr << "Unable to initialize fonts\n";
+      return false;
+    }
+    fonts.push_back(std::move(*threadFonts));
+  }
+  std::vector<CairoDisplayListRenderer::Statistics> workerStats(numWorkers);
+  std::atomic<bool> success{true};
+  for (unsigned z = minZoom; z <= maxZoom && success; ++z) {
+    // Directories are created up front, one per column
+    unsigned rows = getRows(z);
+    for (unsigned x = 0, columns = getColumns(z); x < columns; ++x) {
+      fs::path dir = outdir / std::to_string(z) / std::to_string(x);
+      std::error_code ec;
+      fs::create_directories(dir, ec);
+      if (ec) {
+        std::cerr << "Unable to create " << dir << ": " << ec.message()
+                  << "\n";
+        return false;
+      }
+    }
+    parallelFor(getNumTiles(z), numThreads, [&](size_t i, unsigned worker) {
+      Tile tile{z, static_cast<unsigned>(i / rows),
+                static_cast<unsigned>(i % rows)};
+      fs::path outfile = outdir / std::to_string(tile.z) /
+                         std::to_string(tile.x) /
+                         (std::to_string(tile.y) + ".png");
+      CairoDisplayListRenderer::Statistics tileStats;
+      if (!render(tile, outfile, fonts[worker], &tileStats))
+        success = false;
+      workerStats[worker] += tileStats;
+    });
+  }
+  if (stats)
+    for (const CairoDisplayListRenderer::Statistics &workerStat : workerStats)
+      *stats += workerStat;
+  return success;
+}
@@ -0,0 +1,482 @@
+#include "svgutils/canvas_writer.h"
+#include "svgutils/svg_lengths.h"
+#include "svgutils/svg_minifying_writer.h"
+#include "svgutils/svg_path_data.h"
+
+#include <cmath>
+#include <cstring>
+#include <sstream>
+
+using namespace svg;
+
+const char *const SVGCanvasWriter::Interpreter =
+    R"(if (typeof SVGCanvasReplay === 'undefined')
+  var SVGCanvasReplay = function(c, ops, strs) {
+    for (var i = 0, n = ops.length, k; i < n;) {
+      switch (ops[i++]) {
+      case 0: c.beginPath(); break;
+      case 1: c.moveTo(ops[i], ops[i + 1]); i += 2; break;
+      case 2: c.lineTo(ops[i], ops[i + 1]); i += 2; break;
+      case 3:
+        c.bezierCurveTo(ops[i], ops[i + 1], ops[i + 2], ops[i + 3],
+                        ops[i + 4], ops[i + 5]);
+        i += 6;
+        break;
+      case 4:
+        c.rect(ops[i], ops[i + 1], ops[i + 2], ops[i + 3]);
+        i += 4;
+        break;
+      case 5:
+        c.ellipse(ops[i], ops[i + 1], ops[i + 2], ops[i + 3], 0, 0,
+                  2 * Math.PI);
+        i += 4;
+        break;
+      case 6: c.closePath(); break;
+      case 7: c.fill(); break;
+      case 8: c.stroke(); break;
+      case 9: c.fillStyle = strs[ops[i++]]; break;
+      case 10: c.strokeStyle = strs[ops[i++]]; break;
+      case 11: c.lineWidth = ops[i++]; break;
+      case 12: k = ops[i++]; c.setLineDash(ops.slice(i, i += k)); break;
+      case 13: c.font = strs[ops[i++]]; break;
+      case 14: c.textAlign = strs[ops[i++]]; break;
+      case 15:
+        c.fillText(strs[ops[i]], ops[i + 1], ops[i + 2]);
+        i += 3;
+        break;
+      case 16:
+        c.strokeText(strs[ops[i]], ops[i + 1], ops[i + 2]);
+        i += 3;
+        break;
+      }
+    }
+  };
+)";
+
+namespace {
+/// Color in a notation canvas styles accept, omitting the alpha channel if
+/// the color is opaque
+std::string toCanvasColor(const CSSColor &color) {
+  std::stringstream ss;
+  ss << color;
+  std::string str = ss.str();
+  if (color.a >= 1.)
+    str.resize(7);
+  return str;
+}
+
+const char *getCallName(SVGCanvasWriter::Op op) {
+  using Op = SVGCanvasWriter::Op;
+  switch (op) {
+  case Op::BEGIN_PATH:
+    return "beginPath";
+  case Op::MOVE_TO:
+    return "moveTo";
+  case Op::LINE_TO:
+    return "lineTo";
+  case Op::CUBIC_TO:
+    return "bezierCurveTo";
+  case Op::RECT:
+    return "rect";
+  case Op::ELLIPSE:
+    return "ellipse";
+  case Op::CLOSE_PATH:
+    return "closePath";
+  case Op::FILL:
+    return "fill";
+  case Op::STROKE:
+    return "stroke";
+  case Op::FILL_STYLE:
+    return "fillStyle";
+  case Op::STROKE_STYLE:
+    return "strokeStyle";
+  case Op::LINE_WIDTH:
+    return "lineWidth";
+  case Op::LINE_DASH:
+    return "setLineDash";
+  case Op::FONT:
+    return "font";
+  case Op::TEXT_ALIGN:
+    return "textAlign";
+  case Op::FILL_TEXT:
+    return "fillText";
+  case Op::STROKE_TEXT:
+    return "strokeText";
+  }
+  svg_unreachable("Unknown canvas operation");
+}
+
+bool isProperty(SVGCanvasWriter::Op op) {
+  using Op = SVGCanvasWriter::Op;
+  return op == Op::FILL_STYLE || op == Op::STROKE_STYLE ||
+         op == Op::LINE_WIDTH || op == Op::FONT || op == Op::TEXT_ALIGN;
+}
+} // namespace
+
+SVGCanvasWriter::SVGCanvasWriter(outstream_t &os, Mode mode,
+                                 const char *ContextName, unsigned precision)
+    : base_t(os), mode(mode), contextName(ContextName),
+      precision(std::min(precision, SVGMinifyingWriter::MaxPrecision)) {}
+
+SVGCanvasWriter::RetTy SVGCanvasWriter::enter() {
+  assert(currentTag && "Cannot enter without root tag");
+  if (ignore || !rendersChildren(currentTag))
+    ++ignore;
+  return base_t::enter();
+}
+SVGCanvasWriter::RetTy SVGCanvasWriter::leave() {
+  if (auto res = base_t::leave())
+    return res;
+  if (ignore)
+    --ignore;
+  return this;
+}
+SVGCanvasWriter::RetTy SVGCanvasWriter::finish() {
+  if (auto res = base_t::finish())
+    return res;
+  ignore = 0;
+  // Nothing to do if nothing was drawn at all
+  if (!started)
+    return this;
+  if (mode == Mode::CALLS)
+    output() << "})(" << contextName << ");\n";
+  else {
+    output() << "],\n[";
+    for (size_t i = 0; i < strings.size(); ++i) {
+      if (i)
+        output() << ",";
+      writeJSString(output(), *strings[i]);
+    }
+    output() << "]);\n";
+  }
+  started = false;
+  state = CanvasState();
+  stringIndices.clear();
+  strings.clear();
+  return this;
+}
+
+SVGCanvasWriter::RetTy SVGCanvasWriter::content(const char *text) {
+  closeTag();
+  if (!text || parents.empty())
+    return this;
+  // Stylesheets apply even if they are in e.g. <defs>
+  if (!std::strcmp(parents.top(), "style")) {
+    styles.addStylesheet(text);
+    return this;
+  }
+  if (ignore || std::strcmp(parents.top(), "text"))
+    return this;
+  std::string font = getFont();
+  if (font != state.font) {
+    emit(Op::FONT, font);
+    state.font = font;
+  }
+  const char *align = "start";
+  switch (styles.getTextAnchor()) {
+  case CSSTextAnchor::START:
+    break;
+  case CSSTextAnchor::MIDDLE:
+    align = "center";
+    break;
+  case CSSTextAnchor::END:
+    align = "end";
+    break;
+  }
+  if (align != state.textAlign) {
+    emit(Op::TEXT_ALIGN, align);
+    state.textAlign = align;
+  }
+  if (CSSColor fill = styles.getFill()) {
+    setFillStyle(fill);
+    emit(Op::FILL_TEXT, text, {textX, textY});
+  }
+  CSSColor stroke = styles.getStroke();
+  double strokeWidth = toPixels(styles.getStrokeWidth(), getDiagonal());
+  if (stroke && strokeWidth != 0.) {
+    setStrokeStyle(stroke, strokeWidth);
+    emit(Op::STROKE_TEXT, text, {textX, textY});
+  }
+  return this;
+}
+
+void SVGCanvasWriter::openTag(const char *tagname,
+                              const std::vector<SVGAttribute> &attrs) {
+  closeTag();
+  currentTag = tagname;
+  styles.push(attrs, tagname);
+  if (ignore)
+    return;
+  auto is = [tagname](const char *name) { return !std::strcmp(tagname, name); };
+  if (is("svg"))
+    readDimensions(attrs);
+  else if (is("rect"))
+    drawRect(attrs);
+  else if (is("circle") || is("ellipse"))
+    drawEllipse(attrs, is("circle"));
+  else if (is("line"))
+    drawLine(attrs);
+  else if (is("path")) {
+    if (const SVGAttribute *d = findAttr(attrs, "d"))
+      drawPath(PathData::parse(d->getValueStr()));
+  } else if (is("polyline") || is("polygon")) {
+    if (const SVGAttribute *points = findAttr(attrs, "points"))
+      drawPath(PathData::fromPoints(points->getValueStr(), is("polygon")));
+  } else if (is("text"))
+    startText(attrs);
+}
+
+void SVGCanvasWriter::closeTag() {
+  if (!currentTag)
+    return;
+  styles.pop();
+  currentTag = nullptr;
+}
+
+void SVGCanvasWriter::readDimensions(const std::vector<SVGAttribute> &attrs) {
+  // Nested svg elements don't change what percentages refer to here
+  if (parents.size())
+    return;
+  double w = getLength(attrs, "width", docWidth);
+  double h = getLength(attrs, "height", docHeight);
+  if (w > 0.)
+    docWidth = w;
+  if (h > 0.)
+    docHeight = h;
+}
+
+void SVGCanvasWriter::drawRect(const std::vector<SVGAttribute> &attrs) {
+  if (!hasPaint())
+    return;
+  double w = getLength(attrs, "width", docWidth);
+  double h = getLength(attrs, "height", docHeight);
+  if (w <= 0. || h <= 0.)
+    return;
+  emit(Op::BEGIN_PATH);
+  emit(Op::RECT, {getLength(attrs, "x", docWidth),
+                  getLength(attrs, "y", docHeight), w, h});
+  paint();
+}
+
+void SVGCanvasWriter::drawEllipse(const std::vector<SVGAttribute> &attrs,
+                                  bool circle) {
+  if (!hasPaint())
+    return;
+  double rx = getLength(attrs, circle ? "r" : "rx", docWidth);
+  double ry = circle ? rx : getLength(attrs, "ry", docHeight);
+  if (rx <= 0. || ry <= 0.)
+    return;
+  emit(Op::BEGIN_PATH);
+  emit(Op::ELLIPSE, {getLength(attrs, "cx", docWidth),
+                     getLength(attrs, "cy", docHeight), rx, ry});
+  paint();
+}
+
+void SVGCanvasWriter::drawLine(const std::vector<SVGAttribute> &attrs) {
+  // Lines have no inside to fill
+  if (!hasPaint(false))
+    return;
+  emit(Op::BEGIN_PATH);
+  emit(Op::MOVE_TO, {getLength(attrs, "x1", docWidth),
+                     getLength(attrs, "y1", docHeight)});
+  emit(Op::LINE_TO, {getLength(attrs, "x2", docWidth),
+                     getLength(attrs, "y2", docHeight)});
+  paint(false);
+}
+
+void SVGCanvasWriter::drawPath(const PathData &path) {
+  if (path.empty() || !hasPaint())
+    return;
+  struct Emitter {
+    SVGCanvasWriter &writer;
+    void moveTo(double x, double y) { writer.emit(Op::MOVE_TO, {x, y}); }
+    void lineTo(double x, double y) { writer.emit(Op::LINE_TO, {x, y}); }
+    void cubicTo(double x1, double y1, double x2, double y2, double x,
+                 double y) {
+      writer.emit(Op::CUBIC_TO, {x1, y1, x2, y2, x, y});
+    }
+    void close() { writer.emit(Op::CLOSE_PATH); }
+  } emitter{*this};
+  emit(Op::BEGIN_PATH);
+  path.visit(emitter);
+  paint();
+}
+
+void SVGCanvasWriter::startText(const std::vector<SVGAttribute> &attrs) {
+  textX = getLength(attrs, "x", docWidth);
+  textY = getLength(attrs, "y", docHeight);
+}
+
+bool SVGCanvasWriter::hasPaint(bool fill) const {
+  if (fill && styles.getFill())
+    return true;
+  return styles.getStroke() &&
+         toPixels(styles.getStrokeWidth(), getDiagonal()) != 0.;
+}
+
+void SVGCanvasWriter::paint(bool fill) {
+  if (fill) {
+    if (CSSColor color = styles.getFill()) {
+      setFillStyle(color);
+      emit(Op::FILL);
+    }
+  }
+  CSSColor stroke = styles.getStroke();
+  double strokeWidth = toPixels(styles.getStrokeWidth(), getDiagonal());
+  if (stroke && strokeWidth != 0.) {
+    setStrokeStyle(stroke, strokeWidth);
+    emit(Op::STROKE);
+  }
+}
+
+double SVGCanvasWriter::getDiagonal() const {
+  return svg::getDiagonal(docWidth, docHeight);
+}
+
+std::string SVGCanvasWriter::getFont() const {
+  std::string font =
+      SVGMinifyingWriter::formatNumber(
+          toPixels(styles.getFontSize(), docWidth), precision) +
+      "px ";
+  font += styles.getFontFamily();
+  return font;
+}
+
+void SVGCanvasWriter::setFillStyle(const CSSColor &color) {
+  std::string style = toCanvasColor(color);
+  if (style == state.fillStyle)
+    return;
+  emit(Op::FILL_STYLE, style);
+  state.fillStyle = std::move(style);
+}
+
+void SVGCanvasWriter::setStrokeStyle(const CSSColor &color, double width) {
+  std::string style = toCanvasColor(color);
+  if (style != state.strokeStyle) {
+    emit(Op::STROKE_STYLE, style);
+    state.strokeStyle = std::move(style);
+  }
+  if (width != state.lineWidth) {
+    emit(Op::LINE_WIDTH, {width});
+    state.lineWidth = width;
+  }
+  std::vector<double> dashes;
+  for (const CSSUnit &len : styles.getStrokeDasharray().dashes)
+    dashes.push_back(toPixels(len, getDiagonal()));
+  if (dashes != state.lineDash) {
+    start();
+    if (mode == Mode::CALLS) {
+      output() << "c.setLineDash([";
+      for (size_t i = 0; i < dashes.size(); ++i) {
+        if (i)
+          output() << ",";
+        writeNumber(dashes[i]);
+      }
+      output() << "]);";
+    } else {
+      separate();
+      output() << static_cast<int>(Op::LINE_DASH);
+      separate();
+      output() << dashes.size();
+      for (double dash : dashes) {
+        separate();
+        writeNumber(dash);
+      }
+    }
+    state.lineDash = std::move(dashes);
+  }
+}
+
+void SVGCanvasWriter::emit(Op op, std::initializer_list<double> args) {
+  start();
+  if (mode == Mode::COMMANDS) {
+    separate();
+    output() << static_cast<int>(op);
+    for (double arg : args) {
+      separate();
+      writeNumber(arg);
+    }
+    return;
+  }
+  output() << "c." << getCallName(op);
+  if (isProperty(op)) {
+    output() << "=";
+    writeNumber(*args.begin());
+    output() << ";";
+    return;
+  }
+  output() << "(";
+  for (const double *arg = args.begin(); arg != args.end(); ++arg) {
+    if (arg != args.begin())
+      output() << ",";
+    writeNumber(*arg);
+  }
+  if (op == Op::ELLIPSE)
+    output() << ",0,0,2*Math.PI";
+  output() << ");";
+  // One line per shape
+  if (op == Op::FILL || op == Op::STROKE)
+    output() << "\n";
+}
+
+void SVGCanvasWriter::emit(Op op, const std::string &str,
+                           std::initializer_list<double> args) {
+  start();
+  if (mode == Mode::COMMANDS) {
+    separate();
+    output() << static_cast<int>(op);
+    separate();
+    output() << intern(str);
+    for (double arg : args) {
+      separate();
+      writeNumber(arg);
+    }
+    return;
+  }
+  output() << "c." << getCallName(op);
+  if (isProperty(op)) {
+    output() << "=";
+    writeJSString(output(), str);
+    output() << ";";
+    return;
+  }
+  output() << "(";
+  writeJSString(output(), str);
+  for (double arg : args) {
+    output() << ",";
+    writeNumber(arg);
+  }
+  output() << ");\n";
+}
+
+void SVGCanvasWriter::writeNumber(double value) {
+  output() << SVGMinifyingWriter::formatNumber(value, precision);
+}
+
+void SVGCanvasWriter::separate() {
+  static constexpr size_t ValuesPerLine = 64;
+  if (valuesInLine == ValuesPerLine) {
+    output() << ",\n";
+    valuesInLine = 0;
+  } else if (valuesInLine)
+    output() << ",";
+  ++valuesInLine;
+}
+
+void SVGCanvasWriter::start() {
+  if (started)
+    return;
+  started = true;
+  valuesInLine = 0;
+  if (mode == Mode::CALLS)
+    output() << "(function(c) {\n";
+  else
+    output() << Interpreter << "SVGCanvasReplay(" << contextName << ",\n[";
+}
+
+size_t SVGCanvasWriter::intern(const std::string &str) {
+  auto it = stringIndices.emplace(str, strings.size()).first;
+  if (it->second == strings.size())
+    strings.push_back(&it->first);
+  return it->second;
+}
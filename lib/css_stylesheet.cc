@@ -0,0 +1,207 @@
+#include "svgutils/css_stylesheet.h"
+
+#include <algorithm>
+
+using namespace svg;
+
+namespace {
+/// @p css without comments
+std::string stripComments(std::string_view css) {
+  std::string res;
+  res.reserve(css.size());
+  while (css.size()) {
+    size_t start = css.find("/*");
+    res.append(css.substr(0, start));
+    if (start == css.npos)
+      break;
+    size_t end = css.find("*/", start + 2);
+    css = end == css.npos ? std::string_view() : css.substr(end + 2);
+    // Comments separate tokens like whitespace
+    res.push_back(' ');
+  }
+  return res;
+}
+
+/// Remove the at-rule at the start of @p css, which is either terminated by
+/// a semicolon or by a (nested) block
+void skipAtRule(std::string_view &css) {
+  size_t end = css.find_first_of(";{");
+  if (end == css.npos || css[end] == ';') {
+    css = end == css.npos ? std::string_view() : css.substr(end + 1);
+    return;
+  }
+  size_t depth = 0;
+  for (size_t pos = end; pos < css.size(); ++pos) {
+    if (css[pos] == '{')
+      ++depth;
+    else if (css[pos] == '}' && !--depth) {
+      css = css.substr(pos + 1);
+      return;
+    }
+  }
+  css = std::string_view();
+}
+
+/// Remove the next class name from the whitespace-separated @p classes
+std::string_view nextClass(std::string_view &classes) {
+  size_t start = 0;
+  while (start < classes.size() &&
+         std::isspace(static_cast<unsigned char>(classes[start])))
+    ++start;
+  size_t end = start;
+  while (end < classes.size() &&
+         !std::isspace(static_cast<unsigned char>(classes[end])))
+    ++end;
+  std::string_view name = classes.substr(start, end - start);
+  classes.remove_prefix(end);
+  return name;
+}
+
+bool hasClass(std::string_view classes, std::string_view name) {
+  while (classes.size())
+    if (nextClass(classes) == name)
+      return true;
+  return false;
+}
+
+bool isNameChar(char c) {
+  return std::isalnum(static_cast<unsigned char>(c)) || c == '-' || c == '_' ||
+         static_cast<unsigned char>(c) >= 0x80;
+}
+} // namespace
+
+void CSSStylesheet::parse(std::string_view css) {
+  std::string text = stripComments(css);
+  std::string_view rest = text;
+  while ((rest = strview_trim(rest)).size()) {
+    if (rest.front() == '@') {
+      skipAtRule(rest);
+      continue;
+    }
+    size_t open = rest.find('{');
+    if (open == rest.npos)
+      return;
+    size_t close = std::min(rest.find('}', open), rest.size());
+    std::string_view selectors = rest.substr(0, open);
+    std::string_view block = rest.substr(open + 1, close - open - 1);
+    rest = rest.substr(std::min(close + 1, rest.size()));
+
+    std::vector<Declaration> declarations;
+    forEachCSSDeclaration(
+        block, [&declarations](std::string_view name, std::string_view value) {
+          if (auto style = StyleTracker::findStyle(name))
+            declarations.push_back({*style, std::string(value)});
+        });
+    if (declarations.empty())
+      continue;
+    auto rule = static_cast<uint32_t>(Rules.size());
+    bool used = false;
+    while (selectors.size()) {
+      size_t comma = selectors.find(',');
+      std::string_view selectorText = strview_trim(selectors.substr(0, comma));
+      selectors = comma == selectors.npos ? std::string_view()
+                                          : selectors.substr(comma + 1);
+      Selector selector;
+      if (!parseSelector(selectorText, selector))
+        continue;
+      selector.rule = rule;
+      addSelector(std::move(selector));
+      used = true;
+    }
+    if (used)
+      Rules.push_back(std::move(declarations));
+  }
+}
+
+bool CSSStylesheet::parseSelector(std::string_view text, Selector &selector) {
+  size_t pos = 0;
+  auto readName = [&]() {
+    size_t start = pos;
+    while (pos < text.size() && isNameChar(text[pos]))
+      ++pos;
+    return text.substr(start, pos - start);
+  };
+  if (text.empty())
+    return false;
+  if (text.front() == '*')
+    ++pos;
+  else
+    selector.tag = readName();
+  while (pos < text.size()) {
+    char kind = text[pos++];
+    std::string_view name = readName();
+    if (name.empty())
+      return false;
+    if (kind == '#') {
+      // An element only has one id
+      if (selector.id.size() && selector.id != name)
+        return false;
+      selector.id = name;
+    } else if (kind == '.')
+      selector.classes.emplace_back(name);
+    else
+      return false;
+  }
+  // Ids, classes and tags, in decreasing weight
+  selector.specificity = (selector.id.empty() ? 0u : 1u) << 20 |
+                         static_cast<uint32_t>(selector.classes.size()) << 10 |
+                         (selector.tag.empty() ? 0u : 1u);
+  return true;
+}
+
+void CSSStylesheet::addSelector(Selector &&selector) {
+  auto index = static_cast<uint32_t>(Selectors.size());
+  const Selector &added = Selectors.emplace_back(std::move(selector));
+  if (added.id.size())
+    ById[added.id].push_back(index);
+  else if (added.classes.size())
+    ByClass[added.classes.front()].push_back(index);
+  else if (added.tag.size())
+    ByTag[added.tag].push_back(index);
+  else
+    Universal.push_back(index);
+}
+
+bool CSSStylesheet::matches(const Selector &selector, const Element &element) {
+  if (selector.tag.size() && selector.tag != element.tag)
+    return false;
+  if (selector.id.size() && selector.id != element.id)
+    return false;
+  for (const std::string &name : selector.classes)
+    if (!hasClass(element.classes, name))
+      return false;
+  return true;
+}
+
+void CSSStylesheet::addMatches(const Bucket *bucket, const Element &element,
+                               std::vector<Match> &matches) const {
+  if (!bucket)
+    return;
+  for (uint32_t index : *bucket) {
+    const Selector &selector = Selectors[index];
+    if (CSSStylesheet::matches(selector, element))
+      matches.emplace_back(selector.specificity, selector.rule);
+  }
+}
+
+void CSSStylesheet::match(const Element &element,
+                          std::vector<Match> &matches) const {
+  matches.clear();
+  if (Selectors.empty())
+    return;
+  if (element.id.size())
+    addMatches(find(ById, element.id), element, matches);
+  std::string_view classes = element.classes;
+  while (classes.size()) {
+    std::string_view name = nextClass(classes);
+    std::string_view before =
+        element.classes.substr(0, name.data() - element.classes.data());
+    // The bucket of a repeated class was searched already
+    if (name.size() && !hasClass(before, name))
+      addMatches(find(ByClass, name), element, matches);
+  }
+  if (element.tag.size())
+    addMatches(find(ByTag, element.tag), element, matches);
+  addMatches(&Universal, element, matches);
+  std::sort(matches.begin(), matches.end());
+}
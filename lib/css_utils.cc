@@ -1,100 +1,206 @@
 #include "svgutils/css_utils.h"
+#include "svgutils/css_stylesheet.h"
 #include "svgutils/svg_writer.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <limits>
 
 using namespace svg;
 
-static const char *mapColorNameToValue(std::string_view name) {
-#define CSS_COLOR(NAME, VALUE)                                                 \
-  if (name == NAME)                                                            \
-    return VALUE;
+namespace {
+constexpr int hexDigit(char c) {
+  if ('0' <= c && c <= '9')
+    return c - '0';
+  if ('a' <= c && c <= 'f')
+    return c - 'a' + 10;
+  if ('A' <= c && c <= 'F')
+    return c - 'A' + 10;
+  return -1;
+}
+
+constexpr char toLower(char c) {
+  return 'A' <= c && c <= 'Z' ? c - 'A' + 'a' : c;
+}
+
+/// Color of a valid `#rrggbb` or `#rrggbbaa` string
+constexpr CSSColor hexColor(std::string_view hex) {
+  auto channel = [hex](size_t i) {
+    return (hexDigit(hex[i]) * 16 + hexDigit(hex[i + 1])) / 255.;
+  };
+  return CSSColor(channel(1), channel(3), channel(5),
+                  hex.size() == 9 ? channel(7) : 1.);
+}
+
+struct NamedColor {
+  std::string_view name;
+  CSSColor color;
+};
+
+constexpr NamedColor NamedColors[] = {
+#define CSS_COLOR(NAME, VALUE) {NAME, hexColor(VALUE)},
 #include "svgutils/css_colors.def"
-  return "#000000";
-}
-
-static size_t cvtHexChars(char higher, char lower) {
-  size_t result;
-  if ('0' <= higher && higher <= '9')
-    result = ((size_t)(higher - '0')) << 4;
-  else if ('A' <= higher && higher <= 'Z')
-    result = ((size_t)(higher - 'A' + 10)) << 4;
-  else if ('a' <= higher && higher <= 'z')
-    result = ((size_t)(higher - 'a' + 10)) << 4;
-  else
-    svg_unreachable("Higher hex character not in valid range");
-
-  if ('0' <= lower && lower <= '9')
-    result += lower - '0';
-  else if ('A' <= lower && lower <= 'Z')
-    result += lower - 'A' + 10;
-  else if ('a' <= lower && lower <= 'z')
-    result += lower - 'a' + 10;
-  else
-    svg_unreachable("Lower hex character not in valid range");
-  return result;
+};
+constexpr size_t NumNamedColors = sizeof(NamedColors) / sizeof(NamedColor);
+
+/// FNV-1a of the lowercased @p name, varied by @p seed
+constexpr uint32_t hashColorName(std::string_view name, uint32_t seed) {
+  uint32_t hash = 2166136261u ^ seed;
+  for (char c : name) {
+    hash ^= static_cast<uint8_t>(toLower(c));
+    hash *= 16777619u;
+  }
+  // Mix the high bits into the low ones used for the slot
+  hash ^= hash >> 16;
+  hash *= 0x85ebca6bu;
+  return hash ^ (hash >> 13);
+}
+
+/// Perfect hash table of the color names: The seed is chosen such that no
+/// two names hash to the same slot, so a lookup is a single comparison.
+struct ColorNameTable {
+  static constexpr size_t Size = 2048;
+  static constexpr uint8_t Empty = 0xff;
+  static_assert(NumNamedColors < Empty, "Too many colors for uint8_t slots");
+
+  uint32_t seed = 0;
+  uint8_t slots[Size] = {};
+  bool valid = false;
+
+  static constexpr size_t slot(std::string_view name, uint32_t seed) {
+    return hashColorName(name, seed) % Size;
+  }
+};
+
+constexpr ColorNameTable buildColorNameTable() {
+  ColorNameTable table;
+  // Slots taken by the current seed are marked with seed + 1, so they don't
+  // need to be cleared for every seed tried
+  uint16_t taken[ColorNameTable::Size] = {};
+  for (uint16_t seed = 0; seed < 10000 && !table.valid; ++seed) {
+    table.valid = true;
+    for (size_t i = 0; i < NumNamedColors && table.valid; ++i) {
+      uint16_t &mark = taken[ColorNameTable::slot(NamedColors[i].name, seed)];
+      table.valid = mark != seed + 1;
+      mark = seed + 1;
+    }
+    table.seed = seed;
+  }
+  for (uint8_t &slot : table.slots)
+    slot = ColorNameTable::Empty;
+  for (size_t i = 0; i < NumNamedColors; ++i)
+    table.slots[ColorNameTable::slot(NamedColors[i].name, table.seed)] =
+        static_cast<uint8_t>(i);
+  return table;
 }
 
-static CSSColor parseHexColor(std::string_view hex) {
+constexpr ColorNameTable ColorNames = buildColorNameTable();
+static_assert(ColorNames.valid, "No perfect hash found for the color names");
+
+CSSColor parseHexColor(std::string_view hex) {
   assert(hex.front() == '#' &&
          "Expected hex color but first character is not #");
+  hex.remove_prefix(1);
+  // #rgb and #rgba are short for #rrggbb and #rrggbbaa
+  bool shortForm = hex.size() == 3 || hex.size() == 4;
+  if (!shortForm && hex.size() != 6 && hex.size() != 8)
+    return CSSColor();
+  size_t digitsPerChannel = shortForm ? 1 : 2;
   CSSColor result;
-  if (hex.size() == 4) {
-    result.r = cvtHexChars(hex[1], hex[1]) / 255.;
-    result.g = cvtHexChars(hex[2], hex[2]) / 255.;
-    result.b = cvtHexChars(hex[3], hex[3]) / 255.;
-  } else if (hex.size() == 5) {
-    result.r = cvtHexChars(hex[1], hex[1]) / 255.;
-    result.g = cvtHexChars(hex[2], hex[2]) / 255.;
-    result.b = cvtHexChars(hex[3], hex[3]) / 255.;
-    result.a = cvtHexChars(hex[4], hex[4]) / 255.;
-  } else if (hex.size() == 7) {
-    result.r = cvtHexChars(hex[1], hex[2]) / 255.;
-    result.g = cvtHexChars(hex[3], hex[4]) / 255.;
-    result.b = cvtHexChars(hex[5], hex[6]) / 255.;
-  } else if (hex.size() == 9) {
-    result.r = cvtHexChars(hex[1], hex[2]) / 255.;
-    result.g = cvtHexChars(hex[3], hex[4]) / 255.;
-    result.b = cvtHexChars(hex[5], hex[6]) / 255.;
-    result.a = cvtHexChars(hex[7], hex[8]) / 255.;
+  for (size_t i = 0; i < hex.size() / digitsPerChannel; ++i) {
+    int high = hexDigit(hex[i * digitsPerChannel]);
+    int low = hexDigit(hex[i * digitsPerChannel + digitsPerChannel - 1]);
+    if (high < 0 || low < 0)
+      return CSSColor();
+    result[i] = (high * 16 + low) / 255.;
   }
   return result;
 }
 
-static CSSColor parseColorFromTuple(std::string_view tuple) {
-  CSSColor result;
-  assert(tuple.front() == '(' && tuple.back() == ')' &&
-         "Color tuple should be enclosed in parens '()'");
-  int component = 0;
-  do {
-    // find the start of the component value.
-    // NOTE: We don't look fo '+' because that isn't allowed by from_chars
-    auto begin = tuple.find_first_of(".0123456789", 1);
-    if (begin == std::string_view::npos)
-      break;
-    // find its end
-    auto end = tuple.find_first_of(" ,)", begin);
-    std::string_view val = tuple.substr(begin, end - begin);
-    // check if this is a percentage
-    bool percentage = val.back() == '%';
-    if (percentage)
-      val = val.substr(0, val.size() - 1);
-    // parse the component value from val
-    auto c = strview_to_double(val);
-    if (c) {
-      if (percentage)
-        *c /= 100.;
-      result[component] = *c;
-    } else {
-      // exit early on error
-      return CSSColor();
+/// Arguments of a color function, e.g. `255, 0, 0` of `rgb(255, 0, 0)`.
+/// Both the legacy comma-separated syntax and the space-separated one with
+/// `/` before the alpha value are accepted.
+struct ColorArgs {
+  double values[4] = {0., 0., 0., 1.};
+  bool percent[4] = {};
+  size_t count = 0;
+
+  bool scan(std::string_view args) {
+    size_t pos = 0;
+    while (true) {
+      while (pos < args.size() &&
+             (std::isspace(static_cast<unsigned char>(args[pos])) ||
+              args[pos] == ',' || args[pos] == '/'))
+        ++pos;
+      if (pos == args.size())
+        return count >= 3;
+      size_t len = strview_scan_number(args.substr(pos));
+      if (!len || count == 4)
+        return false;
+      values[count] = parseNumber(args.substr(pos, len));
+      pos += len;
+      if (pos < args.size() && args[pos] == '%') {
+        percent[count] = true;
+        ++pos;
+      } else if (args.substr(pos, 3) == "deg") {
+        pos += 3;
+      }
+      ++count;
     }
-    tuple = tuple.substr(end + 1);
-    ++component;
-  } while (tuple.size() && component < 4);
+  }
+  /// The alpha value as a fraction
+  double alpha() const { return percent[3] ? values[3] / 100. : values[3]; }
+
+  static double parseNumber(std::string_view number) {
+    char buf[64];
+    size_t len = std::min(number.size(), sizeof(buf) - 1);
+    std::memcpy(buf, number.data(), len);
+    buf[len] = '\0';
+    return std::strtod(buf, nullptr);
+  }
+};
+
+CSSColor parseRGBArgs(std::string_view argStr) {
+  ColorArgs args;
+  if (!args.scan(argStr))
+    return CSSColor();
+  CSSColor result;
+  for (size_t i = 0; i < 3; ++i)
+    result[i] = args.values[i] / (args.percent[i] ? 100. : 255.);
+  result.a = args.alpha();
+  result.clamp();
   return result;
 }
 
+CSSColor parseHSLArgs(std::string_view argStr) {
+  ColorArgs args;
+  if (!args.scan(argStr))
+    return CSSColor();
+  // hsl2rgb expects the hue in sixths of a turn, saturation and lightness
+  // as fractions
+  CSSColor hsl(0., args.values[1] / 100., args.values[2] / 100., args.alpha());
+  hsl.clamp();
+  hsl.r = std::fmod(args.values[0] / 60., 6.);
+  if (hsl.r < 0.)
+    hsl.r += 6.;
+  return hsl.hsl2rgb();
+}
+} // namespace
+
+std::optional<CSSColor> CSSColor::fromName(std::string_view name) {
+  uint8_t slot = ColorNames.slots[ColorNameTable::slot(name, ColorNames.seed)];
+  if (slot == ColorNameTable::Empty)
+    return std::nullopt;
+  const NamedColor &entry = NamedColors[slot];
+  if (entry.name.size() != name.size())
+    return std::nullopt;
+  for (size_t i = 0; i < name.size(); ++i)
+    if (toLower(name[i]) != entry.name[i])
+      return std::nullopt;
+  return entry.color;
+}
+
 void CSSColor::clamp() {
   r = std::min(1., std::max(0., r));
   g = std::min(1., std::max(0., g));
@@ -159,21 +265,24 @@ CSSColor CSSColor::rgb2hsl() const {
 }
 
 CSSColor CSSColor::parse(std::string_view str) {
+  str = strview_trim(str);
+  if (str.empty())
+    return CSSColor();
   if (str == "none")
     return CSSColor(0., 0., 0., 0.);
   if (str.front() == '#')
     return parseHexColor(str);
-  const auto front4 = str.substr(0, 4);
-  if (front4 == "rgb(")
-    return parseColorFromTuple(str.substr(3));
-  if (front4 == "hsl(")
-    return parseColorFromTuple(str.substr(3)).hsl2rgb();
-  const auto front5 = str.substr(0, 5);
-  if (front5 == "rgba(")
-    return parseColorFromTuple(str.substr(4));
-  if (front5 == "hsla(")
-    return parseColorFromTuple(str.substr(4)).hsl2rgb();
-  return parse(mapColorNameToValue(str));
+  size_t open = str.find('(');
+  if (open != str.npos && str.back() == ')') {
+    std::string_view function = str.substr(0, open);
+    std::string_view args = str.substr(open + 1, str.size() - open - 2);
+    if (function == "rgb" || function == "rgba")
+      return parseRGBArgs(args);
+    if (function == "hsl" || function == "hsla")
+      return parseHSLArgs(args);
+    return CSSColor();
+  }
+  return fromName(str).value_or(CSSColor());
 }
 
 CSSUnit CSSUnit::parse(std::string_view str) {
@@ -219,154 +328,78 @@ CSSDashArray CSSDashArray::parse(std::string_view str) {
   return result;
 }
 
-enum class StyleTracker::Style {
-#define CSS_PROPERTY(NAME, STR) NAME,
-#include "svgutils/css_properties.def"
-};
-
-static constexpr const char *getStyleName(StyleTracker::Style style) {
-  using Style = StyleTracker::Style;
-  switch (style) {
-#define CSS_PROPERTY(NAME, STR)                                                \
-  case Style::NAME:                                                            \
-    return STR;
-#include "svgutils/css_properties.def"
-  }
-  return nullptr;
-}
-
-static outstream_t &operator<<(outstream_t &os, StyleTracker::Style style) {
-  os << getStyleName(style);
-  return os;
-}
-
-struct StyleTracker::StyleDiff {
-  std::map<Style, std::string> styles;
-  std::string &operator[](Style S) { return styles[S]; }
-  void extend(StyleDiff &&diff) {
-    // merge will not overwrite existing entries. To make sure that all
-    // styles from @p diff end up in this StyleDiff we need to swap the
-    // contents first
-    styles.swap(diff.styles);
-    styles.merge(diff.styles);
-  }
-  void extend(const StyleDiff &diff) {
-    for (const auto &KeyValuePair : diff.styles)
-      styles.insert_or_assign(KeyValuePair.first, KeyValuePair.second);
-  }
-  friend inline outstream_t &operator<<(outstream_t &os,
-                                        const StyleDiff &diff) {
-    for (const auto &KeyValuePair : diff.styles)
-      os << KeyValuePair.first << ": " << KeyValuePair.second << ";\n";
-    return os;
-  }
-};
-
-static StyleTracker::StyleDiff
-parseStyleDeclaration(const std::string_view &name,
-                      const std::string_view &value) {
+std::optional<StyleTracker::Style>
+StyleTracker::findStyle(std::string_view name) {
   // TODO parse combined styles like e.g. 'background'
-  using Style = StyleTracker::Style;
-  StyleTracker::StyleDiff diff;
 #define CSS_PROPERTY(NAME, STR)                                                \
   if (name == STR)                                                             \
-    diff[Style::NAME] = std::string{value};
+    return Style::NAME;
 #include "svgutils/css_properties.def"
-  return diff;
+  return std::nullopt;
 }
 
 namespace {
-struct StyleParser
-    : public SVGAttributeVisitor<StyleParser, StyleTracker::StyleDiff> {
-  using StyleDiff = StyleTracker::StyleDiff;
-  static StyleDiff parseStyles(const StyleTracker::AttrContainer &attrs);
-  StyleDiff visit_color(const svg::color &attr) {
-    StyleDiff diff;
-    diff.styles[StyleTracker::Style::COLOR] = attr.getValueStr();
-    return diff;
-  }
-  StyleDiff visit_font_family(const svg::font_family &attr) {
-    StyleDiff diff;
-    diff.styles[StyleTracker::Style::FONT_FAMILY] = attr.getValueStr();
-    return diff;
-  }
-  StyleDiff visit_font_size(const svg::font_size &attr) {
-    StyleDiff diff;
-    diff.styles[StyleTracker::Style::FONT_SIZE] = attr.getValueStr();
-    return diff;
+/// Collects what the styles of an element are resolved from. The values of
+/// styling attributes are appended to `key`, each as the character
+/// `StyleMarker + style`, the value and a null character.
+struct StyleParser : public SVGAttributeVisitor<StyleParser> {
+  using Style = StyleTracker::Style;
+  static constexpr char StyleMarker = 'A';
+  explicit StyleParser(std::string &key) : key(key) {}
+
+  /// Add the value of @p attr for @p style. Most values are strings
+  /// already, only numbers need to be formatted.
+  template <typename AttrTy> void set(Style style, const AttrTy &attr) {
+    key += static_cast<char>(StyleMarker + static_cast<int>(style));
+    if (const char *cstr = attr.cstrOrNull())
+      key += cstr;
+    else
+      key += attr.getValueStr();
+    key += '\0';
   }
-  StyleDiff visit_fill(const svg::fill &attr) {
-    StyleDiff diff;
-    diff.styles[StyleTracker::Style::FILL] = attr.getValueStr();
-    return diff;
+  void visit_color(const svg::color &attr) { set(Style::COLOR, attr); }
+  void visit_font_family(const svg::font_family &attr) {
+    set(Style::FONT_FAMILY, attr);
   }
-  StyleDiff visit_height(const svg::height &attr) {
-    StyleDiff diff;
-    diff.styles[StyleTracker::Style::HEIGHT] = attr.getValueStr();
-    return diff;
+  void visit_font_size(const svg::font_size &attr) {
+    set(Style::FONT_SIZE, attr);
   }
-  StyleDiff visit_stroke(const svg::stroke &attr) {
-    StyleDiff diff;
-    diff.styles[StyleTracker::Style::STROKE] = attr.getValueStr();
-    return diff;
+  void visit_fill(const svg::fill &attr) { set(Style::FILL, attr); }
+  void visit_height(const svg::height &attr) { set(Style::HEIGHT, attr); }
+  void visit_stroke(const svg::stroke &attr) { set(Style::STROKE, attr); }
+  void visit_stroke_width(const svg::stroke_width &attr) {
+    set(Style::STROKE_WIDTH, attr);
   }
-  StyleDiff visit_stroke_width(const svg::stroke_width &attr) {
-    StyleDiff diff;
-    diff.styles[StyleTracker::Style::STROKE_WIDTH] = attr.getValueStr();
-    return diff;
+  void visit_stroke_dasharray(const svg::stroke_dasharray &attr) {
+    set(Style::STROKE_DASHARRAY, attr);
   }
-  StyleDiff visit_stroke_dasharray(const svg::stroke_dasharray &attr) {
-    StyleDiff diff;
-    diff.styles[StyleTracker::Style::STROKE_DASHARRAY] = attr.getValueStr();
-    return diff;
+  void visit_style(const svg::style &attr) {
+    // Applied last, as it overrides the stylesheet
+    if (const char *cstr = attr.cstrOrNull())
+      inlineStyle = cstr;
   }
-  StyleDiff visit_style(const svg::style &attr) {
-    StyleDiff diff;
-    std::string_view content{attr.cstrOrNull()};
-    while (content.size()) {
-      size_t end = content.find(';');
-      std::string_view decl;
-      if (end == content.npos) {
-        decl = content;
-        content = nullptr;
-      } else {
-        decl = content.substr(0, end);
-        content = content.substr(end + 1);
-      }
-      size_t split = decl.find(':');
-      if (split == decl.npos)
-        continue;
-      std::string_view name = strview_trim(decl.substr(0, split));
-      std::string_view value = strview_trim(decl.substr(split + 1));
-      diff.extend(parseStyleDeclaration(name, value));
-    }
-    return diff;
+  void visit_id(const svg::id &attr) {
+    if (const char *cstr = attr.cstrOrNull())
+      id = cstr;
   }
-  StyleDiff visit_text_anchor(const svg::text_anchor &attr) {
-    StyleDiff diff;
-    diff.styles[StyleTracker::Style::TEXT_ANCHOR] = attr.getValueStr();
-    return diff;
+  void visit_class_(const svg::class_ &attr) {
+    if (const char *cstr = attr.cstrOrNull())
+      classes = cstr;
   }
-  StyleDiff visit_width(const svg::width &attr) {
-    StyleDiff diff;
-    diff.styles[StyleTracker::Style::WIDTH] = attr.getValueStr();
-    return diff;
+  void visit_text_anchor(const svg::text_anchor &attr) {
+    set(Style::TEXT_ANCHOR, attr);
   }
-};
+  void visit_width(const svg::width &attr) { set(Style::WIDTH, attr); }
 
-StyleTracker::StyleDiff
-StyleParser::parseStyles(const StyleTracker::AttrContainer &attrs) {
-  StyleTracker::StyleDiff result;
-  StyleParser parser;
-  for (const SVGAttribute &Attr : attrs)
-    result.extend(parser.visit(Attr));
-  return result;
-}
+  std::string &key;
+  std::string_view inlineStyle;
+  std::string_view id;
+  std::string_view classes;
+};
 } // namespace
 
 StyleTracker::StyleTracker() {
-  StyleDiff initialStyles;
-  initialStyles.styles = {
+  const std::pair<Style, const char *> initialStyles[] = {
       {Style::COLOR, "black"},
       {Style::BACKGROUND_COLOR, "white"},
       {Style::FILL, "none"},
@@ -380,103 +413,240 @@ StyleTracker::StyleTracker() {
       {Style::TEXT_ANCHOR, "start"},
       {Style::TRANSFORM, ""},
   };
-  Cascade.emplace_back(std::move(initialStyles));
-  for (const auto &KeyValuePair : Cascade.back().styles)
-    CurrentStyle[KeyValuePair.first] = KeyValuePair.second;
+  for (const auto &KeyValuePair : initialStyles)
+    set(KeyValuePair.first, KeyValuePair.second);
+  // The initial styles can't be popped
+  UndoLog.clear();
+}
+
+void StyleTracker::set(Style style, std::string_view value) {
+  size_t idx = static_cast<size_t>(style);
+  ValueRef &ref = Current[idx];
+  UndoLog.push_back({style, ref, std::move(CurrentComputed[idx])});
+  CurrentComputed[idx] = std::monostate();
+  ref.offset = Values.size();
+  ref.size = value.size();
+  Values.append(value);
+}
+
+void StyleTracker::push(const AttrContainer &attrs, const char *tag) {
+  uint64_t parentSerial = Frames.empty() ? 0 : Frames.back().serial;
+  size_t depth = Frames.size();
+  Frames.push_back({UndoLog.size(), Values.size(), ++NextSerial});
+  Frame &frame = Frames.back();
+
+  Key.clear();
+  StyleParser parser(Key);
+  for (const SVGAttribute &Attr : attrs)
+    parser.visit(Attr);
+  auto addToKey = [this](char marker, std::string_view part) {
+    Key += marker;
+    Key += part;
+    Key += '\0';
+  };
+  if (Sheet) {
+    addToKey('<', tag ? tag : "");
+    addToKey('.', parser.classes);
+    if (Sheet->hasIdSelectors())
+      addToKey('#', parser.id);
+  }
+  addToKey(';', parser.inlineStyle);
+
+  if (depth == SharingCache.size())
+    SharingCache.emplace_back();
+  SharingSlots &slots = SharingCache[depth];
+  for (SharedStyle &shared : slots) {
+    if (!shared.complete || shared.parentSerial != parentSerial ||
+        shared.key != Key)
+      continue;
+    ++stats.sharingHits;
+    for (size_t i = 0; i < shared.styles.size(); ++i) {
+      auto [style, ref] = shared.styles[i];
+      set(style, std::string_view(shared.values).substr(ref.offset, ref.size));
+      CurrentComputed[static_cast<size_t>(style)] = shared.computed[i];
+    }
+    frame.shared = &shared;
+    frame.pushedUndoSize = UndoLog.size();
+    return;
+  }
+  ++stats.sharingMisses;
+
+  // Presentation attributes, as collected in the key
+  for (size_t pos = 0; pos < Key.size() && Key[pos] >= StyleParser::StyleMarker;
+       ++pos) {
+    auto style = static_cast<Style>(Key[pos] - StyleParser::StyleMarker);
+    size_t end = Key.find('\0', pos);
+    set(style, std::string_view(Key).substr(pos + 1, end - pos - 1));
+    pos = end;
+  }
+  if (Sheet) {
+    CSSStylesheet::Element element{tag ? tag : "", parser.id, parser.classes};
+    Sheet->match(element, Matches);
+    for (const auto &match : Matches)
+      for (const auto &decl : Sheet->getDeclarations(match.second))
+        set(decl.style, decl.value);
+  }
+  forEachCSSDeclaration(parser.inlineStyle,
+                        [this](std::string_view name, std::string_view value) {
+                          if (auto style = findStyle(name))
+                            set(*style, value);
+                        });
+  frame.pushedUndoSize = UndoLog.size();
+
+  // Replace the oldest shared styles of this depth
+  std::rotate(slots.begin(), slots.end() - 1, slots.end());
+  SharedStyle &shared = slots.front();
+  shared.complete = true;
+  shared.parentSerial = parentSerial;
+  shared.key = Key;
+  shared.styles.clear();
+  shared.values.clear();
+  shared.computed.clear();
+  static_assert(NumStyles <= 64, "Styles don't fit the bitmask");
+  uint64_t seen = 0;
+  for (size_t i = frame.undoSize; i < UndoLog.size(); ++i) {
+    Style style = UndoLog[i].style;
+    uint64_t bit = uint64_t(1) << static_cast<size_t>(style);
+    if (seen & bit)
+      continue;
+    seen |= bit;
+    std::string_view value = *get(style);
+    shared.styles.push_back({style, {shared.values.size(), value.size()}});
+    shared.values.append(value);
+    shared.computed.emplace_back();
+  }
+  frame.shared = &shared;
 }
-StyleTracker::StyleTracker(StyleTracker &&o) : StyleTracker() {
-  *this = std::move(o);
+
+void StyleTracker::addStylesheet(std::string_view css) {
+  if (!Sheet)
+    Sheet = std::make_shared<CSSStylesheet>();
+  Sheet->parse(css);
+  // Styles resolved before may not match the new rules
+  for (SharingSlots &slots : SharingCache)
+    for (SharedStyle &shared : slots)
+      shared.complete = false;
 }
-StyleTracker &StyleTracker::operator=(StyleTracker &&o) {
-  Cascade = std::move(o.Cascade);
-  CurrentStyle.clear();
-  for (const StyleDiff &Diff : Cascade)
-    for (const auto &KeyValuePair : Diff.styles)
-      CurrentStyle[KeyValuePair.first] = KeyValuePair.second;
-  return *this;
+
+void StyleTracker::setStylesheet(std::shared_ptr<CSSStylesheet> sheet) {
+  Sheet = std::move(sheet);
+  for (SharingSlots &slots : SharingCache)
+    for (SharedStyle &shared : slots)
+      shared.complete = false;
 }
-StyleTracker::~StyleTracker() = default;
 
-void StyleTracker::push(const AttrContainer &attrs) {
-  Cascade.emplace_back(StyleParser::parseStyles(attrs));
-  for (const auto &KeyValuePair : Cascade.back().styles)
-    CurrentStyle[KeyValuePair.first] = KeyValuePair.second;
+StyleTracker StyleTracker::fork() const {
+  StyleTracker res;
+  for (size_t idx = 0; idx < NumStyles; ++idx) {
+    auto style = static_cast<Style>(idx);
+    if (auto value = get(style)) {
+      res.set(style, *value);
+      res.CurrentComputed[idx] = CurrentComputed[idx];
+    }
+  }
+  // The current styles become the initial ones
+  res.UndoLog.clear();
+  res.Sheet = Sheet;
+  return res;
 }
 
 void StyleTracker::pop() {
-  StyleDiff diff = Cascade.back();
-  Cascade.pop_back();
-  // Reverse-iterate over parents and replace all styles referencing
-  // a style from `diff` with a parent style
-  auto It = Cascade.rbegin();
-  while (diff.styles.size() && It != Cascade.rend()) {
-    const StyleDiff &parent = *(It++);
-    for (const auto &KeyValuePair : parent.styles)
-      if (diff.styles.count(KeyValuePair.first)) {
-        diff.styles.erase(KeyValuePair.first);
-        CurrentStyle[KeyValuePair.first] = KeyValuePair.second;
-      }
+  assert(Frames.size() && "Unbalanced StyleTracker::pop");
+  const Frame &frame = Frames.back();
+  // Keep what the getters parsed for the siblings, unless styles were set
+  // after the push
+  if (frame.shared && UndoLog.size() == frame.pushedUndoSize) {
+    SharedStyle &shared = *frame.shared;
+    for (size_t i = 0; i < shared.styles.size(); ++i) {
+      if (std::holds_alternative<std::monostate>(shared.computed[i]))
+        shared.computed[i] =
+            CurrentComputed[static_cast<size_t>(shared.styles[i].first)];
+    }
+  }
+  // Undo in reverse, so properties set twice end up with their value from
+  // before the push
+  while (UndoLog.size() > frame.undoSize) {
+    UndoEntry &entry = UndoLog.back();
+    size_t idx = static_cast<size_t>(entry.style);
+    Current[idx] = entry.previous;
+    CurrentComputed[idx] = std::move(entry.previousComputed);
+    UndoLog.pop_back();
   }
-  // If some styles remain in `diff.styles` that means there are no parent
-  // style definitions and we completely erase them
-  for (const auto &KeyValuePair : diff.styles)
-    CurrentStyle.erase(KeyValuePair.first);
+  Values.resize(frame.valuesSize);
+  Frames.pop_back();
+}
+
+template <typename T, typename ParseFn>
+const T *StyleTracker::getComputed(Style style, ParseFn parse) const {
+  ++stats.lookups;
+  Computed &computed = CurrentComputed[static_cast<size_t>(style)];
+  if (const T *value = std::get_if<T>(&computed))
+    return value;
+  std::optional<std::string_view> str = get(style);
+  if (!str)
+    return nullptr;
+  ++stats.parses;
+  computed = parse(*str);
+  return &std::get<T>(computed);
+}
+
+static CSSTextAnchor parseTextAnchor(std::string_view str) {
+  if (str == "middle")
+    return CSSTextAnchor::MIDDLE;
+  else if (str == "end")
+    return CSSTextAnchor::END;
+  return CSSTextAnchor::START;
 }
 
 CSSColor StyleTracker::getColor() const {
-  if (CurrentStyle.count(Style::COLOR))
-    return CSSColor::parse(CurrentStyle.at(Style::COLOR));
+  if (auto value = getComputed<CSSColor>(Style::COLOR, CSSColor::parse))
+    return *value;
   return CSSColor();
 }
 CSSColor StyleTracker::getFill() const {
-  if (CurrentStyle.count(Style::FILL))
-    return CSSColor::parse(CurrentStyle.at(Style::FILL));
+  if (auto value = getComputed<CSSColor>(Style::FILL, CSSColor::parse))
+    return *value;
   return getColor();
 }
 std::string_view StyleTracker::getFontFamily() const {
-  if (CurrentStyle.count(Style::FONT_FAMILY))
-    return CurrentStyle.at(Style::FONT_FAMILY);
+  if (auto value = get(Style::FONT_FAMILY))
+    return *value;
   return std::string_view();
 }
 CSSUnit StyleTracker::getFontSize() const {
-  if (CurrentStyle.count(Style::FONT_SIZE))
-    return CSSUnit::parse(CurrentStyle.at(Style::FONT_SIZE));
+  if (auto value = getComputed<CSSUnit>(Style::FONT_SIZE, CSSUnit::parse))
+    return *value;
   return CSSUnit();
 }
 CSSUnit StyleTracker::getHeight() const {
-  if (CurrentStyle.count(Style::HEIGHT))
-    return CSSUnit::parse(CurrentStyle.at(Style::HEIGHT));
+  if (auto value = getComputed<CSSUnit>(Style::HEIGHT, CSSUnit::parse))
+    return *value;
   return CSSUnit();
 }
 CSSColor StyleTracker::getStroke() const {
-  if (CurrentStyle.count(Style::STROKE))
-    return CSSColor::parse(CurrentStyle.at(Style::STROKE));
+  if (auto value = getComputed<CSSColor>(Style::STROKE, CSSColor::parse))
+    return *value;
   return getColor();
 }
 CSSUnit StyleTracker::getStrokeWidth() const {
-  if (CurrentStyle.count(Style::STROKE_WIDTH))
-    return CSSUnit::parse(CurrentStyle.at(Style::STROKE_WIDTH));
+  if (auto value = getComputed<CSSUnit>(Style::STROKE_WIDTH, CSSUnit::parse))
+    return *value;
   return CSSUnit();
 }
 CSSDashArray StyleTracker::getStrokeDasharray() const {
-  if (CurrentStyle.count(Style::STROKE_DASHARRAY))
-    return CSSDashArray::parse(CurrentStyle.at(Style::STROKE_DASHARRAY));
+  if (auto value = getComputed<CSSDashArray>(Style::STROKE_DASHARRAY,
+                                             CSSDashArray::parse))
+    return *value;
   return CSSDashArray();
 }
 CSSTextAnchor StyleTracker::getTextAnchor() const {
-  if (CurrentStyle.count(Style::TEXT_ANCHOR)) {
-    auto anchorStr = CurrentStyle.at(Style::TEXT_ANCHOR);
-    if (anchorStr == "start")
-      return CSSTextAnchor::START;
-    else if (anchorStr == "middle")
-      return CSSTextAnchor::MIDDLE;
-    else if (anchorStr == "end")
-      return CSSTextAnchor::END;
-  }
+  if (auto value =
+          getComputed<CSSTextAnchor>(Style::TEXT_ANCHOR, parseTextAnchor))
+    return *value;
   return CSSTextAnchor::START;
 }
 CSSUnit StyleTracker::getWidth() const {
-  if (CurrentStyle.count(Style::WIDTH))
-    return CSSUnit::parse(CurrentStyle.at(Style::WIDTH));
+  if (auto value = getComputed<CSSUnit>(Style::WIDTH, CSSUnit::parse))
+    return *value;
   return CSSUnit();
 }
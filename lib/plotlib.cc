@@ -79,13 +79,9 @@ void Axis::compile(PlotWriterConcept &writer, const Graph &graph, double width,
     prepareStyle();
   const AxisStyle &style = getStyle();
   using namespace svg;
-  std::string trans;
-  {
-    std::stringstream ss;
-    ss << "translate(0 " << height << ") scale(1, -1)";
-    trans = ss.str();
-  }
-  writer.g(x(0), y(0), transform(trans.c_str()));
+  // translate(0 height) scale(1, -1)
+  writer.g(x(0), y(0),
+           transform(SVGNumberTuple::Matrix(1, 0, 0, -1, 0, height)));
   writer.enter();
   double xAxisY = 0.;
   double yAxisX = 0.;
@@ -127,13 +123,8 @@ Point<2> Axis::project(Point<2> p) const {
 
 void Graph::compile(PlotWriterConcept &writer) const {
   using namespace svg;
-  std::string vBox;
-  {
-    std::stringstream ss;
-    ss << 0 << " " << 0 << " " << width << " " << height;
-    vBox = ss.str();
-  }
-  writer.svg(viewBox(vBox.c_str()), preserveAspectRatio("none"),
+  writer.svg(viewBox(SVGNumberTuple::List(0, 0, width, height)),
+             preserveAspectRatio("none"),
              style(ConcatStyles(CssRules).c_str()));
   writer.enter();
   for (const auto &Axis : Axes)
@@ -1,4 +1,8 @@
 #include "svgcairo/svg_cairo.h"
+#include "svgutils/svg_display_list.h"
+#include "svgutils/svg_lengths.h"
+#include "svgutils/svg_path_data.h"
+#include "svgutils/utils.h"
 #include <algorithm>
 #include <cairo/cairo-ft.h>
 #include <cairo/cairo-pdf.h>
@@ -54,6 +58,16 @@ void CairoSVGWriter::initCairo() {
         cairo_surface_destroy);
     break;
   case CairoSVGWriter::PNG:
+    if (tileThreads) {
+      // Bounded like the image, so drawing outside of it is clipped the
+      // same way
+      cairo_rectangle_t extents{0., 0., static_cast<double>(int(w)),
+                                static_cast<double>(int(h))};
+      surface = OwnedSurface(
+          cairo_recording_surface_create(CAIRO_CONTENT_COLOR_ALPHA, &extents),
+          cairo_surface_destroy);
+      break;
+    }
     surface =
         OwnedSurface(cairo_image_surface_create(CAIRO_FORMAT_ARGB32, w, h),
                      cairo_surface_destroy);
@@ -64,6 +78,8 @@ void CairoSVGWriter::initCairo() {
   cairo = OwnedCairo(cairo_create(surface.get()), cairo_deleter);
   assert(cairo_status(cairo.get()) == CAIRO_STATUS_SUCCESS &&
          "Error initializing cairo context");
+  cairo_clip_extents(cairo.get(), &visible.x0, &visible.y0, &visible.x1,
+                     &visible.y1);
 }
 
 CairoSVGWriter::CairoSVGWriter(const fs::path &outfile, OutputFormat fmt)
@@ -81,6 +97,48 @@ CairoSVGWriter::CairoSVGWriter(const fs::path &outfile, OutputFormat fmt,
   initCairo();
 }
 
+void CairoSVGWriter::setTiling(unsigned numThreads, unsigned tileSize) {
+  tileThreads = fmt == PNG ? numThreads : 0;
+  this->tileSize = std::max(tileSize, 1u);
+  initCairo();
+}
+
+CairoSVGWriter::OwnedSurface CairoSVGWriter::rasterizeTiles() {
+  cairo_surface_flush(surface.get());
+  int w = static_cast<int>(getWidth()), h = static_cast<int>(getHeight());
+  OwnedSurface image(cairo_image_surface_create(CAIRO_FORMAT_ARGB32, w, h),
+                     cairo_surface_destroy);
+  struct Tile {
+    int x, y, w, h;
+  };
+  std::vector<Tile> tiles;
+  int size = static_cast<int>(tileSize);
+  for (int y = 0; y < h; y += size)
+    for (int x = 0; x < w; x += size)
+      tiles.push_back({x, y, std::min(size, w - x), std::min(size, h - y)});
+  // Every tile is a view of its part of the image, so the tiles are drawn
+  // in place. The recording is only read, and only whole pixels are
+  // covered by each tile, so the result doesn't depend on the tiling.
+  auto render = [&](const Tile &tile) {
+    cairo_surface_t *view = cairo_surface_create_for_rectangle(
+        image.get(), tile.x, tile.y, tile.w, tile.h);
+    cairo_t *cr = cairo_create(view);
+    cairo_set_source_surface(cr, surface.get(), -tile.x, -tile.y);
+    cairo_paint(cr);
+    cairo_destroy(cr);
+    cairo_surface_destroy(view);
+  };
+  if (tiles.empty())
+    return image;
+  // Replaying the recording the first time builds its index, so that
+  // happens before there are other threads
+  render(tiles.front());
+  parallelFor(tiles.size() - 1, tileThreads,
+              [&](size_t i) { render(tiles[i + 1]); });
+  cairo_surface_mark_dirty(image.get());
+  return image;
+}
+
 CairoSVGWriter::RetTy
 CairoSVGWriter::custom_tag(const char *name,
                            const std::vector<SVGAttribute> &attrs) {
@@ -91,13 +149,17 @@ CairoSVGWriter::custom_tag(const char *name,
 
 CairoSVGWriter::RetTy CairoSVGWriter::content(const char *text) {
   closeTag();
-  if (ignore)
-    return this;
   if (text == nullptr)
     return this;
   if (!parents.size())
     svg_unreachable("Encountered stray text on the top level of the document");
   TagType parentTag = parents.top();
+  if (parentTag == TagType::style) {
+    styles.addStylesheet(text);
+    return this;
+  }
+  if (ignore)
+    return this;
   if (parentTag != TagType::text) {
     std::cerr << "Content is only supported in text nodes at the "
                  "moment.\nContent for tag "
@@ -115,6 +177,21 @@ CairoSVGWriter::RetTy CairoSVGWriter::content(const char *text) {
   CSSColor color = styles.getFill();
   std::string fontPattern(styles.getFontFamily());
   CSSTextAnchor anchor = styles.getTextAnchor();
+  int textlen = std::strlen(text);
+  double x, y;
+  cairo_get_current_point(cairo.get(), &x, &y);
+
+  // Text culled before in this element starts at the current point
+  ++culling.elements;
+  double cullStrokeWidth =
+      styles.getStroke() ? convertCSSWidth(styles.getStrokeWidth()) : 0.;
+  if (!SVGDisplayList::getTextBounds(x, y, culledText.size() + textlen,
+                                     fontSize, std::abs(cullStrokeWidth))
+           .intersects(visible)) {
+    ++culling.culled;
+    culledText += text;
+    return this;
+  }
 
   FT_Face ftFont = fonts.getFace(fontPattern.c_str());
   if (!ftFont)
@@ -126,9 +203,11 @@ CairoSVGWriter::RetTy CairoSVGWriter::content(const char *text) {
   cairo_set_font_face(cairo.get(), cairoFont);
   cairo_set_font_size(cairo.get(), fontSize);
   cairo_set_source_rgba(cairo.get(), color.r, color.g, color.b, color.a);
-  int textlen = std::strlen(text);
-  double x, y;
-  cairo_get_current_point(cairo.get(), &x, &y);
+  if (!culledText.empty()) {
+    skipText(culledText);
+    culledText.clear();
+    cairo_get_current_point(cairo.get(), &x, &y);
+  }
 
   cairo_scaled_font_t *scaled_font = cairo_get_scaled_font(cairo.get());
   if (cairo_scaled_font_status(scaled_font))
@@ -203,6 +282,26 @@ CairoSVGWriter::RetTy CairoSVGWriter::content(const char *text) {
   return this;
 }
 
+void CairoSVGWriter::skipText(const std::string &text) {
+  cairo_text_extents_t extents;
+  cairo_text_extents(cairo.get(), text.c_str(), &extents);
+  double x, y;
+  cairo_get_current_point(cairo.get(), &x, &y);
+  // Where the last glyph ends after anchoring, as in content()
+  double advance = extents.x_advance;
+  switch (styles.getTextAnchor()) {
+  case CSSTextAnchor::START:
+    break;
+  case CSSTextAnchor::MIDDLE:
+    advance /= 2;
+    break;
+  case CSSTextAnchor::END:
+    advance = 0.;
+    break;
+  }
+  cairo_move_to(cairo.get(), x + advance, y + extents.y_advance);
+}
+
 CairoSVGWriter::RetTy CairoSVGWriter::comment(const char *comment) {
   return this;
 }
@@ -233,7 +332,10 @@ CairoSVGWriter::RetTy CairoSVGWriter::finish() {
     cairo_show_page(cairo.get());
     break;
   case PNG:
-    cairo_surface_write_to_png(surface.get(), outfile.c_str());
+    if (tileThreads)
+      cairo_surface_write_to_png(rasterizeTiles().get(), outfile.c_str());
+    else
+      cairo_surface_write_to_png(surface.get(), outfile.c_str());
     break;
   }
   return this;
@@ -260,6 +362,17 @@ void CairoSVGWriter::closeTag() {
   }
 }
 
+const char *CairoSVGWriter::getTagName(TagType tag) {
+  switch (tag) {
+#define SVG_TAG(NAME, STR)                                                     \
+  case TagType::NAME:                                                          \
+    return STR;
+#include "svgutils/svg_entities.def"
+  default:
+    return nullptr;
+  }
+}
+
 void CairoSVGWriter::openTag(TagType T,
                              const CairoSVGWriter::AttrContainer &attrs) {
   if (T != TagType::svg && !width && !height) {
@@ -268,7 +381,7 @@ void CairoSVGWriter::openTag(TagType T,
   }
   closeTag();
   currentTag = T;
-  styles.push(attrs);
+  styles.push(attrs, getTagName(T));
 }
 
 static double convertCSSLength(const CSSUnit &unit,
@@ -302,25 +415,15 @@ static double convertCSSLength(const CSSUnit &unit,
 
 double CairoSVGWriter::convertCSSWidth(const CSSUnit &unit) const {
   if (unit.unit == CSSUnit::PERCENT)
-    return unit.length / 100. * getWidth();
+    return unit.length / 100. * (userWidth ? userWidth : getWidth());
   return convertCSSLength(unit, fmt);
 }
 double CairoSVGWriter::convertCSSHeight(const CSSUnit &unit) const {
   if (unit.unit == CSSUnit::PERCENT)
-    return unit.length / 100. * getHeight();
+    return unit.length / 100. * (userHeight ? userHeight : getHeight());
   return convertCSSLength(unit, fmt);
 }
 
-/// Utility function to extract a CSS unit from the value of an
-/// SVGAttribute
-static CSSUnit CSSUnitFrom(const SVGAttribute &attr) {
-  if (const char *cstr = attr.cstrOrNull())
-    return CSSUnit::parse(cstr);
-  CSSUnit res;
-  res.length = attr.toDouble();
-  return res;
-}
-
 void CairoSVGWriter::applyCSSStroke(bool preserve) {
   // Render stroke
   CSSUnit cssStrokeWidth = styles.getStrokeWidth();
@@ -401,8 +504,14 @@ void CairoSVGWriter::circle_impl(const CairoSVGWriter::AttrContainer &attrs) {
   } attrParser(cx, cy, r);
   for (const SVGAttribute &Attr : attrs)
     attrParser.visit(Attr);
-  cairo_arc(cairo.get(), convertCSSWidth(cx), convertCSSHeight(cy),
-            convertCSSWidth(r), 0., 2 * M_PI);
+  double x = convertCSSWidth(cx), y = convertCSSHeight(cy);
+  double radius = convertCSSWidth(r);
+  // The curves of the circle meet without corners
+  if (!isVisible({x - std::abs(radius), y - std::abs(radius),
+                  x + std::abs(radius), y + std::abs(radius)},
+                 false))
+    return;
+  cairo_arc(cairo.get(), x, y, radius, 0., 2 * M_PI);
   applyCSSFillAndStroke(false);
 }
 void CairoSVGWriter::clipPath_impl(const CairoSVGWriter::AttrContainer &attrs) {
@@ -494,8 +603,14 @@ void CairoSVGWriter::line_impl(const CairoSVGWriter::AttrContainer &attrs) {
   } attrParser(x1, y1, x2, y2);
   for (const SVGAttribute &Attr : attrs)
     attrParser.visit(Attr);
-  cairo_move_to(cairo.get(), convertCSSWidth(x1), convertCSSHeight(y1));
-  cairo_line_to(cairo.get(), convertCSSWidth(x2), convertCSSHeight(y2));
+  double startX = convertCSSWidth(x1), startY = convertCSSHeight(y1);
+  double endX = convertCSSWidth(x2), endY = convertCSSHeight(y2);
+  if (!isVisible({std::min(startX, endX), std::min(startY, endY),
+                  std::max(startX, endX), std::max(startY, endY)},
+                 false))
+    return;
+  cairo_move_to(cairo.get(), startX, startY);
+  cairo_line_to(cairo.get(), endX, endY);
   applyCSSStroke(false);
 }
 void CairoSVGWriter::linearGradient_impl(
@@ -514,564 +629,89 @@ void CairoSVGWriter::missing_glyph_impl(
     const CairoSVGWriter::AttrContainer &attrs) {}
 void CairoSVGWriter::mpath_impl(const CairoSVGWriter::AttrContainer &attrs) {}
 
-struct PathFlag {
-  PathFlag() = default;
-  explicit PathFlag(char flag) : flag(flag) {}
-  PathFlag(const PathFlag &) = default;
-  PathFlag &operator=(const PathFlag &) = default;
-  PathFlag(PathFlag &&) = default;
-  PathFlag &operator=(PathFlag &&) = default;
-
-  operator bool() const { return flag; }
-  char getValue() const {
-    assert((flag == '0' || flag == '1') &&
-           "Unchecked extraction of PathFlag value");
-    return flag;
-  }
-
-private:
-  char flag = 0;
-};
-
-template <bool Signed> struct PathNumber {
-  PathNumber() = default;
-  PathNumber(const PathNumber &) = default;
-  PathNumber &operator=(const PathNumber &) = default;
-  PathNumber(PathNumber &&) = default;
-  PathNumber &operator=(PathNumber &&) = default;
-
-  operator bool() const { return number.size(); }
-  const std::string_view &operator*() const {
-    assert(*this && "Unchecked extraction of PathNumber value");
-    return number;
-  }
-  double toDouble() const {
-    assert(*this && "Unchecked extraction of PathNumber value");
-    return *strview_to_double(number);
-  }
-  static PathNumber Extract(/* inout */ std::string_view &str);
-
-private:
-  explicit PathNumber(const std::string_view &number) : number(number) {}
-  std::string_view number;
-};
-
-// Grammar for SVG paths: https://www.w3.org/TR/SVG11/paths.html#PathDataBNF
-template <bool Signed>
-PathNumber<Signed>
-PathNumber<Signed>::Extract(/* inout */ std::string_view &str) {
-  PathNumber<Signed> Error;
-  if (str.empty())
-    return Error;
-  assert(!std::isspace(str.front()) && "Expected trimmed argument string");
-  // Numbers must start with +, -, . or digit
-  if (!std::isdigit(str.front()) && str.front() != '+' && str.front() != '-' &&
-      str.front() != '.')
-    return Error;
-  if (!Signed && (str.front() == '+' || str.front() == '-'))
-    return Error;
-  // str.begin() != str.end() because !str.empty()
-  std::string_view::iterator End = str.begin();
-  bool hasDigit = false;
-  if (*End == '+' || *End == '-') {
-    ++End; // Move past +|-
-    if (End == str.end())
-      return Error; // Cannot end after +|-
-  }
-  if (*End != '.') {
-    // consume leading digits
-    while (End != str.end() && std::isdigit(*End)) {
-      hasDigit = true;
-      ++End;
-    }
-    if (!hasDigit)
-      return Error; // We might have skipped past +|- and no '.' was found. By
-                    // now there must have been a digit.
-  }
-  if (End != str.end() && *End == '.') {
-    ++End; // Move past '.'
-    // consume decimal digits
-    while (End != str.end() && std::isdigit(*End)) {
-      hasDigit = true;
-      ++End;
-    }
-    if (!hasDigit)
-      return Error; // '.' requires digit either before or after
-  }
-  if (End != str.end() && (*End == 'e' || *End == 'E')) {
-    ++End; // Move past e|E
-    if (End == str.end())
-      return Error; // Cannot stop after e|E
-    if (*End == '+' || *End == '-')
-      ++End;
-    if (End == str.end() || !std::isdigit(*End))
-      return Error; // Cannot stop after +|-
-    hasDigit = false;
-    while (End != str.end() && std::isdigit(*End)) {
-      hasDigit = true;
-      ++End;
-    }
-    if (!hasDigit)
-      return Error; // No digit in exponent
-  }
-
-  std::string_view argStr = str.substr(0, End - str.begin());
-  if (End == str.end())
-    str.remove_prefix(str.size());
-  else {
-    str.remove_prefix(End - str.begin());
-    // If the value is delimited by a comma or spaces, the delimiter should
-    // be dropped as well
-    str = strview_trim(str);
-    if (str.front() == ',') {
-      str.remove_prefix(1);
-      str = strview_trim(str);
+/// Bounds of all points of @p path, nullopt if it has none
+static std::optional<PathData::Bounds> getBounds(const cairo_path_t *path) {
+  std::optional<PathData::Bounds> bounds;
+  for (int i = 0; i < path->num_data; i += path->data[i].header.length)
+    for (int j = 1; j < path->data[i].header.length; ++j) {
+      const auto &point = path->data[i + j].point;
+      PathData::Bounds pointBounds{point.x, point.y, point.x, point.y};
+      if (bounds)
+        bounds->unite(pointBounds);
+      else
+        bounds = pointBounds;
     }
-  }
-  return PathNumber<Signed>(argStr);
+  return bounds;
 }
 
-static bool ExtractPathArgs(/* inout */ std::string_view &argsStr) {
-  return true;
+static PathData::Bounds scaleBounds(const PathData::Bounds &bounds,
+                                    double scale) {
+  return {bounds.x0 * scale, bounds.y0 * scale, bounds.x1 * scale,
+          bounds.y1 * scale};
 }
 
-template <typename... args_t>
-static bool ExtractPathArgs(/* inout */ std::string_view &argsStr,
-                            /* out */ PathFlag &arg1, args_t &... argn) {
-  if (argsStr.front() == '0' || argsStr.front() == '1') {
-    arg1 = PathFlag(argsStr.front());
-    argsStr.remove_prefix(1);
-    // consume any whitespace
-    argsStr = strview_trim(argsStr);
-    // also consume comma if present
-    if (argsStr.front() == ',') {
-      argsStr.remove_prefix(1);
-      argsStr = strview_trim(argsStr);
-    }
-  } else
-    return false;
-  return ExtractPathArgs(argsStr, argn...);
+bool CairoSVGWriter::isVisible(const PathData::Bounds &bounds, bool joins) {
+  ++culling.elements;
+  PathData::Bounds painted = bounds;
+  double strokeWidth = convertCSSWidth(styles.getStrokeWidth());
+  if (strokeWidth != 0. && styles.getStroke())
+    painted =
+        SVGDisplayList::getStrokeBounds(bounds, std::abs(strokeWidth), joins);
+  if (painted.intersects(visible))
+    return true;
+  ++culling.culled;
+  return false;
 }
 
-template <bool Signed, typename... args_t>
-static bool ExtractPathArgs(/* inout */ std::string_view &argsStr,
-                            /* out */ PathNumber<Signed> &arg1,
-                            args_t &... argn) {
-  arg1 = PathNumber<Signed>::Extract(argsStr);
-  if (!arg1)
-    return false;
-  return ExtractPathArgs(argsStr, argn...);
+double CairoSVGWriter::getUnitScale() const {
+  return convertCSSLength(CSSUnit{CSSUnit::PX, 1.}, fmt);
 }
 
-CairoSVGWriter::PathErrorOr<CairoSVGWriter::ControlPoint>
-CairoSVGWriter::CairoExecuteCubicBezier(std::string_view args, bool rel) {
-  if (args.empty())
-    return PathError("No arguments given to C/c command");
-  PathNumber<true> x1Arg, y1Arg, x2Arg, y2Arg, x3Arg, y3Arg;
-  ControlPoint CP;
-  while (args.size()) {
-    if (!ExtractPathArgs(args, x1Arg, y1Arg, x2Arg, y2Arg, x3Arg, y3Arg))
-      return PathError("Not enough arguments given to C/c command");
-    double x1 = x1Arg.toDouble(), y1 = y1Arg.toDouble(), x2 = x2Arg.toDouble(),
-           y2 = y2Arg.toDouble(), x3 = x3Arg.toDouble(), y3 = y3Arg.toDouble();
-    if (rel) {
-      double x0, y0;
-      cairo_get_current_point(cairo.get(), &x0, &y0);
-      CP = {x0 + x2, y0 + y2};
-      cairo_rel_curve_to(cairo.get(), x1, y1, x2, y2, x3, y3);
-    } else {
-      CP = {x2, y2};
-      cairo_curve_to(cairo.get(), x1, y1, x2, y2, x3, y3);
+void CairoSVGWriter::appendPath(const PathData &path) {
+  struct Appender {
+    cairo_t *cr;
+    void moveTo(double x, double y) { cairo_move_to(cr, x, y); }
+    void lineTo(double x, double y) { cairo_line_to(cr, x, y); }
+    void cubicTo(double x1, double y1, double x2, double y2, double x,
+                 double y) {
+      cairo_curve_to(cr, x1, y1, x2, y2, x, y);
     }
+    void close() { cairo_close_path(cr); }
+  } appender{cairo.get()};
+  if (!path.getError().empty())
+    std::cerr << "Error in path data: " << path.getError()
+              << ". Only the segments before it are drawn.\n";
+  double scale = getUnitScale();
+  if (scale == 1.) {
+    path.visit(appender);
+    return;
   }
-  return CP;
-}
-CairoSVGWriter::PathErrorOr<CairoSVGWriter::ControlPoint>
-CairoSVGWriter::CairoExecuteSmoothCubicBezier(
-    std::string_view args, bool rel,
-    const std::optional<ControlPoint> &PrevCP) {
-  if (args.empty())
-    return PathError("No arguments given to S/s command");
-  PathNumber<true> x2Arg, y2Arg, x3Arg, y3Arg;
-  ControlPoint CP;
-  if (!PrevCP) {
-    double x0, y0;
-    cairo_get_current_point(cairo.get(), &x0, &y0);
-    CP = {x0, y0};
-  } else {
-    CP = *PrevCP;
-  }
-  while (args.size()) {
-    if (!ExtractPathArgs(args, x2Arg, y2Arg, x3Arg, y3Arg))
-      return PathError("Not enough arguments given to S/s command");
-    double x0, y0, x2 = x2Arg.toDouble(), y2 = y2Arg.toDouble(),
-                   x3 = x3Arg.toDouble(), y3 = y3Arg.toDouble();
-    cairo_get_current_point(cairo.get(), &x0, &y0);
-    double x1 = x0 - CP.first, y1 = y0 - CP.second;
-    if (!rel) {
-      x1 += x0;
-      y1 += y0;
-    }
-    if (rel) {
-      CP = {x0 + x2, y0 + y2};
-      cairo_rel_curve_to(cairo.get(), x1, y1, x2, y2, x3, y3);
-    } else {
-      CP = {x2, y2};
-      cairo_curve_to(cairo.get(), x1, y1, x2, y2, x3, y3);
-    }
-  }
-  return CP;
-}
-
-using ControlPoint = std::pair<double, double>;
-static ControlPoint CairoDrawQuadraticCurve(cairo_t *cairo, double qx,
-                                            double qy, double x3, double y3,
-                                            bool rel) {
-  double x0 = 0., y0 = 0.;
-  if (!rel)
-    cairo_get_current_point(cairo, &x0, &y0);
-  // https://stackoverflow.com/a/3162732/1468532
-  double x1 = x0 + 2. / 3. * (qx - x0);
-  double y1 = y0 + 2. / 3. * (qy - y0);
-  double x2 = x3 + 2. / 3. * (qx - x3);
-  double y2 = y3 + 2. / 3. * (qy - y3);
-  ControlPoint CP;
-  if (rel) {
-    double X, Y;
-    cairo_get_current_point(cairo, &X, &Y);
-    CP = {X + x2, Y + y2};
-    cairo_rel_curve_to(cairo, x1, y1, x2, y2, x3, y3);
-  } else {
-    CP = {x2, y2};
-    cairo_curve_to(cairo, x1, y1, x2, y2, x3, y3);
-  }
-  return CP;
-}
-
-CairoSVGWriter::PathErrorOr<CairoSVGWriter::ControlPoint>
-CairoSVGWriter::CairoExecuteQuadraticBezier(std::string_view args, bool rel) {
-  if (args.empty())
-    return PathError("No arguments given to Q/q command");
-  PathNumber<true> qxArg, qyArg, x3Arg, y3Arg;
-  ControlPoint CP;
-  while (args.size()) {
-    if (!ExtractPathArgs(args, qxArg, qyArg, x3Arg, y3Arg))
-      return PathError("Invalid arguments given to Q/q command");
-    double x3 = x3Arg.toDouble(), y3 = y3Arg.toDouble();
-    // the quadratic curve's control point
-    double qx = qxArg.toDouble(), qy = qyArg.toDouble();
-    CP = CairoDrawQuadraticCurve(cairo.get(), qx, qy, x3, y3, rel);
-  }
-  return CP;
-}
-CairoSVGWriter::PathErrorOr<CairoSVGWriter::ControlPoint>
-CairoSVGWriter::CairoExecuteSmoothQuadraticBezier(
-    std::string_view args, bool rel,
-    const std::optional<ControlPoint> &PrevCP) {
-  if (args.empty())
-    return PathError("No arguments given to T/t command");
-  PathNumber<true> x3Arg, y3Arg;
-  ControlPoint CP;
-  if (!PrevCP) {
-    double x0, y0;
-    cairo_get_current_point(cairo.get(), &x0, &y0);
-    CP = {x0, y0};
-  } else
-    CP = *PrevCP;
-  while (args.size()) {
-    if (!ExtractPathArgs(args, x3Arg, y3Arg))
-      return PathError("Invalid arguments given to T/t command");
-    double x0, y0;
-    cairo_get_current_point(cairo.get(), &x0, &y0);
-    // CP is an absolute point and for a **cubic** curve
-    // From the formula that converts a quadratic control point into two
-    // cubic ones follows:
-    // x2 = x3 + 2/3 (q - x3) <=> q = 3/2(x2 - x3) + x3
-    // In this function's context x2 is CP and x3 the current point
-    double qx = 1.5 * (CP.first - x0) + x0, qy = 1.5 * (CP.second - y0) + y0;
-    // qx is now the previous control point in absolute coordinates.
-    // Therefore, mirror it on x0 and make it relative if necessary
-    qx = 2 * x0 - qx;
-    qy = 2 * y0 - qy;
-    if (rel) {
-      qx -= x0;
-      qy -= y0;
-    }
-    double x3 = x3Arg.toDouble(), y3 = y3Arg.toDouble();
-    CP = CairoDrawQuadraticCurve(cairo.get(), qx, qy, x3, y3, rel);
-  }
-  return CP;
-}
-CairoSVGWriter::PathErrorOrVoid
-CairoSVGWriter::CairoExecuteArc(std::string_view args, bool rel) {
-  PathNumber<false> rxArg, ryArg;
-  PathNumber<true> angleArg, x1Arg, y1Arg;
-  PathFlag largeArcFlag, sweepFlag;
-  const double Pi = std::acos(-1.);
-  while (args.size()) {
-    if (!ExtractPathArgs(args, rxArg, ryArg, angleArg, largeArcFlag, sweepFlag,
-                         x1Arg, y1Arg))
-      return PathError{"Not enough arguments given to A/a command"};
-    double x0, y0, x1 = x1Arg.toDouble(), y1 = y1Arg.toDouble(),
-                   rx = rxArg.toDouble(), ry = ryArg.toDouble();
-    double rotate = angleArg.toDouble() / 180 * Pi;
-    cairo_get_current_point(cairo.get(), &x0, &y0);
-    if (rx == 0. || ry == 0.) {
-      if (rel)
-        cairo_rel_line_to(cairo.get(), x1, y1);
-      else
-        cairo_line_to(cairo.get(), x1, y1);
-      continue;
-    }
-    // Make x1/y1 absolute
-    if (rel) {
-      x1 += x0;
-      y1 += y0;
-    }
-
-    // Set up a projection matrix to work in a normalized space
-    cairo_matrix_t proj_matrix;
-    // Make the svg ellipsis a circle
-    cairo_matrix_init_scale(&proj_matrix, 1., rx / ry);
-    // Align the svg ellipsis with the x axis
-    cairo_matrix_rotate(&proj_matrix, -rotate);
-    // Center the coordinate system around current point
-    cairo_matrix_translate(&proj_matrix, -x0, -y0);
-
-    // also create the inverse projection matrix
-    cairo_matrix_t inverse_proj_matrix;
-    cairo_matrix_init_translate(&inverse_proj_matrix, x0, y0);
-    cairo_matrix_rotate(&inverse_proj_matrix, rotate);
-    cairo_matrix_scale(&inverse_proj_matrix, 1., ry / rx);
-
-    // We now want to find the points c1/c2 that are 'rx' far away from the two
-    // points
-    double connx = x1, conny = y1; // connection point from x0 to x1.
-    // After the previous transformations, conn is just the projection of p1.
-    cairo_matrix_transform_point(&proj_matrix, &connx, &conny);
-    const double connLen = std::sqrt(std::pow(connx, 2.) + std::pow(conny, 2.));
-    const double midx = connx / 2.,
-                 midy = conny / 2.; // Halfway point from p0 tp p1
-    const double midLen = connLen / 2.;
-    double cos = midLen / rx;
-    if (cos > 1.) {
-      ry *= midLen / rx;
-      rx = midLen;
-      cos = 1.;
-    }
-    const double teta = std::acos(cos);
-    const double midToCLen = rx * std::sin(teta);
-    double normx = conny / connLen, normy = -connx / connLen;
-    double cx1 = midx + normx * midToCLen, cy1 = midy + normy * midToCLen;
-    double cx2 = midx - normx * midToCLen, cy2 = midy - normy * midToCLen;
-
-    double startAngle1 = std::atan(cy1 / cx1) + Pi;
-    double startAngle2 = std::atan(cy2 / cx2) + Pi;
-    double angleOffset = (Pi - 2. * teta);
-    // unproject circle centers
-    cairo_matrix_transform_point(&inverse_proj_matrix, &cx1, &cy1);
-    cairo_matrix_transform_point(&inverse_proj_matrix, &cx2, &cy2);
-    // Remember: Since y points down, angles are clock-wise.
-    // We have calculated with ccw angles, so some negatives are necessary
-    // below.
-    double startAngle, endAngle, cx, cy;
-    if (largeArcFlag.getValue() == sweepFlag.getValue()) {
-      cx = cx1;
-      cy = cy1;
-      startAngle = startAngle1;
-      endAngle = startAngle - angleOffset;
-    } else {
-      cx = cx2;
-      cy = cy2;
-      startAngle = startAngle2;
-      endAngle = startAngle + angleOffset;
-    }
-    if (x0 > x1) {
-      startAngle += Pi;
-      endAngle += Pi;
-    }
-    // Save the current matrix
-    cairo_matrix_t save_matrix;
-    cairo_get_matrix(cairo.get(), &save_matrix);
-
-    // Apply rotation and scaling again
-    cairo_translate(cairo.get(), cx, cy);
-    cairo_rotate(cairo.get(), rotate);
-    cairo_scale(cairo.get(), 1., ry / rx);
-    cairo_translate(cairo.get(), -cx, -cy);
-    // cairo_translate(cairo.get(), -x0, -y0);
-
-    if (sweepFlag.getValue() == '0')
-      cairo_arc_negative(cairo.get(), cx, cy, rx, startAngle, endAngle);
-    else
-      cairo_arc(cairo.get(), cx, cy, rx, startAngle, endAngle);
-    cairo_set_matrix(cairo.get(), &save_matrix);
-    cairo_move_to(cairo.get(), x1, y1);
-  }
-  return {};
-}
-
-CairoSVGWriter::PathErrorOrVoid
-CairoSVGWriter::CairoExecuteHLine(std::string_view length, bool rel) {
-  double X, Y;
-  cairo_get_current_point(cairo.get(), &X, &Y);
-  while (length.size()) {
-    PathNumber<true> lenStr;
-    if (!ExtractPathArgs(length, lenStr))
-      return PathError{"No argument given to H/h command"};
-    CSSUnit lenCss = CSSUnit::parse(*lenStr);
-    double len = convertCSSWidth(lenCss);
-    if (rel)
-      cairo_rel_line_to(cairo.get(), len, 0);
-    else
-      cairo_line_to(cairo.get(), len, Y);
-  }
-  return {};
-}
-CairoSVGWriter::PathErrorOrVoid
-CairoSVGWriter::CairoExecuteVLine(std::string_view length, bool rel) {
-  double X, Y;
-  cairo_get_current_point(cairo.get(), &X, &Y);
-  while (length.size()) {
-    PathNumber<true> lenStr;
-    if (!ExtractPathArgs(length, lenStr))
-      return PathError{"No argument given to V/v command"};
-    CSSUnit lenCss = CSSUnit::parse(*lenStr);
-    double len = convertCSSHeight(lenCss);
-    if (rel)
-      cairo_rel_line_to(cairo.get(), 0, len);
-    else
-      cairo_line_to(cairo.get(), X, len);
-  }
-  return {};
-}
-
-CairoSVGWriter::PathErrorOrVoid
-CairoSVGWriter::CairoExecuteLineTo(std::string_view points, bool rel) {
-  while (points.size()) {
-    PathNumber<true> xStr, yStr;
-    if (!ExtractPathArgs(points, xStr, yStr))
-      return PathError{"Not enough arguments given to L/l command"};
-    CSSUnit xCss = CSSUnit::parse(*xStr);
-    CSSUnit yCss = CSSUnit::parse(*yStr);
-    double x = convertCSSWidth(xCss);
-    double y = convertCSSHeight(yCss);
-    if (rel)
-      cairo_rel_line_to(cairo.get(), x, y);
-    else
-      cairo_line_to(cairo.get(), x, y);
-  }
-  return {};
-}
-CairoSVGWriter::PathErrorOrVoid
-CairoSVGWriter::CairoExecuteMoveTo(std::string_view points, bool rel) {
-  if (points.empty())
-    return PathError{"No arguments given to M/m command"};
-  PathNumber<true> xStr, yStr;
-  if (!ExtractPathArgs(points, xStr, yStr))
-    return PathError("Not enough arguments given to M/m command");
-  CSSUnit xCss = CSSUnit::parse(*xStr);
-  CSSUnit yCss = CSSUnit::parse(*yStr);
-  double x = convertCSSWidth(xCss);
-  double y = convertCSSHeight(yCss);
-  if (rel)
-    cairo_rel_move_to(cairo.get(), x, y);
-  else
-    cairo_move_to(cairo.get(), x, y);
-  CairoExecuteLineTo(points, rel);
-  return {};
+  PathData scaled = path;
+  scaled.transform(PathData::Matrix::scale(scale, scale));
+  scaled.visit(appender);
 }
 
-CairoSVGWriter::PathErrorOrVoid
-CairoSVGWriter::CairoExecutePath(const char *pathRaw) {
-  std::string_view path = strview_trim(pathRaw);
-  const char commands[] = "MmLlHhVvCcSsQqTtAaZz";
-  std::optional<ControlPoint> PrevCP;
-  // Invariant: There is always non-whitespace content in path and path is
-  // trimmed
-  while (path.size()) {
-    auto cmdpos = path.find_first_of(commands);
-    if (cmdpos == path.npos)
-      return PathError{"Did not find any valid commands"};
-    char cmd = path[cmdpos];
-    path.remove_prefix(cmdpos + 1);
-    auto argsEnd = path.find_first_of(commands);
-    std::string_view args = path.substr(0, argsEnd);
-    args = strview_trim(args);
-    if (argsEnd == path.npos)
-      path.remove_prefix(path.size());
-    else
-      path.remove_prefix(argsEnd);
-    const bool rel = std::tolower(cmd) == cmd;
-    PathErrorOrVoid err;
-    switch (std::tolower(cmd)) {
-    case 'm':
-      err = CairoExecuteMoveTo(args, rel);
-      PrevCP = std::nullopt;
-      break;
-    case 'l':
-      err = CairoExecuteLineTo(args, rel);
-      PrevCP = std::nullopt;
-      break;
-    case 'h':
-      err = CairoExecuteHLine(args, rel);
-      PrevCP = std::nullopt;
-      break;
-    case 'v':
-      err = CairoExecuteVLine(args, rel);
-      PrevCP = std::nullopt;
-      break;
-    case 'c': {
-      auto errOrCP = CairoExecuteCubicBezier(args, rel);
-      if (errOrCP)
-        err = errOrCP.to_error();
-      else
-        PrevCP = *errOrCP;
-      break;
-    }
-    case 's': {
-      auto errOrCP = CairoExecuteSmoothCubicBezier(args, rel, PrevCP);
-      if (errOrCP)
-        err = errOrCP.to_error();
-      else
-        PrevCP = *errOrCP;
-      break;
-    }
-    case 'q': {
-      auto errOrCP = CairoExecuteQuadraticBezier(args, rel);
-      if (errOrCP)
-        err = errOrCP.to_error();
-      else
-        PrevCP = *errOrCP;
-      break;
-    }
-    case 't': {
-      auto errOrCP = CairoExecuteSmoothQuadraticBezier(args, rel, PrevCP);
-      if (errOrCP)
-        err = errOrCP.to_error();
-      else
-        PrevCP = *errOrCP;
-      break;
-    }
-    case 'a':
-      err = CairoExecuteArc(args, rel);
-      PrevCP = std::nullopt;
-      break;
-    case 'z':
-      cairo_close_path(cairo.get());
-      PrevCP = std::nullopt;
-      break;
-    default:
-      svg_unreachable("Encountered unknown command");
-    }
-    if (err)
-      return err;
-  }
-  return {};
+void CairoSVGWriter::drawPoints(const AttrContainer &attrs, bool close) {
+  const char *points = nullptr;
+  struct AttrParser : public SVGAttributeVisitor<AttrParser> {
+    AttrParser(const char *&points) : points(points) {}
+    void visit_points(const svg::points &attr) { points = attr.cstrOrNull(); }
+    const char *&points;
+  } attrParser(points);
+  for (const SVGAttribute &Attr : attrs)
+    attrParser.visit(Attr);
+  if (!points)
+    return;
+  PathData path = PathData::fromPoints(points, close);
+  if (std::optional<PathData::Bounds> bounds = path.getBounds())
+    if (!isVisible(scaleBounds(*bounds, getUnitScale()), true))
+      return;
+  cairo_new_path(cairo.get());
+  appendPath(path);
+  applyCSSFillAndStroke(false);
 }
 
 void CairoSVGWriter::path_impl(const CairoSVGWriter::AttrContainer &attrs) {
-  openTag(TagType::path, attrs);
   std::optional<SVGAttribute> pathDesc;
   struct AttrParser : public SVGAttributeVisitor<AttrParser> {
     AttrParser(std::optional<SVGAttribute> &pathDesc) : pathDesc(pathDesc) {}
@@ -1082,17 +722,35 @@ void CairoSVGWriter::path_impl(const CairoSVGWriter::AttrContainer &attrs) {
   } attrParser(pathDesc);
   for (const SVGAttribute &Attr : attrs)
     attrParser.visit(Attr);
-  if (!pathDesc)
+  if (!pathDesc || !pathDesc->cstrOrNull())
     return;
-  // Just in case someone decides to start with a relative command
-  cairo_move_to(cairo.get(), 0., 0.);
-  if (auto err = CairoExecutePath(pathDesc->cstrOrNull()))
-    svg_unreachable(err.to_error().what().c_str());
+  const char *d = pathDesc->cstrOrNull();
+  double scale = getUnitScale();
+  if (const cairo_path_t *cached = pathCache->find(d, scale * viewScale)) {
+    if (std::optional<PathData::Bounds> bounds = getBounds(cached))
+      if (!isVisible(*bounds, true))
+        return;
+    cairo_new_path(cairo.get());
+    cairo_append_path(cairo.get(), cached);
+  } else {
+    PathData path = PathData::parse(d);
+    if (std::optional<PathData::Bounds> bounds = path.getBounds())
+      if (!isVisible(scaleBounds(*bounds, scale), true))
+        return;
+    cairo_new_path(cairo.get());
+    // Just in case someone decides to start with a relative command
+    cairo_move_to(cairo.get(), 0., 0.);
+    appendPath(path);
+    pathCache->insert(d, scale * viewScale, cairo_copy_path(cairo.get()));
+  }
   applyCSSFillAndStroke(false);
 }
 void CairoSVGWriter::pattern_impl(const CairoSVGWriter::AttrContainer &attrs) {}
-void CairoSVGWriter::polygon_impl(const CairoSVGWriter::AttrContainer &attrs) {}
+void CairoSVGWriter::polygon_impl(const CairoSVGWriter::AttrContainer &attrs) {
+  drawPoints(attrs, true);
+}
 void CairoSVGWriter::polyline_impl(const CairoSVGWriter::AttrContainer &attrs) {
+  drawPoints(attrs, false);
 }
 void CairoSVGWriter::radialGradient_impl(
     const CairoSVGWriter::AttrContainer &attrs) {}
@@ -1107,8 +765,13 @@ void CairoSVGWriter::rect_impl(const CairoSVGWriter::AttrContainer &attrs) {
   } attrParser(x, y);
   for (const SVGAttribute &Attr : attrs)
     attrParser.visit(Attr);
-  cairo_rectangle(cairo.get(), convertCSSWidth(x), convertCSSHeight(y),
-                  convertCSSWidth(width), convertCSSHeight(height));
+  double x0 = convertCSSWidth(x), y0 = convertCSSHeight(y);
+  double w = convertCSSWidth(width), h = convertCSSHeight(height);
+  if (!isVisible({std::min(x0, x0 + w), std::min(y0, y0 + h),
+                  std::max(x0, x0 + w), std::max(y0, y0 + h)},
+                 true))
+    return;
+  cairo_rectangle(cairo.get(), x0, y0, w, h);
   applyCSSFillAndStroke(false);
 }
 void CairoSVGWriter::script_impl(const CairoSVGWriter::AttrContainer &attrs) {}
@@ -1118,39 +781,62 @@ void CairoSVGWriter::solidcolor_impl(
 void CairoSVGWriter::stop_impl(const CairoSVGWriter::AttrContainer &attrs) {}
 void CairoSVGWriter::style_impl(const CairoSVGWriter::AttrContainer &attrs) {}
 void CairoSVGWriter::svg_impl(const CairoSVGWriter::AttrContainer &attrs) {
-  if (!width && !height) {
-    // We're allowed to read the document dimension from the svg tag.
-    // If this isn't possible, fall back to defaults __and do not try again__.
-    CSSUnit w, h;
-    struct DimFinder : public SVGAttributeVisitor<DimFinder> {
-      DimFinder(CSSUnit &w, CSSUnit &h) : w(w), h(h) {}
-      void visit_width(const svg::width &width) { w = CSSUnitFrom(width); }
-      void visit_height(const svg::height &height) { h = CSSUnitFrom(height); }
-      CSSUnit &w;
-      CSSUnit &h;
-    } findDims(w, h);
-    for (const SVGAttribute &attr : attrs)
-      findDims.visit(attr);
-    if (!w.length && !h.length) {
-      width = dfltWidth;
-      height = dfltHeight;
-    } else {
-      if (w.unit == CSSUnit::PERCENT)
-        width = w.length / 100 * getWidth();
-      else
-        width =
-            convertCSSLength(w, PNG); // Use any format that uses px as units
-      if (h.unit == CSSUnit::PERCENT)
-        height = h.length / 100 * getHeight();
-      else
-        height =
-            convertCSSLength(h, PNG); // Use any format that uses px as units
-    }
-    // Default dimensions might have changed, so re-init Cairo
-    initCairo();
-  }
+  // Nested <svg> elements only group their children
+  if (parents.empty())
+    initViewport(attrs);
   cairo_push_group(cairo.get());
 }
+
+void CairoSVGWriter::initViewport(const AttrContainer &attrs) {
+  CSSUnit w, h;
+  std::optional<SVGViewBox> viewBox;
+  SVGPreserveAspectRatio aspect;
+  struct AttrParser : public SVGAttributeVisitor<AttrParser> {
+    AttrParser(CSSUnit &w, CSSUnit &h, std::optional<SVGViewBox> &viewBox,
+               SVGPreserveAspectRatio &aspect)
+        : w(w), h(h), viewBox(viewBox), aspect(aspect) {}
+    void visit_width(const svg::width &width) { w = CSSUnitFrom(width); }
+    void visit_height(const svg::height &height) { h = CSSUnitFrom(height); }
+    void visit_viewBox(const svg::viewBox &box) {
+      viewBox = SVGViewBox::parse(static_cast<SVGAttribute>(box));
+    }
+    void visit_preserveAspectRatio(const svg::preserveAspectRatio &attr) {
+      aspect = SVGPreserveAspectRatio::parse(
+          static_cast<SVGAttribute>(attr).getValueStr());
+    }
+    CSSUnit &w;
+    CSSUnit &h;
+    std::optional<SVGViewBox> &viewBox;
+    SVGPreserveAspectRatio &aspect;
+  } attrParser(w, h, viewBox, aspect);
+  for (const SVGAttribute &attr : attrs)
+    attrParser.visit(attr);
+
+  // The size of the document in px, 0 where it isn't given
+  double docWidth = w.length ? toPixels(w, dfltWidth) : 0.;
+  double docHeight = h.length ? toPixels(h, dfltHeight) : 0.;
+  SVGViewport viewport =
+      SVGViewport::compute(docWidth, docHeight, viewBox, aspect, width,
+                           height, fit, dfltWidth, dfltHeight);
+  width = viewport.width;
+  height = viewport.height;
+  // Dimensions might have changed, so re-init Cairo
+  initCairo();
+
+  userWidth = viewport.userWidth;
+  userHeight = viewport.userHeight;
+  viewScale = viewport.getScale();
+  // Lengths are converted to output units before they reach Cairo, so only
+  // the translation needs converting
+  const PathData::Matrix &m = viewport.transform;
+  double unitScale = getUnitScale();
+  cairo_matrix_t matrix;
+  cairo_matrix_init(&matrix, m.a, m.b, m.c, m.d, m.e * unitScale,
+                    m.f * unitScale);
+  cairo_transform(cairo.get(), &matrix);
+  cairo_clip_extents(cairo.get(), &visible.x0, &visible.y0, &visible.x1,
+                     &visible.y1);
+}
 void CairoSVGWriter::switch__impl(const CairoSVGWriter::AttrContainer &attrs) {}
 void CairoSVGWriter::symbol_impl(const CairoSVGWriter::AttrContainer &attrs) {}
 void CairoSVGWriter::text_impl(const CairoSVGWriter::AttrContainer &attrs) {
@@ -1164,6 +850,7 @@ void CairoSVGWriter::text_impl(const CairoSVGWriter::AttrContainer &attrs) {
   } attrParser(x, y);
   for (const SVGAttribute &Attr : attrs)
     attrParser.visit(Attr);
+  culledText.clear();
   cairo_move_to(cairo.get(), convertCSSWidth(x), convertCSSHeight(y));
 }
 void CairoSVGWriter::textPath_impl(const CairoSVGWriter::AttrContainer &attrs) {
@@ -0,0 +1,361 @@
+#include "svgutils/svg_dedup_writer.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace svg;
+using TagType = SVGEvent::TagType;
+
+namespace {
+const char *XLinkDeclaration = "xmlns:xlink";
+const char *XLinkNamespace = "http://www.w3.org/1999/xlink";
+
+uint64_t combine(uint64_t seed, uint64_t value) {
+  return seed ^ (value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2));
+}
+
+uint64_t hashString(std::string_view str) {
+  return std::hash<std::string_view>()(str);
+}
+
+/// Elements a `<use>` can stand in for
+bool isGraphicsElement(TagType tag) {
+  switch (tag) {
+  case TagType::circle:
+  case TagType::ellipse:
+  case TagType::g:
+  case TagType::image:
+  case TagType::line:
+  case TagType::path:
+  case TagType::polygon:
+  case TagType::polyline:
+  case TagType::rect:
+  case TagType::text:
+  case TagType::use:
+    return true;
+  default:
+    return false;
+  }
+}
+
+/// Containers whose children render as they are. Elsewhere (e.g. in a
+/// clipPath or in text) a `<use>` is either not allowed or behaves
+/// differently.
+bool isPlainContainer(TagType tag) {
+  return tag == TagType::svg || tag == TagType::g || tag == TagType::a;
+}
+
+bool equalText(const char *lhs, const char *rhs) {
+  if (!lhs || !rhs)
+    return lhs == rhs;
+  return !std::strcmp(lhs, rhs);
+}
+
+bool equalEvents(const SVGEvent &lhs, const SVGEvent &rhs) {
+  if (lhs.getKind() != rhs.getKind() || lhs.getTagType() != rhs.getTagType() ||
+      !equalText(lhs.getText(), rhs.getText()) ||
+      lhs.getAttrs().size() != rhs.getAttrs().size())
+    return false;
+  for (size_t i = 0; i < lhs.getAttrs().size(); ++i) {
+    const SVGAttribute &lhsAttr = lhs.getAttrs()[i];
+    const SVGAttribute &rhsAttr = rhs.getAttrs()[i];
+    if (!equalText(lhsAttr.getName(), rhsAttr.getName()) ||
+        lhsAttr.getValueStr() != rhsAttr.getValueStr())
+      return false;
+  }
+  return true;
+}
+
+bool isXLinkDeclaration(const SVGAttribute &attr) {
+  return !std::strcmp(attr.getName(), XLinkDeclaration);
+}
+
+/// Copy of a tag event that declares the xlink namespace
+SVGEvent withXLinkDeclaration(const SVGEvent &event) {
+  std::vector<SVGAttribute> attrs = event.getAttrs();
+  attrs.push_back(SVGAttribute::Create(XLinkDeclaration, XLinkNamespace));
+  return SVGEvent(event.getTagType(), attrs);
+}
+
+bool isTransform(const SVGAttribute &attr) {
+  return attr.getName() == transform().getName();
+}
+
+/// Copy of a tag event without its transform, which goes to the <use>
+SVGEvent withoutTransform(const SVGEvent &event) {
+  std::vector<SVGAttribute> attrs;
+  for (const SVGAttribute &attr : event.getAttrs())
+    if (!isTransform(attr))
+      attrs.push_back(attr);
+  return SVGEvent(event.getTagType(), attrs);
+}
+
+/// Copy of an event of an eligible subtree (i.e. without custom tags)
+SVGEvent copyEvent(const SVGEvent &event) {
+  switch (event.getKind()) {
+  case SVGEvent::Kind::TAG:
+    return SVGEvent(event.getTagType(), event.getAttrs());
+  case SVGEvent::Kind::CONTENT:
+  case SVGEvent::Kind::COMMENT:
+    return SVGEvent(event.getKind(), event.getText());
+  case SVGEvent::Kind::ENTER:
+  case SVGEvent::Kind::LEAVE:
+    return SVGEvent(event.getKind());
+  case SVGEvent::Kind::CUSTOM_TAG:
+  case SVGEvent::Kind::FINISH:
+    break;
+  }
+  svg_unreachable("Unexpected event in subtree");
+}
+} // namespace
+
+SVGDedupWriter::RetTy SVGDedupWriter::addTag(SVGEvent &&event) {
+  completePending();
+  // `<use>` refers to definitions with xlink:href for SVG 1.1 consumers,
+  // which the root element declares once it is known to be needed
+  if (parents.empty() && event.getKind() == SVGEvent::Kind::TAG &&
+      event.getTagType() == TagType::svg) {
+    const std::vector<SVGAttribute> &attrs = event.getAttrs();
+    root = base + buffer.size();
+    xlinkDeclared =
+        std::any_of(attrs.begin(), attrs.end(), isXLinkDeclaration);
+  }
+  Node node;
+  node.start = base + buffer.size();
+  node.tag = event.getTagType();
+  node.hash = static_cast<uint64_t>(node.tag);
+  node.bytes = 0;
+  // Copies made by <use> have neither ids nor selectors matching them
+  node.eligible = event.getKind() == SVGEvent::Kind::TAG;
+  for (const SVGAttribute &attr : event.getAttrs()) {
+    if (isTransform(attr))
+      continue;
+    std::string value = attr.getValueStr();
+    node.hash = combine(node.hash, hashString(attr.getName()));
+    node.hash = combine(node.hash, hashString(value));
+    node.bytes += std::strlen(attr.getName()) + value.size();
+    if (attr.getName() == id().getName() ||
+        attr.getName() == class_().getName())
+      node.eligible = false;
+  }
+  node.inPlainContainers =
+      parents.empty() || (parents.back().inPlainContainers &&
+                          isPlainContainer(parents.back().tag));
+  push(std::move(event));
+  pending = node;
+  return status();
+}
+
+SVGDedupWriter::RetTy SVGDedupWriter::addText(SVGEvent &&event) {
+  completePending();
+  if (parents.size()) {
+    std::string_view text = event.getText();
+    addChild(combine(static_cast<uint64_t>(event.getKind()), hashString(text)),
+             text.size(), true);
+  }
+  push(std::move(event));
+  return status();
+}
+
+SVGDedupWriter::RetTy SVGDedupWriter::enter() {
+  assert(pending && "Cannot enter without current tag");
+  parents.push_back(*pending);
+  pending.reset();
+  push(SVGEvent(SVGEvent::Kind::ENTER));
+  return status();
+}
+
+SVGDedupWriter::RetTy SVGDedupWriter::leave() {
+  assert(parents.size() && "Cannot leave: No parent tag");
+  completePending();
+  Node node = parents.back();
+  // The definitions go to the end of the root element
+  if (parents.size() == 1)
+    pushDefs();
+  push(SVGEvent(SVGEvent::Kind::LEAVE));
+  parents.pop_back();
+  complete(node);
+  return status();
+}
+
+SVGDedupWriter::RetTy SVGDedupWriter::finish() {
+  completePending();
+  flush(base + buffer.size());
+  if (!error)
+    if (auto res = writer.finish())
+      error = res.to_error();
+  return status();
+}
+
+void SVGDedupWriter::completePending() {
+  if (!pending)
+    return;
+  Node node = *pending;
+  pending.reset();
+  complete(node);
+}
+
+void SVGDedupWriter::complete(const Node &node) {
+  Position end = base + buffer.size();
+  if (parents.empty()) {
+    // Root elements can't be replaced
+    flush(end);
+    return;
+  }
+  addChild(node.hash, node.bytes, node.eligible);
+  if (!node.eligible || !node.inPlainContainers ||
+      !isGraphicsElement(node.tag) || node.start < base ||
+      end - node.start > options.maxSubtreeEvents ||
+      node.bytes < options.minSubtreeBytes)
+    return;
+
+  ++stats.subtrees;
+  auto it = candidates.find(node.hash);
+  if (it == candidates.end()) {
+    addCandidate(node.hash, node.start);
+    return;
+  }
+  Candidate &candidate = it->second;
+  // Hashes are only a hint, compare the actual subtrees
+  auto first = buffer.begin() + (node.start - base);
+  if (candidate.events.size() != end - node.start ||
+      !equalEvents(candidate.events.front(), withoutTransform(*first)) ||
+      !std::equal(candidate.events.begin() + 1, candidate.events.end(),
+                  first + 1, equalEvents))
+    return;
+
+  if (candidate.id.empty()) {
+    candidate.id = options.idPrefix + std::to_string(definitions.size());
+    definitions.push_back(node.hash);
+    if (candidate.start >= base)
+      replace(candidate.start, candidate.start + candidate.events.size(),
+              node.hash);
+  }
+  replace(node.start, end, node.hash);
+}
+
+void SVGDedupWriter::replace(Position start, Position end, uint64_t hash) {
+  auto nested = replacements.upper_bound(start);
+  // Nothing to do within a range that is already replaced
+  if (nested != replacements.begin() && std::prev(nested)->second.end >= end)
+    return;
+  // Replacements within the range are superseded. If that leaves a
+  // definition without any use, it is dropped.
+  while (nested != replacements.end() && nested->first < end) {
+    --candidates.at(nested->second.hash).uses;
+    --stats.uses;
+    nested = replacements.erase(nested);
+  }
+  Replacement &replacement = replacements[start];
+  replacement.end = end;
+  replacement.hash = hash;
+  for (const SVGAttribute &attr : buffer[start - base].getAttrs())
+    if (isTransform(attr))
+      replacement.transform = attr.getValueStr();
+  ++candidates.at(hash).uses;
+  ++stats.uses;
+}
+
+void SVGDedupWriter::addChild(uint64_t hash, size_t bytes, bool eligible) {
+  Node &parent = parents.back();
+  parent.hash = combine(parent.hash, hash);
+  parent.bytes += bytes;
+  parent.eligible &= eligible;
+}
+
+void SVGDedupWriter::addCandidate(uint64_t hash, Position start) {
+  size_t size = base + buffer.size() - start;
+  // Make room by evicting the oldest candidates. Definitions are needed
+  // until the end of the document and stay.
+  while (candidateEvents + size > options.candidateBudget &&
+         candidateOrder.size()) {
+    auto it = candidates.find(candidateOrder.front());
+    candidateOrder.pop_front();
+    if (it == candidates.end() || it->second.id.size())
+      continue;
+    candidateEvents -= it->second.events.size();
+    candidates.erase(it);
+    ++stats.evictions;
+  }
+  if (candidateEvents + size > options.candidateBudget)
+    return;
+
+  Candidate &candidate = candidates[hash];
+  candidate.start = start;
+  candidate.events.reserve(size);
+  auto first = buffer.begin() + (start - base);
+  candidate.events.push_back(withoutTransform(*first));
+  for (auto it = first + 1; it != buffer.end(); ++it)
+    candidate.events.push_back(copyEvent(*it));
+  candidateOrder.push_back(hash);
+  candidateEvents += size;
+  ++stats.candidates;
+}
+
+void SVGDedupWriter::push(SVGEvent &&event) {
+  buffer.push_back(std::move(event));
+  // Flush down to half the buffer size, so that recent subtrees remain
+  // replaceable
+  if (buffer.size() > options.bufferSize)
+    flush(base + buffer.size() - options.bufferSize / 2);
+}
+
+void SVGDedupWriter::pushDefs() {
+  if (std::none_of(
+          definitions.begin(), definitions.end(),
+          [this](uint64_t hash) { return candidates.at(hash).uses > 0; }))
+    return;
+  push(SVGEvent(TagType::defs, {}));
+  push(SVGEvent(SVGEvent::Kind::ENTER));
+  for (uint64_t hash : definitions) {
+    const Candidate &candidate = candidates.at(hash);
+    if (!candidate.uses)
+      continue;
+    ++stats.defs;
+    const SVGEvent &first = candidate.events.front();
+    std::vector<SVGAttribute> attrs{id(candidate.id.c_str())};
+    attrs.insert(attrs.end(), first.getAttrs().begin(), first.getAttrs().end());
+    push(SVGEvent(first.getTagType(), attrs));
+    for (auto it = candidate.events.begin() + 1; it != candidate.events.end();
+         ++it)
+      push(copyEvent(*it));
+  }
+  push(SVGEvent(SVGEvent::Kind::LEAVE));
+}
+
+void SVGDedupWriter::flush(Position target) {
+  while (base < target && buffer.size()) {
+    auto replacement = replacements.begin();
+    if (replacement == replacements.end() || replacement->first != base) {
+      if (base == root && !xlinkDeclared && replacements.size()) {
+        forward(withXLinkDeclaration(buffer.front()));
+        xlinkDeclared = true;
+      } else
+        forward(buffer.front());
+      buffer.pop_front();
+      ++base;
+      continue;
+    }
+    std::string ref = "#" + candidates.at(replacement->second.hash).id;
+    std::vector<SVGAttribute> attrs{xlink_href(ref.c_str())};
+    if (replacement->second.transform.size())
+      attrs.emplace_back(transform(replacement->second.transform.c_str()));
+    // The root element was forwarded before any <use> was known
+    if (!xlinkDeclared)
+      attrs.insert(attrs.begin(),
+                   SVGAttribute::Create(XLinkDeclaration, XLinkNamespace));
+    forward(SVGEvent(TagType::use, attrs));
+    Position end = replacement->second.end;
+    buffer.erase(buffer.begin(), buffer.begin() + (end - base));
+    base = end;
+    replacements.erase(replacement);
+  }
+}
+
+void SVGDedupWriter::forward(const SVGEvent &event) {
+  // Like a writer that failed, ignore everything after an error
+  if (error)
+    return;
+  if (auto res = event.replay(writer))
+    error = res.to_error();
+}
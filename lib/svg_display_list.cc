@@ -0,0 +1,385 @@
+#include "svgutils/svg_display_list.h"
+#include "svgutils/svg_lengths.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+using namespace svg;
+
+namespace {
+/// Elements recorded as groups
+bool isGroup(const char *tagname) {
+  for (const char *name : {"g", "a", "switch"})
+    if (!std::strcmp(tagname, name))
+      return true;
+  return false;
+}
+
+template <typename T> void appendBytes(std::string &key, const T &value) {
+  key.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+} // namespace
+
+size_t SVGDisplayList::getMemoryUsage() const {
+  size_t res = items.capacity() * sizeof(Item) +
+               paints.capacity() * sizeof(Paint) +
+               dashes.capacity() * sizeof(double) +
+               verbs.capacity() * sizeof(PathData::Verb) +
+               coords.capacity() * sizeof(double) +
+               textRuns.capacity() * sizeof(TextRun);
+  for (const TextRun &run : textRuns)
+    res += run.text.capacity() + run.fontFamily.capacity();
+  return res;
+}
+
+PathData::Bounds SVGDisplayList::getTextBounds(double x, double y,
+                                               size_t length, double fontSize,
+                                               double strokeWidth) {
+  double margin = strokeWidth * MaxMiterExtent;
+  double w = (length + 1) * 2. * fontSize + margin;
+  double h = 2. * fontSize + margin;
+  return {x - w, y - h, x + w, y + h};
+}
+
+SVGDisplayListIndex::SVGDisplayListIndex(const SVGDisplayList &list,
+                                         double cellSize)
+    : list(list), cellSize(cellSize) {
+  assert(cellSize > 0. && "Cells need a size");
+  columns = std::max(1., std::ceil(list.getWidth() / cellSize));
+  rows = std::max(1., std::ceil(list.getHeight() / cellSize));
+  // Count the items of every cell first, so they fit into one array
+  const std::vector<SVGDisplayList::Item> &items = list.getItems();
+  cellStarts.assign(columns * rows + 1, 0);
+  auto forCells = [this](const PathData::Bounds &bounds, auto callback) {
+    auto [x0, x1] = getCellRange(bounds.x0, bounds.x1, columns);
+    auto [y0, y1] = getCellRange(bounds.y0, bounds.y1, rows);
+    for (size_t y = y0; y <= y1 && x0 <= x1; ++y)
+      for (size_t x = x0; x <= x1; ++x)
+        callback(y * columns + x);
+  };
+  for (const SVGDisplayList::Item &item : items) {
+    if (item.kind == SVGDisplayList::Kind::GROUP)
+      continue;
+    ++numItems;
+    forCells(item.bounds, [this](size_t cell) { ++cellStarts[cell + 1]; });
+  }
+  for (size_t i = 1; i < cellStarts.size(); ++i)
+    cellStarts[i] += cellStarts[i - 1];
+  cellItems.resize(cellStarts.back());
+  std::vector<uint32_t> ends(cellStarts.begin(), cellStarts.end() - 1);
+  for (uint32_t i = 0; i < items.size(); ++i)
+    if (items[i].kind != SVGDisplayList::Kind::GROUP)
+      forCells(items[i].bounds,
+               [&](size_t cell) { cellItems[ends[cell]++] = i; });
+}
+
+std::pair<size_t, size_t>
+SVGDisplayListIndex::getCellRange(double v0, double v1, size_t cells) const {
+  auto cell = [this, cells](double v) -> size_t {
+    double c = std::floor(v / cellSize);
+    return c < 0. ? 0 : c >= cells ? cells - 1 : static_cast<size_t>(c);
+  };
+  return {cell(v0), cell(v1)};
+}
+
+std::vector<uint32_t>
+SVGDisplayListIndex::query(const PathData::Bounds &area) const {
+  std::vector<uint32_t> res;
+  auto [x0, x1] = getCellRange(area.x0, area.x1, columns);
+  auto [y0, y1] = getCellRange(area.y0, area.y1, rows);
+  const std::vector<SVGDisplayList::Item> &items = list.getItems();
+  for (size_t y = y0; y <= y1 && x0 <= x1; ++y)
+    for (size_t x = x0; x <= x1; ++x) {
+      size_t cell = y * columns + x;
+      for (uint32_t i = cellStarts[cell]; i < cellStarts[cell + 1]; ++i)
+        if (items[cellItems[i]].bounds.intersects(area))
+          res.push_back(cellItems[i]);
+    }
+  // Items covering several cells were found more than once
+  std::sort(res.begin(), res.end());
+  res.erase(std::unique(res.begin(), res.end()), res.end());
+  return res;
+}
+
+size_t SVGDisplayListIndex::getMemoryUsage() const {
+  return (cellStarts.capacity() + cellItems.capacity()) * sizeof(uint32_t);
+}
+
+SVGDisplayListBuilder::RetTy
+SVGDisplayListBuilder::custom_tag(const char *tag,
+                                  const std::vector<SVGAttribute> &attrs) {
+  openTag(tag, attrs);
+  // The name doesn't outlive the call, and custom tags are ignored anyway
+  currentTag = "";
+  return {};
+}
+
+SVGDisplayListBuilder::RetTy SVGDisplayListBuilder::enter() {
+  assert(currentTag && "Cannot enter without root tag");
+  if (ignore || !rendersChildren(currentTag))
+    ++ignore;
+  else if (isGroup(currentTag)) {
+    groups.emplace(static_cast<uint32_t>(list.items.size()), parents.size());
+    constexpr double inf = std::numeric_limits<double>::infinity();
+    list.items.push_back({SVGDisplayList::Kind::GROUP, 0, 0, 0, 0,
+                          PathData::Bounds{inf, inf, -inf, -inf}});
+  }
+  parents.push(currentTag);
+  currentTag = nullptr;
+  return {};
+}
+
+SVGDisplayListBuilder::RetTy SVGDisplayListBuilder::leave() {
+  assert(parents.size() && "Cannot leave: No parent tag");
+  closeTag();
+  if (ignore)
+    --ignore;
+  currentTag = parents.top();
+  parents.pop();
+  if (groups.empty() || groups.top().second != parents.size())
+    return {};
+  uint32_t index = groups.top().first;
+  groups.pop();
+  SVGDisplayList::Item group = list.items[index];
+  group.first = static_cast<uint32_t>(list.items.size() - index - 1);
+  if (!group.first) {
+    // Empty groups are dropped
+    list.items.pop_back();
+    return {};
+  }
+  list.items[index] = group;
+  if (groups.size())
+    list.items[groups.top().first].bounds.unite(group.bounds);
+  return {};
+}
+
+SVGDisplayListBuilder::RetTy SVGDisplayListBuilder::finish() {
+  while (parents.size())
+    leave();
+  closeTag();
+  ignore = 0;
+  return {};
+}
+
+SVGDisplayListBuilder::RetTy SVGDisplayListBuilder::content(const char *text) {
+  closeTag();
+  if (!text || parents.empty())
+    return {};
+  // Stylesheets apply even if they are in e.g. <defs>
+  if (!std::strcmp(parents.top(), "style")) {
+    styles.addStylesheet(text);
+    return {};
+  }
+  if (ignore || std::strcmp(parents.top(), "text"))
+    return {};
+  // Text is placed and sized in the recorded px
+  const PathData::Matrix &m = viewport.transform;
+  double x = m.a * textX + m.c * textY + m.e;
+  double y = m.b * textX + m.d * textY + m.f;
+  double fontSize = toPixels(styles.getFontSize(), viewport.userWidth) *
+                    viewport.getScale();
+  SVGDisplayList::TextRun run{text,
+                              std::string(styles.getFontFamily()),
+                              fontSize,
+                              styles.getTextAnchor(),
+                              x,
+                              y,
+                              textStarted};
+  textStarted = true;
+  // Runs continuing the text start somewhere within the runs before
+  textLength += run.text.size();
+  uint32_t paint = getPaint(true);
+  double strokeWidth = list.paints[paint].hasStroke()
+                           ? list.paints[paint].strokeWidth
+                           : 0.;
+  addItem({SVGDisplayList::Kind::TEXT, paint,
+           static_cast<uint32_t>(list.textRuns.size()), 0, 0,
+           SVGDisplayList::getTextBounds(x, y, textLength, fontSize,
+                                         strokeWidth)});
+  list.textRuns.push_back(std::move(run));
+  return {};
+}
+
+SVGDisplayListBuilder::RetTy
+SVGDisplayListBuilder::openTag(const char *tag,
+                               const std::vector<SVGAttribute> &attrs) {
+  closeTag();
+  currentTag = tag;
+  styles.push(attrs, tag);
+  if (ignore)
+    return {};
+  auto is = [tag](const char *name) { return !std::strcmp(tag, name); };
+  if (is("svg"))
+    readDimensions(attrs);
+  else if (is("rect"))
+    addRect(attrs);
+  else if (is("circle") || is("ellipse"))
+    addEllipse(attrs, is("circle"));
+  else if (is("line"))
+    addLine(attrs);
+  else if (is("path")) {
+    if (const SVGAttribute *d = findAttr(attrs, "d")) {
+      PathData path = PathData::parse(d->getValueStr());
+      if (!path.getError().empty())
+        std::cerr << "Error in path data: " << path.getError()
+                  << ". Only the segments before it are drawn.\n";
+      addPath(std::move(path));
+    }
+  } else if (is("polyline") || is("polygon")) {
+    if (const SVGAttribute *points = findAttr(attrs, "points"))
+      addPath(PathData::fromPoints(points->getValueStr(), is("polygon")));
+  } else if (is("text")) {
+    textX = getLength(attrs, "x", viewport.userWidth);
+    textY = getLength(attrs, "y", viewport.userHeight);
+    textStarted = false;
+    textLength = 0;
+  }
+  return {};
+}
+
+void SVGDisplayListBuilder::closeTag() {
+  if (!currentTag)
+    return;
+  styles.pop();
+  currentTag = nullptr;
+}
+
+void SVGDisplayListBuilder::readDimensions(
+    const std::vector<SVGAttribute> &attrs) {
+  // Only the outermost svg element sets the document size
+  if (sizeRead)
+    return;
+  sizeRead = true;
+  double w = getLength(attrs, "width", list.width);
+  double h = getLength(attrs, "height", list.height);
+  std::optional<SVGViewBox> viewBox;
+  if (const SVGAttribute *attr = findAttr(attrs, "viewBox"))
+    viewBox = SVGViewBox::parse(*attr);
+  SVGPreserveAspectRatio aspect;
+  if (const SVGAttribute *attr = findAttr(attrs, "preserveAspectRatio"))
+    aspect = SVGPreserveAspectRatio::parse(attr->getValueStr());
+  // Everything is recorded in px of the document, which targets scale
+  viewport = SVGViewport::compute(std::max(w, 0.), std::max(h, 0.), viewBox,
+                                  aspect, 0., 0., SVGViewport::Fit::VIEWPORT,
+                                  list.width, list.height);
+  list.width = viewport.width;
+  list.height = viewport.height;
+}
+
+void SVGDisplayListBuilder::addRect(const std::vector<SVGAttribute> &attrs) {
+  double x = getLength(attrs, "x", viewport.userWidth);
+  double y = getLength(attrs, "y", viewport.userHeight);
+  double w = toPixels(styles.getWidth(), viewport.userWidth);
+  double h = toPixels(styles.getHeight(), viewport.userHeight);
+  if (w <= 0. || h <= 0.)
+    return;
+  PathData path;
+  path.moveTo(x, y);
+  path.lineTo(x + w, y);
+  path.lineTo(x + w, y + h);
+  path.lineTo(x, y + h);
+  path.close();
+  addPath(path);
+}
+
+void SVGDisplayListBuilder::addEllipse(const std::vector<SVGAttribute> &attrs,
+                                       bool circle) {
+  double rx = getLength(attrs, circle ? "r" : "rx", viewport.userWidth);
+  double ry = circle ? rx : getLength(attrs, "ry", viewport.userHeight);
+  if (rx <= 0. || ry <= 0.)
+    return;
+  double cx = getLength(attrs, "cx", viewport.userWidth);
+  double cy = getLength(attrs, "cy", viewport.userHeight);
+  // Four quarters, each approximated by a cubic curve, starting at angle 0
+  // in the direction cairo_arc draws
+  constexpr double k = 0.5522847498307936;
+  PathData path;
+  path.moveTo(cx + rx, cy);
+  path.cubicTo(cx + rx, cy + k * ry, cx + k * rx, cy + ry, cx, cy + ry);
+  path.cubicTo(cx - k * rx, cy + ry, cx - rx, cy + k * ry, cx - rx, cy);
+  path.cubicTo(cx - rx, cy - k * ry, cx - k * rx, cy - ry, cx, cy - ry);
+  path.cubicTo(cx + k * rx, cy - ry, cx + rx, cy - k * ry, cx + rx, cy);
+  path.close();
+  // The curves meet without corners
+  addPath(path, true, false);
+}
+
+void SVGDisplayListBuilder::addLine(const std::vector<SVGAttribute> &attrs) {
+  PathData path;
+  path.moveTo(getLength(attrs, "x1", viewport.userWidth),
+              getLength(attrs, "y1", viewport.userHeight));
+  path.lineTo(getLength(attrs, "x2", viewport.userWidth),
+              getLength(attrs, "y2", viewport.userHeight));
+  // Lines have no inside to fill
+  addPath(path, false, false);
+}
+
+void SVGDisplayListBuilder::addPath(PathData path, bool fill, bool joins) {
+  if (path.empty())
+    return;
+  uint32_t paint = getPaint(fill);
+  const SVGDisplayList::Paint &p = list.paints[paint];
+  if (!p.hasFill() && !p.hasStroke())
+    return;
+  path.transform(viewport.transform);
+  PathData::Bounds bounds = *path.getBounds();
+  if (p.hasStroke())
+    bounds = SVGDisplayList::getStrokeBounds(bounds, p.strokeWidth, joins);
+  addItem({SVGDisplayList::Kind::PATH, paint,
+           static_cast<uint32_t>(list.verbs.size()),
+           static_cast<uint32_t>(path.getVerbs().size()),
+           static_cast<uint32_t>(list.coords.size()), bounds});
+  list.verbs.insert(list.verbs.end(), path.getVerbs().begin(),
+                    path.getVerbs().end());
+  list.coords.insert(list.coords.end(), path.getCoords().begin(),
+                     path.getCoords().end());
+}
+
+void SVGDisplayListBuilder::addItem(const SVGDisplayList::Item &item) {
+  if (groups.size())
+    list.items[groups.top().first].bounds.unite(item.bounds);
+  list.items.push_back(item);
+}
+
+uint32_t SVGDisplayListBuilder::getPaint(bool fill) {
+  SVGDisplayList::Paint paint;
+  if (fill)
+    paint.fill = styles.getFill();
+  else
+    paint.fill.a = 0.;
+  paint.stroke = styles.getStroke();
+  // Lengths scale by the mean of both directions of the viewBox transform,
+  // which is exact unless preserveAspectRatio is none
+  double scale = viewport.getScale();
+  paint.strokeWidth =
+      toPixels(styles.getStrokeWidth(), getDiagonal()) * scale;
+  std::vector<double> dashes;
+  if (paint.hasStroke())
+    for (const CSSUnit &len : styles.getStrokeDasharray().dashes)
+      dashes.push_back(toPixels(len, getDiagonal()) * scale);
+
+  std::string key;
+  for (size_t i = 0; i < 4; ++i) {
+    appendBytes(key, paint.fill[i]);
+    appendBytes(key, paint.stroke[i]);
+  }
+  appendBytes(key, paint.strokeWidth);
+  for (double dash : dashes)
+    appendBytes(key, dash);
+  auto [it, inserted] = paintIndices.try_emplace(
+      std::move(key), static_cast<uint32_t>(list.paints.size()));
+  if (!inserted)
+    return it->second;
+  paint.firstDash = static_cast<uint32_t>(list.dashes.size());
+  paint.numDashes = static_cast<uint32_t>(dashes.size());
+  list.dashes.insert(list.dashes.end(), dashes.begin(), dashes.end());
+  list.paints.push_back(paint);
+  return it->second;
+}
+
+double SVGDisplayListBuilder::getDiagonal() const {
+  return svg::getDiagonal(viewport.userWidth, viewport.userHeight);
+}
@@ -0,0 +1,99 @@
+#include "svgutils/svg_document.h"
+
+#include <algorithm>
+
+using namespace svg;
+
+const std::string *SVGNode::getAttr(std::string_view name) const {
+  for (const Attr &attr : attrs)
+    if (attr.first == name)
+      return &attr.second;
+  return nullptr;
+}
+
+void SVGNode::setAttr(std::string_view name, std::string value) {
+  for (Attr &attr : attrs) {
+    if (attr.first == name) {
+      attr.second = std::move(value);
+      return;
+    }
+  }
+  attrs.emplace_back(name, std::move(value));
+}
+
+bool SVGNode::removeAttr(std::string_view name) {
+  auto it =
+      std::find_if(attrs.begin(), attrs.end(),
+                   [name](const Attr &attr) { return attr.first == name; });
+  if (it == attrs.end())
+    return false;
+  attrs.erase(it);
+  return true;
+}
+
+size_t SVGNode::countElements() const {
+  size_t count = isElement();
+  for (const auto &child : children)
+    count += child->countElements();
+  return count;
+}
+
+static SVGWriterErrorOr<void> writeNode(const SVGNode &node,
+                                        WriterConcept &writer) {
+  switch (node.kind) {
+  case SVGNode::Kind::DOCUMENT:
+    break;
+  case SVGNode::Kind::CONTENT:
+    return writer.content(node.name.c_str());
+  case SVGNode::Kind::COMMENT:
+    return writer.comment(node.name.c_str());
+  case SVGNode::Kind::ELEMENT: {
+    std::vector<SVGAttribute> attrs;
+    attrs.reserve(node.attrs.size());
+    for (const SVGNode::Attr &attr : node.attrs)
+      attrs.emplace_back(
+          SVGAttribute::Create(attr.first.c_str(), attr.second.c_str()));
+    WriterConcept::RetTy res;
+    switch (node.tag) {
+#define SVG_TAG(NAME, STR, ...)                                                \
+  case SVGNode::TagType::NAME:                                                 \
+    res = writer.NAME(attrs);                                                  \
+    break;
+#include "svgutils/svg_entities.def"
+    case SVGNode::TagType::NONE:
+      res = writer.custom_tag(node.name.c_str(), attrs);
+      break;
+    }
+    if (res || node.children.empty())
+      return res;
+    if (auto res = writer.enter())
+      return res;
+    for (const auto &child : node.children)
+      if (auto res = writeNode(*child, writer))
+        return res;
+    return writer.leave();
+  }
+  }
+  return {};
+}
+
+SVGWriterErrorOr<void> SVGDocument::write(WriterConcept &writer) const {
+  for (const auto &child : root->children)
+    if (auto res = writeNode(*child, writer))
+      return res;
+  return writer.finish();
+}
+
+SVGDocumentBuilder::RetTy SVGDocumentBuilder::enter() {
+  assert(last && last->isElement() && "Cannot enter without current tag");
+  current = last;
+  last = nullptr;
+  return {};
+}
+
+SVGDocumentBuilder::RetTy SVGDocumentBuilder::leave() {
+  assert(current->parent && "Cannot leave: No parent tag");
+  last = current;
+  current = current->parent;
+  return {};
+}
@@ -0,0 +1,59 @@
+#include "svgutils/svg_event.h"
+
+#include <cstring>
+
+using namespace svg;
+
+SVGEvent::SVGEvent(Kind kind) : SVGEvent(kind, TagType::NONE, nullptr, {}) {
+  assert((kind == Kind::ENTER || kind == Kind::LEAVE ||
+          kind == Kind::FINISH) &&
+         "Event kind requires arguments");
+}
+SVGEvent::SVGEvent(Kind kind, const char *text)
+    : SVGEvent(kind, TagType::NONE, text, {}) {
+  assert((kind == Kind::CONTENT || kind == Kind::COMMENT) &&
+         "Only content and comment events carry text");
+}
+SVGEvent::SVGEvent(TagType tag, const std::vector<SVGAttribute> &attrs)
+    : SVGEvent(Kind::TAG, tag, nullptr, attrs) {}
+SVGEvent::SVGEvent(const char *customTag,
+                   const std::vector<SVGAttribute> &attrs)
+    : SVGEvent(Kind::CUSTOM_TAG, TagType::NONE, nullptr, attrs) {
+  text = customTag;
+}
+
+SVGEvent::SVGEvent(Kind kind, TagType tag, const char *text,
+                   const std::vector<SVGAttribute> &attrs)
+    : kind(kind), tag(tag) {
+  // Compute the required storage first so that a single allocation suffices
+  size_t size = 0;
+  if (text)
+    size += std::strlen(text) + 1;
+  for (const SVGAttribute &attr : attrs) {
+    if (!SVGAttribute::IsUniqueName(attr.name))
+      size += std::strlen(attr.name) + 1;
+    if (const char *value = attr.cstrOrNull())
+      size += std::strlen(value) + 1;
+  }
+  if (size)
+    strings = std::make_unique<char[]>(size);
+  char *pos = strings.get();
+  auto copy = [&pos](const char *str) {
+    size_t len = std::strlen(str) + 1;
+    std::memcpy(pos, str, len);
+    const char *res = pos;
+    pos += len;
+    return res;
+  };
+
+  if (text)
+    this->text = copy(text);
+  this->attrs.reserve(attrs.size());
+  for (const SVGAttribute &attr : attrs) {
+    SVGAttribute &owned = this->attrs.emplace_back(attr);
+    if (!SVGAttribute::IsUniqueName(attr.name))
+      owned.name = copy(attr.name);
+    if (const char *value = attr.cstrOrNull())
+      owned.value = copy(value);
+  }
+}
@@ -0,0 +1,61 @@
+#include "svgutils/svg_lengths.h"
+#include "svgutils/utils.h"
+
+#include <cmath>
+#include <cstring>
+
+using namespace svg;
+
+bool svg::rendersChildren(const char *tagname) {
+  for (const char *name : {"svg", "g", "a", "switch", "text"})
+    if (!std::strcmp(tagname, name))
+      return true;
+  return false;
+}
+
+const SVGAttribute *svg::findAttr(const std::vector<SVGAttribute> &attrs,
+                                  const char *name) {
+  for (const SVGAttribute &attr : attrs)
+    if (!std::strcmp(attr.getName(), name))
+      return &attr;
+  return nullptr;
+}
+
+CSSUnit svg::CSSUnitFrom(const SVGAttribute &attr) {
+  if (const char *cstr = attr.cstrOrNull())
+    return CSSUnit::parse(cstr);
+  CSSUnit res;
+  res.length = attr.toDouble();
+  return res;
+}
+
+double svg::toPixels(const CSSUnit &unit, double reference) {
+  switch (unit.unit) {
+  case CSSUnit::PERCENT:
+    return unit.length / 100. * reference;
+  case CSSUnit::PX:
+    return unit.length;
+  case CSSUnit::PT:
+    return unit.length * 1.25;
+  case CSSUnit::PC:
+    return unit.length * 15.;
+  case CSSUnit::MM:
+    return unit.length * 3.543307;
+  case CSSUnit::CM:
+    return unit.length * 35.43307;
+  case CSSUnit::IN:
+    return unit.length * 90.;
+  }
+  svg_unreachable("Encountered unexpected css unit");
+}
+
+double svg::getLength(const std::vector<SVGAttribute> &attrs,
+                      const char *name, double reference) {
+  if (const SVGAttribute *attr = findAttr(attrs, name))
+    return toPixels(CSSUnitFrom(*attr), reference);
+  return 0.;
+}
+
+double svg::getDiagonal(double width, double height) {
+  return std::sqrt((width * width + height * height) / 2.);
+}
@@ -0,0 +1,630 @@
+#include "svgutils/svg_minifying_writer.h"
+#include "svgutils/css_utils.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <map>
+
+using namespace svg;
+
+namespace {
+enum class AttrKind { OTHER, PATH, COLOR, NUMBERS };
+
+AttrKind classifyAttr(const char *name) {
+  // Attribute names are unique, so pointer comparison suffices
+  if (name == d().getName())
+    return AttrKind::PATH;
+  for (const char *colorAttr :
+       {fill().getName(), stroke().getName(), stop_color().getName(),
+        flood_color().getName(), lighting_color().getName(),
+        color().getName()})
+    if (name == colorAttr)
+      return AttrKind::COLOR;
+  for (const char *numbersAttr :
+       {x().getName(), y().getName(), x1().getName(), svg::y1().getName(),
+        x2().getName(), y2().getName(), cx().getName(), cy().getName(),
+        r().getName(), rx().getName(), ry().getName(), dx().getName(),
+        dy().getName(), width().getName(), height().getName(),
+        points().getName(), viewBox().getName(), transform().getName(),
+        stroke_width().getName(), stroke_dasharray().getName(),
+        stroke_dashoffset().getName(), opacity().getName(),
+        fill_opacity().getName(), stroke_opacity().getName(),
+        stop_opacity().getName(), offset().getName(),
+        font_size().getName()})
+    if (name == numbersAttr)
+      return AttrKind::NUMBERS;
+  return AttrKind::OTHER;
+}
+
+/// Returns true if @p attr has the default value declared in
+/// svg_entities.def.
+bool isDefaultValue(const SVGAttribute &attr) {
+  const char *value = attr.cstrOrNull();
+  if (!value)
+    return false;
+#define SVG_ATTR(NAME, STR, DEFAULT)                                           \
+  if (attr.getName() == svg::NAME().getName())                                 \
+    return std::strlen(DEFAULT) && !std::strcmp(value, DEFAULT);
+#include "svgutils/svg_entities.def"
+  return false;
+}
+
+double roundTo(double value, unsigned precision) {
+  static constexpr double Scales[] = {1e0, 1e1, 1e2, 1e3,  1e4,  1e5, 1e6,
+                                      1e7, 1e8, 1e9, 1e10, 1e11, 1e12};
+  double scale = Scales[precision];
+  double rounded = std::round(value * scale) / scale;
+  // Avoid printing -0
+  return rounded == 0. ? 0. : rounded;
+}
+
+double toDouble(std::string_view number) {
+  char buf[64];
+  if (number.size() >= sizeof(buf))
+    // Long numbers (e.g. many leading zeros) mustn't be cut off
+    return std::strtod(std::string(number).c_str(), nullptr);
+  std::memcpy(buf, number.data(), number.size());
+  buf[number.size()] = '\0';
+  return std::strtod(buf, nullptr);
+}
+
+/// Appends tokens of path data and only inserts separators where the
+/// tokens would merge otherwise.
+struct PathBuilder {
+  enum class Last { NONE, NUMBER, DOTTED_NUMBER, FLAG };
+  std::string str;
+  Last last = Last::NONE;
+
+  void command(char cmd) {
+    str += cmd;
+    last = Last::NONE;
+  }
+  void number(const std::string &num) {
+    bool needsSep = false;
+    if (num.front() != '-') {
+      if (last == Last::NUMBER)
+        needsSep = true;
+      else if (last == Last::DOTTED_NUMBER)
+        needsSep = num.front() != '.';
+    }
+    if (needsSep)
+      str += ' ';
+    str += num;
+    last = num.find('.') == std::string::npos ? Last::NUMBER
+                                              : Last::DOTTED_NUMBER;
+  }
+  void flag(bool value) {
+    // A flag is a single character, so the next token may follow directly
+    if (last == Last::NUMBER || last == Last::DOTTED_NUMBER)
+      str += ' ';
+    str += value ? '1' : '0';
+    last = Last::FLAG;
+  }
+};
+
+struct Point {
+  double x = 0.;
+  double y = 0.;
+};
+
+class PathMinifier {
+public:
+  PathMinifier(std::string_view input, unsigned precision)
+      : input(input), precision(precision) {}
+
+  std::optional<std::string> run();
+
+private:
+  // Input scanning
+  void skipSeparator();
+  bool atArgument();
+  bool readNumber(double &value);
+  bool readFlag(bool &value);
+  bool readPoint(Point &pt, bool rel);
+
+  // Output
+  struct Candidate {
+    char cmd;
+    PathBuilder builder;
+    Point end;
+  };
+  Candidate begin(char cmd) const;
+  void add(Candidate &cand, double value) const {
+    cand.builder.number(SVGMinifyingWriter::formatNumber(value, precision));
+  }
+  /// Adds @p pt in absolute or relative coordinates and returns the
+  /// position a renderer will compute from the written numbers.
+  Point addPoint(Candidate &cand, Point pt, bool rel) const;
+  void emit(Candidate *cand, Candidate *other = nullptr);
+  bool canOmitCommand(char cmd) const;
+
+  std::string_view input;
+  size_t pos = 0;
+  unsigned precision;
+  /// Current point and start of the subpath as given by the input
+  Point in, inStart;
+  /// Current point and start of the subpath as seen by a renderer of the
+  /// output (i.e. after rounding)
+  Point out, outStart;
+  PathBuilder result;
+  char lastCmd = 0;
+};
+
+void PathMinifier::skipSeparator() {
+  while (pos < input.size() &&
+         std::isspace(static_cast<unsigned char>(input[pos])))
+    ++pos;
+  if (pos < input.size() && input[pos] == ',') {
+    ++pos;
+    while (pos < input.size() &&
+           std::isspace(static_cast<unsigned char>(input[pos])))
+      ++pos;
+  }
+}
+bool PathMinifier::atArgument() {
+  while (pos < input.size() &&
+         std::isspace(static_cast<unsigned char>(input[pos])))
+    ++pos;
+  return pos < input.size() &&
+         !std::isalpha(static_cast<unsigned char>(input[pos]));
+}
+bool PathMinifier::readNumber(double &value) {
+  size_t len = strview_scan_number(input.substr(pos));
+  if (!len)
+    return false;
+  value = toDouble(input.substr(pos, len));
+  pos += len;
+  skipSeparator();
+  return true;
+}
+bool PathMinifier::readFlag(bool &value) {
+  if (pos >= input.size() || (input[pos] != '0' && input[pos] != '1'))
+    return false;
+  value = input[pos++] == '1';
+  skipSeparator();
+  return true;
+}
+bool PathMinifier::readPoint(Point &pt, bool rel) {
+  if (!readNumber(pt.x) || !readNumber(pt.y))
+    return false;
+  if (rel) {
+    pt.x += in.x;
+    pt.y += in.y;
+  }
+  return true;
+}
+
+PathMinifier::Candidate PathMinifier::begin(char cmd) const {
+  Candidate cand{cmd, PathBuilder(), out};
+  cand.builder.last = result.last;
+  if (!canOmitCommand(cmd))
+    cand.builder.command(cmd);
+  return cand;
+}
+
+Point PathMinifier::addPoint(Candidate &cand, Point pt, bool rel) const {
+  if (rel) {
+    double dx = roundTo(pt.x - out.x, precision);
+    double dy = roundTo(pt.y - out.y, precision);
+    add(cand, dx);
+    add(cand, dy);
+    return {roundTo(out.x + dx, precision), roundTo(out.y + dy, precision)};
+  }
+  Point rounded{roundTo(pt.x, precision), roundTo(pt.y, precision)};
+  add(cand, rounded.x);
+  add(cand, rounded.y);
+  return rounded;
+}
+
+bool PathMinifier::canOmitCommand(char cmd) const {
+  // Coordinates following a moveto are implicit linetos
+  if ((lastCmd == 'M' && cmd == 'L') || (lastCmd == 'm' && cmd == 'l'))
+    return true;
+  return cmd == lastCmd && cmd != 'M' && cmd != 'm' && cmd != 'Z' &&
+         cmd != 'z';
+}
+
+void PathMinifier::emit(Candidate *cand, Candidate *other) {
+  if (other && other->builder.str.size() < cand->builder.str.size())
+    cand = other;
+  result.str += cand->builder.str;
+  result.last = cand->builder.last;
+  lastCmd = cand->cmd;
+  out = cand->end;
+}
+
+std::optional<std::string> PathMinifier::run() {
+  char cmd = 0;
+  while (true) {
+    while (pos < input.size() &&
+           std::isspace(static_cast<unsigned char>(input[pos])))
+      ++pos;
+    if (pos == input.size())
+      break;
+    if (std::isalpha(static_cast<unsigned char>(input[pos]))) {
+      cmd = input[pos++];
+      skipSeparator();
+    } else if (!cmd)
+      return std::nullopt;
+
+    bool rel = std::islower(static_cast<unsigned char>(cmd));
+    char upper = std::toupper(static_cast<unsigned char>(cmd));
+    if (upper == 'Z') {
+      Candidate z = begin('z');
+      emit(&z);
+      in = inStart;
+      out = outStart;
+      // Arguments after Z aren't allowed
+      cmd = 0;
+      continue;
+    }
+    // Every command but Z requires at least one set of arguments
+    if (!atArgument())
+      return std::nullopt;
+    do {
+      Point pt, c1, c2;
+      switch (upper) {
+      case 'M': {
+        if (!readPoint(pt, rel))
+          return std::nullopt;
+        Candidate abs = begin('M'), relc = begin('m');
+        abs.end = addPoint(abs, pt, false);
+        relc.end = addPoint(relc, pt, true);
+        emit(&abs, &relc);
+        inStart = pt;
+        outStart = out;
+        // Following coordinate pairs are linetos
+        cmd = rel ? 'l' : 'L';
+        upper = 'L';
+        break;
+      }
+      case 'L':
+      case 'H':
+      case 'V': {
+        pt = in;
+        if (upper == 'H') {
+          if (!readNumber(pt.x))
+            return std::nullopt;
+          if (rel)
+            pt.x += in.x;
+        } else if (upper == 'V') {
+          if (!readNumber(pt.y))
+            return std::nullopt;
+          if (rel)
+            pt.y += in.y;
+        } else if (!readPoint(pt, rel))
+          return std::nullopt;
+        double dx = roundTo(pt.x - out.x, precision);
+        double dy = roundTo(pt.y - out.y, precision);
+        Candidate abs = begin('L'), relc = begin('l');
+        if (dy == 0.) {
+          abs = begin('H');
+          relc = begin('h');
+          double x = roundTo(pt.x, precision);
+          add(abs, x);
+          add(relc, dx);
+          abs.end.x = x;
+          relc.end.x = roundTo(out.x + dx, precision);
+        } else if (dx == 0.) {
+          abs = begin('V');
+          relc = begin('v');
+          double y = roundTo(pt.y, precision);
+          add(abs, y);
+          add(relc, dy);
+          abs.end.y = y;
+          relc.end.y = roundTo(out.y + dy, precision);
+        } else {
+          abs.end = addPoint(abs, pt, false);
+          relc.end = addPoint(relc, pt, true);
+        }
+        emit(&abs, &relc);
+        break;
+      }
+      case 'C':
+        if (!readPoint(c1, rel) || !readPoint(c2, rel) || !readPoint(pt, rel))
+          return std::nullopt;
+        {
+          Candidate abs = begin('C'), relc = begin('c');
+          addPoint(abs, c1, false);
+          addPoint(abs, c2, false);
+          abs.end = addPoint(abs, pt, false);
+          addPoint(relc, c1, true);
+          addPoint(relc, c2, true);
+          relc.end = addPoint(relc, pt, true);
+          emit(&abs, &relc);
+        }
+        break;
+      case 'S':
+      case 'Q':
+        if (!readPoint(c1, rel) || !readPoint(pt, rel))
+          return std::nullopt;
+        {
+          Candidate abs = begin(upper),
+                    relc = begin(static_cast<char>(
+                        std::tolower(static_cast<unsigned char>(upper))));
+          addPoint(abs, c1, false);
+          abs.end = addPoint(abs, pt, false);
+          addPoint(relc, c1, true);
+          relc.end = addPoint(relc, pt, true);
+          emit(&abs, &relc);
+        }
+        break;
+      case 'T':
+        if (!readPoint(pt, rel))
+          return std::nullopt;
+        {
+          Candidate abs = begin('T'), relc = begin('t');
+          abs.end = addPoint(abs, pt, false);
+          relc.end = addPoint(relc, pt, true);
+          emit(&abs, &relc);
+        }
+        break;
+      case 'A': {
+        double radiusX, radiusY, angle;
+        bool largeArc, sweep;
+        if (!readNumber(radiusX) || !readNumber(radiusY) ||
+            !readNumber(angle) || !readFlag(largeArc) || !readFlag(sweep) ||
+            !readPoint(pt, rel))
+          return std::nullopt;
+        Candidate abs = begin('A'), relc = begin('a');
+        for (Candidate *cand : {&abs, &relc}) {
+          add(*cand, radiusX);
+          add(*cand, radiusY);
+          add(*cand, angle);
+          cand->builder.flag(largeArc);
+          cand->builder.flag(sweep);
+        }
+        abs.end = addPoint(abs, pt, false);
+        relc.end = addPoint(relc, pt, true);
+        emit(&abs, &relc);
+        break;
+      }
+      default:
+        return std::nullopt;
+      }
+      in = pt;
+    } while (atArgument());
+  }
+  return std::move(result.str);
+}
+
+/// Splits @p color into 8-bit channels. Only opaque hex, rgb() and named
+/// colors are handled.
+std::optional<uint32_t> parseRGB(std::string_view color) {
+  auto hexDigit = [](char c) -> int {
+    if (std::isdigit(static_cast<unsigned char>(c)))
+      return c - '0';
+    c = std::tolower(static_cast<unsigned char>(c));
+    if (c >= 'a' && c <= 'f')
+      return c - 'a' + 10;
+    return -1;
+  };
+  if (color.size() && color.front() == '#') {
+    color.remove_prefix(1);
+    if (color.size() != 3 && color.size() != 6)
+      return std::nullopt;
+    uint32_t rgb = 0;
+    for (char c : color) {
+      int digit = hexDigit(c);
+      if (digit < 0)
+        return std::nullopt;
+      rgb = (rgb << 4) | digit;
+      // #rgb is short for #rrggbb
+      if (color.size() == 3)
+        rgb = (rgb << 4) | digit;
+    }
+    return rgb;
+  }
+  if (color.substr(0, 4) == "rgb(" && color.back() == ')') {
+    std::string_view args = color.substr(4, color.size() - 5);
+    uint32_t rgb = 0;
+    for (unsigned i = 0; i < 3; ++i) {
+      args = strview_trim(args);
+      size_t len = strview_scan_number(args);
+      if (!len)
+        return std::nullopt;
+      double value = toDouble(args.substr(0, len));
+      args.remove_prefix(len);
+      if (args.size() && args.front() == '%') {
+        value = value * 255. / 100.;
+        args.remove_prefix(1);
+      }
+      // Only exact channel values can be shortened without a change
+      if (value != std::round(value) || value < 0. || value > 255.)
+        return std::nullopt;
+      rgb = (rgb << 8) | static_cast<uint32_t>(value);
+      args = strview_trim(args);
+      if (i < 2) {
+        if (args.empty() || args.front() != ',')
+          return std::nullopt;
+        args.remove_prefix(1);
+      }
+    }
+    if (args.size())
+      return std::nullopt;
+    return rgb;
+  }
+  std::optional<CSSColor> named = CSSColor::fromName(color);
+  if (!named || named->a != 1.)
+    return std::nullopt;
+  uint32_t rgb = 0;
+  for (unsigned i = 0; i < 3; ++i)
+    rgb = (rgb << 8) | static_cast<uint32_t>(std::round((*named)[i] * 255.));
+  return rgb;
+}
+
+/// The shortest color name for each color value that has one
+const std::map<uint32_t, std::string_view> &getShortestColorNames() {
+  static const std::map<uint32_t, std::string_view> names = []() {
+    std::map<uint32_t, std::string_view> names;
+    auto add = [&names](std::string_view name, std::string_view value) {
+      std::optional<uint32_t> rgb = parseRGB(value);
+      // Skips transparent
+      if (!rgb)
+        return;
+      auto it = names.find(*rgb);
+      if (it == names.end() || name.size() < it->second.size())
+        names[*rgb] = name;
+    };
+#define CSS_COLOR(NAME, VALUE) add(NAME, VALUE);
+#include "svgutils/css_colors.def"
+    return names;
+  }();
+  return names;
+}
+} // namespace
+
+std::string SVGMinifyingWriter::formatNumber(double value,
+                                             unsigned precision) {
+  precision = std::min(precision, MaxPrecision);
+  double rounded = roundTo(value, precision);
+  char buf[64];
+  int len = std::snprintf(buf, sizeof(buf), "%.*f", precision, rounded);
+  std::string res;
+  if (len < static_cast<int>(sizeof(buf)))
+    res.assign(buf, std::max(len, 0));
+  else {
+    // Large values don't fit, print them again into a buffer of their size
+    res.resize(len);
+    std::snprintf(res.data(), len + 1, "%.*f", precision, rounded);
+  }
+  if (res.find('.') != std::string::npos) {
+    while (res.back() == '0')
+      res.pop_back();
+    if (res.back() == '.')
+      res.pop_back();
+  }
+  // 0.5 -> .5 and -0.5 -> -.5
+  size_t zeroPos = res.front() == '-' ? 1 : 0;
+  if (res.size() > zeroPos + 1 && res[zeroPos] == '0' &&
+      res[zeroPos + 1] == '.')
+    res.erase(zeroPos, 1);
+  return res;
+}
+
+std::string SVGMinifyingWriter::minifyPathData(std::string_view d,
+                                               unsigned precision) {
+  PathMinifier minifier(d, std::min(precision, MaxPrecision));
+  if (auto res = minifier.run())
+    return *res;
+  return std::string(d);
+}
+
+std::string SVGMinifyingWriter::minifyNumbers(std::string_view value,
+                                              unsigned precision) {
+  std::string res;
+  res.reserve(value.size());
+  // Whether a separator is needed before the next number or identifier
+  bool needsSep = false;
+  size_t pos = 0;
+  while (pos < value.size()) {
+    char c = value[pos];
+    if (std::isspace(static_cast<unsigned char>(c)) || c == ',') {
+      ++pos;
+      continue;
+    }
+    if (size_t len = strview_scan_number(value.substr(pos))) {
+      if (needsSep)
+        res += ' ';
+      res += formatNumber(toDouble(value.substr(pos, len)), precision);
+      pos += len;
+      // Units and percentages stick to their number
+      while (pos < value.size() &&
+             (std::isalpha(static_cast<unsigned char>(value[pos])) ||
+              value[pos] == '%'))
+        res += value[pos++];
+      needsSep = true;
+    } else if (std::isalpha(static_cast<unsigned char>(c))) {
+      if (needsSep)
+        res += ' ';
+      while (pos < value.size() &&
+             (std::isalnum(static_cast<unsigned char>(value[pos])) ||
+              value[pos] == '-'))
+        res += value[pos++];
+      needsSep = true;
+    } else if (c == '(' || c == ')') {
+      res += c;
+      ++pos;
+      needsSep = false;
+    } else
+      return std::string(value);
+  }
+  return res;
+}
+
+std::string SVGMinifyingWriter::minifyColor(std::string_view color) {
+  std::string_view trimmed = strview_trim(color);
+  std::optional<uint32_t> rgb = parseRGB(trimmed);
+  if (!rgb)
+    return std::string(color);
+  static constexpr char Hex[] = "0123456789abcdef";
+  std::string res = "#000000";
+  for (unsigned i = 0; i < 6; ++i)
+    res[i + 1] = Hex[(*rgb >> (20 - 4 * i)) & 0xf];
+  if (res[1] == res[2] && res[3] == res[4] && res[5] == res[6])
+    res = {'#', res[1], res[3], res[5]};
+  const auto &names = getShortestColorNames();
+  auto it = names.find(*rgb);
+  if (it != names.end() && it->second.size() < res.size())
+    res = it->second;
+  return res;
+}
+
+void SVGMinifyingWriter::writeAttr(const SVGAttribute &attr) {
+  output() << ' ' << attr.getName() << "=\"";
+  if (const char *value = attr.cstrOrNull()) {
+    switch (classifyAttr(attr.getName())) {
+    case AttrKind::PATH:
+      output() << minifyPathData(value, precision);
+      break;
+    case AttrKind::COLOR:
+      output() << minifyColor(value);
+      break;
+    case AttrKind::NUMBERS:
+      output() << minifyNumbers(value, precision);
+      break;
+    case AttrKind::OTHER:
+      output() << value;
+      break;
+    }
+  } else if (const SVGNumberTuple *tuple = attr.tupleOrNull()) {
+    if (tuple->getFunction())
+      output() << tuple->getFunction() << '(';
+    for (size_t i = 0; i < tuple->size(); ++i)
+      output() << (i ? " " : "") << formatNumber((*tuple)[i], precision);
+    if (tuple->getFunction())
+      output() << ')';
+  } else if (classifyAttr(attr.getName()) == AttrKind::OTHER)
+    attr.writeValue(output());
+  else
+    output() << formatNumber(attr.toDouble(), precision);
+  output() << '"';
+}
+
+void SVGMinifyingWriter::openTag(const char *tagname,
+                                 const std::vector<SVGAttribute> &attrs) {
+  closeTag();
+  output() << '<' << tagname;
+  for (const SVGAttribute &attr : attrs) {
+    // The namespace declaration is required for standalone documents
+    if (attr.getName() != xmlns().getName() && isDefaultValue(attr))
+      continue;
+    writeAttr(attr);
+  }
+  currentTag = tagname;
+  startPending = true;
+}
+
+void SVGMinifyingWriter::closeTag() {
+  if (!currentTag) {
+    finishStartTag();
+    return;
+  }
+  if (startPending)
+    output() << "/>";
+  else
+    output() << "</" << currentTag << '>';
+  startPending = false;
+  currentTag = nullptr;
+}
@@ -0,0 +1,552 @@
+#include "svgutils/svg_optimizer.h"
+#include "svgutils/svg_path_data.h"
+#include "svgutils/utils.h"
+
+#include <cstring>
+#include <set>
+
+using namespace svg;
+using TagType = SVGNode::TagType;
+
+namespace {
+bool isIgnorable(const SVGNode &node) {
+  if (node.kind == SVGNode::Kind::COMMENT)
+    return true;
+  return node.kind == SVGNode::Kind::CONTENT &&
+         strview_trim(node.name).empty();
+}
+
+/// Elements that describe their parent rather than being rendered
+bool isDescriptive(const SVGNode &node) {
+  return node.is(TagType::title) || node.is(TagType::desc) ||
+         node.is(TagType::metadata);
+}
+
+/// Children of these elements are not an independent list of graphics, so
+/// restructuring them would change the meaning of the document
+bool isOpaqueContainer(const SVGNode &node) {
+  return node.kind == SVGNode::Kind::ELEMENT &&
+         (node.is(TagType::switch_) || node.is(TagType::text) ||
+          node.is(TagType::tspan) || node.is(TagType::textPath) ||
+          node.tag == TagType::NONE);
+}
+
+bool hasInheritValue(const SVGNode &node) {
+  for (const SVGNode::Attr &attr : node.attrs)
+    if (strview_trim(attr.second) == "inherit")
+      return true;
+  return false;
+}
+
+/// Add the ids referenced by @p value, i.e. `url(#id)` or a `#id` link.
+void collectReferences(std::string_view value, bool isLink,
+                       std::set<std::string, std::less<>> &ids) {
+  if (isLink) {
+    value = strview_trim(value);
+    if (value.size() > 1 && value.front() == '#')
+      ids.emplace(value.substr(1));
+    return;
+  }
+  for (size_t pos = value.find("url("); pos != std::string_view::npos;
+       pos = value.find("url(", pos)) {
+    pos += 4;
+    size_t end = value.find(')', pos);
+    if (end == std::string_view::npos)
+      return;
+    std::string_view ref = strview_trim(value.substr(pos, end - pos));
+    if (ref.size() > 1 && (ref.front() == '"' || ref.front() == '\''))
+      ref = ref.substr(1, ref.size() - 2);
+    if (ref.size() > 1 && ref.front() == '#')
+      ids.emplace(ref.substr(1));
+  }
+}
+
+void collectReferences(const SVGNode &node,
+                       std::set<std::string, std::less<>> &ids) {
+  if (node.kind == SVGNode::Kind::CONTENT)
+    // Stylesheets may refer to ids as well
+    collectReferences(node.name, false, ids);
+  for (const SVGNode::Attr &attr : node.attrs)
+    collectReferences(attr.second,
+                      attr.first == "href" || attr.first == "xlink:href", ids);
+  for (const auto &child : node.children)
+    collectReferences(*child, ids);
+}
+
+bool isReferenced(const SVGNode &node,
+                  const std::set<std::string, std::less<>> &ids) {
+  if (const std::string *id = node.getAttr("id"))
+    if (ids.count(*id))
+      return true;
+  for (const auto &child : node.children)
+    if (isReferenced(*child, ids))
+      return true;
+  return false;
+}
+
+struct Box {
+  double x0 = 0., y0 = 0., x1 = 0., y1 = 0.;
+
+  void add(double x, double y) {
+    x0 = std::min(x0, x);
+    y0 = std::min(y0, y);
+    x1 = std::max(x1, x);
+    y1 = std::max(y1, y);
+  }
+  void add(const Box &other) {
+    add(other.x0, other.y0);
+    add(other.x1, other.y1);
+  }
+  /// True if the boxes, each grown by @p margin, overlap or touch
+  bool intersects(const Box &other, double margin) const {
+    return x0 - margin <= other.x1 + margin &&
+           other.x0 - margin <= x1 + margin &&
+           y0 - margin <= other.y1 + margin && other.y0 - margin <= y1 + margin;
+  }
+};
+
+/// Bounds of all end and control points of the path data @p d, which
+/// contain the painted area (without stroke). Fails for malformed data.
+std::optional<Box> getBounds(std::string_view d) {
+  PathData path = PathData::parse(d);
+  if (!path.getError().empty())
+    return std::nullopt;
+  std::optional<PathData::Bounds> bounds = path.getBounds();
+  if (!bounds)
+    return std::nullopt;
+  return Box{bounds->x0, bounds->y0, bounds->x1, bounds->y1};
+}
+
+/// Reads the start of path data.
+class PathScanner {
+public:
+  explicit PathScanner(std::string_view d) : d(d) {}
+
+  /// The path data with a leading relative moveto turned into an absolute
+  /// one, so it can be appended to another path.
+  static std::string makeStartAbsolute(std::string_view d);
+
+private:
+  void skipSeparators() {
+    while (pos < d.size() && (std::isspace(d[pos]) || d[pos] == ','))
+      ++pos;
+  }
+  std::optional<std::string_view> readNumber() {
+    skipSeparators();
+    size_t len = strview_scan_number(d.substr(pos));
+    if (!len)
+      return std::nullopt;
+    std::string_view number = d.substr(pos, len);
+    pos += len;
+    return number;
+  }
+
+  std::string_view d;
+  size_t pos = 0;
+};
+
+std::string PathScanner::makeStartAbsolute(std::string_view d) {
+  PathScanner scanner(d);
+  scanner.skipSeparators();
+  if (scanner.pos == d.size() || d[scanner.pos] != 'm')
+    return std::string(d);
+  ++scanner.pos;
+  auto x = scanner.readNumber();
+  auto y = scanner.readNumber();
+  if (!x || !y)
+    return std::string(d);
+  std::string res = "M";
+  res.append(*x).append(" ").append(*y);
+  // The first pair of a relative moveto is absolute, but the implicit
+  // linetos following it stay relative
+  scanner.skipSeparators();
+  std::string_view rest = d.substr(scanner.pos);
+  if (rest.size() && !std::isalpha(rest.front()))
+    res.append("l");
+  res.append(rest);
+  return res;
+}
+
+/// Stroke width in effect for @p node, or nullopt if it isn't a plain
+/// number.
+std::optional<double> getStrokeWidth(const SVGNode &node) {
+  for (const SVGNode *cur = &node; cur; cur = cur->parent)
+    if (const std::string *width = cur->getAttr("stroke-width")) {
+      std::string_view str = strview_trim(*width);
+      if (strview_scan_number(str) != str.size())
+        return std::nullopt;
+      return strview_to_double(str);
+    }
+  return 1.;
+}
+
+bool hasMarkers(const SVGNode &node) {
+  for (const SVGNode *cur = &node; cur; cur = cur->parent)
+    for (const char *marker :
+         {"marker", "marker-start", "marker-mid", "marker-end"})
+      if (const std::string *value = cur->getAttr(marker))
+        if (strview_trim(*value) != "none")
+          return true;
+  return false;
+}
+
+bool isMergeablePath(const SVGNode &node) {
+  // Filters spread paint beyond the bounds of the geometry
+  return node.is(TagType::path) && node.children.empty() &&
+         !node.getAttr("id") && !node.getAttr("style") &&
+         !node.getAttr("filter") && node.getAttr("d");
+}
+
+/// All attributes except the path data, in a canonical order
+std::vector<SVGNode::Attr> getPathStyle(const SVGNode &node) {
+  std::vector<SVGNode::Attr> style;
+  for (const SVGNode::Attr &attr : node.attrs)
+    if (attr.first != "d")
+      style.push_back(attr);
+  std::sort(style.begin(), style.end());
+  return style;
+}
+
+/// A path other paths are merged into
+struct MergeTarget {
+  SVGNode *path = nullptr;
+  std::vector<SVGNode::Attr> style;
+  /// Bounds of the paths merged so far and their union
+  std::vector<Box> boxes;
+  Box bounds;
+};
+} // namespace
+
+SVGOptimizer::Statistics &
+SVGOptimizer::Statistics::operator+=(const Statistics &other) {
+  elementsBefore += other.elementsBefore;
+  elementsAfter += other.elementsAfter;
+  defsRemoved += other.defsRemoved;
+  groupsCollapsed += other.groupsCollapsed;
+  attributesFolded += other.attributesFolded;
+  pathsMerged += other.pathsMerged;
+  return *this;
+}
+
+bool SVGOptimizer::isInheritedAttribute(std::string_view name) {
+  static constexpr const char *Inherited[] = {
+      "clip-rule",
+      "color",
+      "color-interpolation",
+      "color-interpolation-filters",
+      "color-rendering",
+      "cursor",
+      "direction",
+      "fill",
+      "fill-opacity",
+      "fill-rule",
+      "font",
+      "font-family",
+      "font-size",
+      "font-size-adjust",
+      "font-stretch",
+      "font-style",
+      "font-variant",
+      "font-weight",
+      "image-rendering",
+      "letter-spacing",
+      "marker",
+      "marker-end",
+      "marker-mid",
+      "marker-start",
+      "paint-order",
+      "pointer-events",
+      "shape-rendering",
+      "stroke",
+      "stroke-dasharray",
+      "stroke-dashoffset",
+      "stroke-linecap",
+      "stroke-linejoin",
+      "stroke-miterlimit",
+      "stroke-opacity",
+      "stroke-width",
+      "text-anchor",
+      "text-rendering",
+      "visibility",
+      "word-spacing",
+      "writing-mode",
+  };
+  for (const char *inherited : Inherited)
+    if (name == inherited)
+      return true;
+  return false;
+}
+
+SVGOptimizer::Statistics SVGOptimizer::optimize(SVGDocument &document) const {
+  Statistics stats;
+  stats.elementsBefore = document.countElements();
+  SVGNode &root = document.getRoot();
+  if (options.removeUnusedDefs)
+    removeUnusedDefs(root, stats);
+
+  SVGNode *svgRoot = nullptr;
+  for (const auto &child : root.children)
+    if (child->isElement()) {
+      svgRoot = child.get();
+      break;
+    }
+  if (svgRoot && !isOpaqueContainer(*svgRoot)) {
+    // Passes only look at a node and its children, so the subtrees of the
+    // root element can be processed independently
+    std::vector<SVGNode *> subtrees;
+    for (const auto &child : svgRoot->children)
+      if (child->isElement())
+        subtrees.push_back(child.get());
+    std::vector<Statistics> subtreeStats(subtrees.size());
+    parallelFor(subtrees.size(), options.numThreads, [&](size_t i) {
+      optimizeSubtree(*subtrees[i], subtreeStats[i]);
+    });
+    for (const Statistics &other : subtreeStats)
+      stats += other;
+    optimizeChildren(*svgRoot, stats);
+  }
+  stats.elementsAfter = document.countElements();
+  return stats;
+}
+
+void SVGOptimizer::removeUnusedDefs(SVGNode &root, Statistics &stats) const {
+  std::vector<SVGNode *> defs;
+  std::vector<SVGNode *> worklist{&root};
+  while (worklist.size()) {
+    SVGNode *node = worklist.back();
+    worklist.pop_back();
+    for (const auto &child : node->children) {
+      if (child->is(TagType::defs))
+        defs.push_back(child.get());
+      worklist.push_back(child.get());
+    }
+  }
+
+  // Removing a definition may leave others unreferenced (e.g. a gradient
+  // that was only referenced by another gradient), so repeat until nothing
+  // changes
+  for (bool changed = true; changed;) {
+    changed = false;
+    std::set<std::string, std::less<>> ids;
+    collectReferences(root, ids);
+    for (SVGNode *def : defs) {
+      auto &children = def->children;
+      size_t before = children.size();
+      children.erase(
+          std::remove_if(children.begin(), children.end(),
+                         [&](const std::unique_ptr<SVGNode> &child) {
+                           // Stylesheets and scripts apply without references
+                           return child->isElement() &&
+                                  !child->is(TagType::style) &&
+                                  !child->is(TagType::script) &&
+                                  !isReferenced(*child, ids);
+                         }),
+          children.end());
+      stats.defsRemoved += before - children.size();
+      changed |= before != children.size();
+    }
+  }
+
+  for (SVGNode *def : defs) {
+    bool empty = std::all_of(def->children.begin(), def->children.end(),
+                             [](const std::unique_ptr<SVGNode> &child) {
+                               return isIgnorable(*child);
+                             });
+    if (!empty || def->getAttr("id"))
+      continue;
+    auto &siblings = def->parent->children;
+    siblings.erase(std::find_if(siblings.begin(), siblings.end(),
+                                [def](const std::unique_ptr<SVGNode> &node) {
+                                  return node.get() == def;
+                                }));
+    ++stats.defsRemoved;
+  }
+}
+
+void SVGOptimizer::optimizeSubtree(SVGNode &node, Statistics &stats) const {
+  if (isOpaqueContainer(node))
+    return;
+  for (const auto &child : node.children)
+    optimizeSubtree(*child, stats);
+  optimizeChildren(node, stats);
+}
+
+void SVGOptimizer::optimizeChildren(SVGNode &node, Statistics &stats) const {
+  if (!node.isElement() || node.children.empty())
+    return;
+  if (options.collapseGroups)
+    collapseGroups(node, stats);
+  if (options.mergePaths)
+    mergePaths(node, stats);
+  if (options.foldAttributes && node.is(TagType::g))
+    foldAttributes(node, stats);
+}
+
+void SVGOptimizer::collapseGroups(SVGNode &node, Statistics &stats) const {
+  std::vector<std::unique_ptr<SVGNode>> children;
+  children.reserve(node.children.size());
+  auto splice = [&](SVGNode &group) {
+    for (auto &grandchild : group.children) {
+      grandchild->parent = &node;
+      children.push_back(std::move(grandchild));
+    }
+    ++stats.groupsCollapsed;
+  };
+
+  for (auto &child : node.children) {
+    if (!child->is(TagType::g) || child->getAttr("id") ||
+        child->getAttr("class") || child->getAttr("style")) {
+      children.push_back(std::move(child));
+      continue;
+    }
+    SVGNode &group = *child;
+    // A title or description belongs to the group
+    if (std::any_of(group.children.begin(), group.children.end(),
+                    [](const std::unique_ptr<SVGNode> &grandchild) {
+                      return isDescriptive(*grandchild);
+                    })) {
+      children.push_back(std::move(child));
+      continue;
+    }
+    if (group.attrs.empty()) {
+      splice(group);
+      continue;
+    }
+
+    // Push the attributes down into a single child
+    SVGNode *target = nullptr;
+    bool canPushDown = !hasInheritValue(group);
+    for (const auto &grandchild : group.children) {
+      if (isIgnorable(*grandchild))
+        continue;
+      // Nested svg elements don't support transforms in SVG 1.1
+      if (target || !grandchild->isElement() || isDescriptive(*grandchild) ||
+          grandchild->is(TagType::svg) || grandchild->getAttr("id") ||
+          hasInheritValue(*grandchild))
+        canPushDown = false;
+      target = grandchild.get();
+    }
+    if (!target) {
+      // Nothing to render
+      ++stats.groupsCollapsed;
+      continue;
+    }
+    for (const SVGNode::Attr &attr : group.attrs)
+      if (!isInheritedAttribute(attr.first) && attr.first != "transform" &&
+          (attr.first != "opacity" || target->getAttr("opacity")))
+        canPushDown = false;
+    if (!canPushDown) {
+      children.push_back(std::move(child));
+      continue;
+    }
+    for (SVGNode::Attr &attr : group.attrs) {
+      const std::string *own = target->getAttr(attr.first);
+      if (attr.first == "transform" && own)
+        // The group transform applies first
+        target->setAttr(attr.first, attr.second + " " + *own);
+      else if (!own)
+        target->setAttr(attr.first, std::move(attr.second));
+      // Otherwise the child overrides the inherited value
+    }
+    splice(group);
+  }
+  node.children = std::move(children);
+}
+
+void SVGOptimizer::foldAttributes(SVGNode &node, Statistics &stats) const {
+  if (node.getAttr("class") || node.getAttr("style"))
+    return;
+  std::vector<SVGNode *> elements;
+  for (const auto &child : node.children) {
+    if (isIgnorable(*child) || isDescriptive(*child))
+      continue;
+    // <use> elements don't inherit from the original parent of an element,
+    // so referenced elements have to keep their attributes
+    if (!child->isElement() || child->getAttr("id"))
+      return;
+    elements.push_back(child.get());
+  }
+  if (elements.size() < 2)
+    return;
+
+  std::vector<std::string> folded;
+  for (const SVGNode::Attr &attr : elements.front()->attrs) {
+    // Relative values of the children (e.g. font-size="2em") resolve against
+    // the value the group already has, so it can't be replaced
+    if (!isInheritedAttribute(attr.first) ||
+        strview_trim(attr.second) == "inherit" || node.getAttr(attr.first))
+      continue;
+    bool shared = std::all_of(
+        elements.begin() + 1, elements.end(), [&](const SVGNode *element) {
+          const std::string *value = element->getAttr(attr.first);
+          return value && *value == attr.second;
+        });
+    if (!shared)
+      continue;
+    folded.push_back(attr.first);
+    ++stats.attributesFolded;
+  }
+  for (const std::string &name : folded) {
+    node.setAttr(name, *elements.front()->getAttr(name));
+    for (SVGNode *element : elements)
+      element->removeAttr(name);
+  }
+}
+
+void SVGOptimizer::mergePaths(SVGNode &node, Statistics &stats) const {
+  if (hasMarkers(node))
+    // Markers are drawn at every vertex, merging paths changes their number
+    return;
+  MergeTarget target;
+  auto isMerged = [](const std::unique_ptr<SVGNode> &child) {
+    return child->kind == SVGNode::Kind::ELEMENT && !child->parent;
+  };
+
+  for (auto &child : node.children) {
+    if (child->kind == SVGNode::Kind::CONTENT && isIgnorable(*child))
+      continue;
+    std::optional<Box> box;
+    std::optional<double> width;
+    if (isMergeablePath(*child) && !hasMarkers(*child) &&
+        (width = getStrokeWidth(*child)))
+      box = getBounds(*child->getAttr("d"));
+    if (!box) {
+      target.path = nullptr;
+      continue;
+    }
+
+    // Overlapping paths have to stay separate, otherwise overlaps are
+    // painted once instead of twice and the painting order of fill and
+    // stroke changes. The stroke may reach beyond the bounds of the
+    // geometry, e.g. with miter joins, so keep some distance.
+    double margin = 2. * std::max(*width, 1.);
+    std::vector<SVGNode::Attr> style = getPathStyle(*child);
+    bool canMerge = target.path && style == target.style;
+    if (canMerge && target.bounds.intersects(*box, margin))
+      for (const Box &other : target.boxes)
+        if (other.intersects(*box, margin)) {
+          canMerge = false;
+          break;
+        }
+    if (!canMerge) {
+      target.path = child.get();
+      target.style = std::move(style);
+      target.boxes.assign(1, *box);
+      target.bounds = *box;
+      continue;
+    }
+
+    std::string d = *target.path->getAttr("d");
+    d.append(" ").append(
+        PathScanner::makeStartAbsolute(*child->getAttr("d")));
+    target.path->setAttr("d", std::move(d));
+    target.boxes.push_back(*box);
+    target.bounds.add(*box);
+    // Mark for removal
+    child->parent = nullptr;
+    ++stats.pathsMerged;
+  }
+  node.children.erase(
+      std::remove_if(node.children.begin(), node.children.end(), isMerged),
+      node.children.end());
+}
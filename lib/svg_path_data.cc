@@ -0,0 +1,728 @@
+#include "svgutils/svg_path_data.h"
+#include "svgutils/utils.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+using namespace svg;
+
+void PathData::moveTo(double x, double y) {
+  verbs.push_back(Verb::MOVE);
+  coords.insert(coords.end(), {x, y});
+}
+void PathData::lineTo(double x, double y) {
+  verbs.push_back(Verb::LINE);
+  coords.insert(coords.end(), {x, y});
+}
+void PathData::cubicTo(double x1, double y1, double x2, double y2, double x,
+                       double y) {
+  verbs.push_back(Verb::CUBIC);
+  coords.insert(coords.end(), {x1, y1, x2, y2, x, y});
+}
+void PathData::close() { verbs.push_back(Verb::CLOSE); }
+
+namespace {
+/// Byte classes of 32 bytes of path data, one bit per byte
+struct ByteClasses {
+  /// Whitespace and commas
+  uint32_t separator;
+  /// Digits, signs and dots, which may start a number
+  uint32_t numberStart;
+};
+
+#ifdef __SSE2__
+/// Bits set for the bytes of @p v in [@p lo, @p hi]
+inline uint32_t inRange(__m128i v, char lo, char hi) {
+  __m128i offset = _mm_sub_epi8(v, _mm_set1_epi8(lo));
+  __m128i limit = _mm_set1_epi8(static_cast<char>(hi - lo));
+  return _mm_movemask_epi8(
+      _mm_cmpeq_epi8(_mm_max_epu8(offset, limit), limit));
+}
+inline uint32_t equal(__m128i v, char c) {
+  return _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8(c)));
+}
+#endif
+
+/// Classify the 32 bytes at @p p
+ByteClasses classify(const char *p) {
+  ByteClasses res{0, 0};
+#ifdef __SSE2__
+  for (int half = 0; half < 2; ++half) {
+    __m128i v =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 16 * half));
+    uint32_t separator = equal(v, ' ') | equal(v, ',') | inRange(v, 9, 13);
+    uint32_t numberStart = inRange(v, '0', '9') | equal(v, '.') |
+                           equal(v, '-') | equal(v, '+');
+    res.separator |= separator << (16 * half);
+    res.numberStart |= numberStart << (16 * half);
+  }
+#else
+  for (unsigned i = 0; i < 32; ++i) {
+    unsigned char c = p[i];
+    bool separator = c == ' ' || c == ',' || (c >= 9 && c <= 13);
+    bool numberStart = (c >= '0' && c <= '9') || c == '.' || c == '-' ||
+                       c == '+';
+    res.separator |= static_cast<uint32_t>(separator) << i;
+    res.numberStart |= static_cast<uint32_t>(numberStart) << i;
+  }
+#endif
+  return res;
+}
+
+/// Converts the decimal number @p str if that is exact with a single
+/// rounding: A mantissa of at most 53 bits scaled by an exactly
+/// representable power of ten. Everything else is left to strtod.
+bool convertFast(std::string_view str, double &value) {
+  static const double Pow10[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,
+                                 1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                 1e12, 1e13, 1e14, 1e15, 1e16, 1e17,
+                                 1e18, 1e19, 1e20, 1e21, 1e22};
+  const char *p = str.data(), *end = p + str.size();
+  bool negative = false;
+  if (p != end && (*p == '+' || *p == '-'))
+    negative = *p++ == '-';
+  uint64_t mantissa = 0;
+  int significant = 0, exponent = 0;
+  auto digit = [&](unsigned d) {
+    // Leading zeros don't count
+    if (mantissa || d) {
+      if (++significant > 19)
+        return false;
+      mantissa = mantissa * 10 + d;
+    }
+    return true;
+  };
+  for (; p != end && *p >= '0' && *p <= '9'; ++p)
+    if (!digit(*p - '0'))
+      return false;
+  if (p != end && *p == '.')
+    for (++p; p != end && *p >= '0' && *p <= '9'; ++p, --exponent)
+      if (!digit(*p - '0'))
+        return false;
+  if (p != end && (*p == 'e' || *p == 'E')) {
+    ++p;
+    bool negativeExp = false;
+    if (p != end && (*p == '+' || *p == '-'))
+      negativeExp = *p++ == '-';
+    int exp = 0;
+    for (; p != end && *p >= '0' && *p <= '9'; ++p)
+      if ((exp = exp * 10 + (*p - '0')) > 1000)
+        return false;
+    exponent += negativeExp ? -exp : exp;
+  }
+  if (p != end || mantissa > (uint64_t(1) << 53) || exponent < -22 ||
+      exponent > 22)
+    return false;
+  double res = static_cast<double>(mantissa);
+  res = exponent < 0 ? res / Pow10[-exponent] : res * Pow10[exponent];
+  value = negative ? -res : res;
+  return true;
+}
+
+double convert(std::string_view str) {
+  double value;
+  if (convertFast(str, value))
+    return value;
+  char buf[64];
+  size_t len = std::min(str.size(), sizeof(buf) - 1);
+  std::memcpy(buf, str.data(), len);
+  buf[len] = '\0';
+  return std::strtod(buf, nullptr);
+}
+} // namespace
+
+namespace svg {
+/// Grammar: https://www.w3.org/TR/SVG11/paths.html#PathDataBNF
+///
+/// The input is split into commands and numbers first, finding the start of
+/// the next token among 32 bytes at once. The numbers are then converted in
+/// one go, and the grammar is applied to the tokens.
+class PathDataParser {
+public:
+  PathDataParser(std::string_view input, PathData &path)
+      : input(input), path(path) {}
+
+  void run();
+
+private:
+  struct Point {
+    double x = 0.;
+    double y = 0.;
+  };
+  /// A command letter or a number. Any other character ends the tokens and
+  /// is kept as an invalid command.
+  struct Token {
+    uint32_t offset;
+    uint32_t length;
+    /// 0 for numbers
+    char command;
+    double value;
+  };
+
+  void tokenize();
+  void convertNumbers() {
+    for (Token &token : tokens)
+      if (!token.command)
+        token.value = convert(input.substr(token.offset, token.length));
+  }
+
+  bool atArgument() const {
+    return next < tokens.size() && !tokens[next].command;
+  }
+  bool readNumber(double &value) {
+    if (!atArgument())
+      return false;
+    value = tokens[next++].value;
+    return true;
+  }
+  bool readFlag(bool &value);
+  bool readPoint(Point &pt, bool rel) {
+    if (!readNumber(pt.x) || !readNumber(pt.y))
+      return false;
+    if (rel) {
+      pt.x += cur.x;
+      pt.y += cur.y;
+    }
+    return true;
+  }
+  bool fail(const char *msg) {
+    path.error = msg;
+    return false;
+  }
+  /// Parse and add one set of arguments of @p cmd
+  bool segment(char cmd);
+  void cubic(Point c1, Point c2, Point end);
+  void arc(double rx, double ry, double angle, bool largeArc, bool sweep,
+           Point end);
+
+  std::string_view input;
+  std::vector<Token> tokens;
+  /// Index of the next token
+  size_t next = 0;
+  PathData &path;
+  /// Current point and start of the current subpath
+  Point cur, start;
+  /// Second control point of the last C/S, or control point of the last Q/T,
+  /// for reflection by S or T. Equals `cur` after other commands.
+  Point lastCubic, lastQuad;
+};
+} // namespace svg
+
+void PathDataParser::tokenize() {
+  // Most tokens are numbers of several digits and a separator
+  tokens.reserve(input.size() / 4);
+  const size_t size = input.size();
+  char padded[32];
+  size_t pos = 0;
+  while (pos < size) {
+    ByteClasses classes;
+    size_t blockEnd = pos + 32;
+    if (blockEnd <= size)
+      classes = classify(input.data() + pos);
+    else {
+      // Pad the end with separators
+      std::memset(padded, ' ', sizeof(padded));
+      std::memcpy(padded, input.data() + pos, size - pos);
+      classes = classify(padded);
+      blockEnd = size;
+    }
+    size_t base = pos;
+    while (pos < blockEnd) {
+      uint32_t tokenStarts = ~classes.separator >> (pos - base);
+      if (!tokenStarts) {
+        pos = blockEnd;
+        break;
+      }
+      pos += __builtin_ctz(tokenStarts);
+      if (pos >= blockEnd)
+        break;
+      auto offset = static_cast<uint32_t>(pos);
+      if (classes.numberStart >> (pos - base) & 1) {
+        // A token may reach beyond the block
+        if (size_t len = strview_scan_number(input.substr(pos))) {
+          tokens.push_back({offset, static_cast<uint32_t>(len), 0, 0.});
+          pos += len;
+          continue;
+        }
+      } else if (std::isalpha(static_cast<unsigned char>(input[pos]))) {
+        tokens.push_back({offset, 1, input[pos], 0.});
+        ++pos;
+        continue;
+      }
+      // Parsing fails here
+      tokens.push_back({offset, 1, input[pos] ? input[pos] : '?', 0.});
+      return;
+    }
+  }
+}
+
+bool PathDataParser::readFlag(bool &value) {
+  if (!atArgument())
+    return false;
+  Token &token = tokens[next];
+  char c = input[token.offset];
+  if (c != '0' && c != '1')
+    return false;
+  value = c == '1';
+  if (token.length == 1) {
+    ++next;
+    return true;
+  }
+  // Flags don't need separators, e.g. in `a1 1 0 0110 10`, so the rest of
+  // the number is the next token
+  ++token.offset;
+  --token.length;
+  std::string_view rest = input.substr(token.offset, token.length);
+  if (strview_scan_number(rest) == rest.size())
+    token.value = convert(rest);
+  else
+    token.command = rest.front();
+  return true;
+}
+
+void PathDataParser::run() {
+  tokenize();
+  convertNumbers();
+  char cmd = 0;
+  while (next < tokens.size()) {
+    if (char command = tokens[next].command) {
+      if (!std::isalpha(static_cast<unsigned char>(command))) {
+        fail("Unexpected character in path data");
+        return;
+      }
+      cmd = command;
+      ++next;
+      // Every command but Z requires at least one set of arguments
+      if (std::toupper(cmd) != 'Z' && !atArgument()) {
+        fail("Missing arguments of path command");
+        return;
+      }
+    } else if (!cmd) {
+      fail("Path data must start with a command");
+      return;
+    }
+    if (!segment(cmd))
+      return;
+    // Coordinates following a moveto are implicit linetos
+    if (cmd == 'M')
+      cmd = 'L';
+    else if (cmd == 'm')
+      cmd = 'l';
+    // Arguments after Z aren't allowed
+    else if (cmd == 'Z' || cmd == 'z')
+      cmd = 0;
+  }
+}
+
+bool PathDataParser::segment(char cmd) {
+  bool rel = std::islower(cmd);
+  char upper = std::toupper(cmd);
+  Point pt, c1, c2;
+  switch (upper) {
+  case 'M':
+    if (!readPoint(pt, rel))
+      return fail("Invalid arguments given to M/m command");
+    path.moveTo(pt.x, pt.y);
+    start = pt;
+    break;
+  case 'Z':
+    path.close();
+    pt = start;
+    break;
+  case 'L':
+    if (!readPoint(pt, rel))
+      return fail("Invalid arguments given to L/l command");
+    path.lineTo(pt.x, pt.y);
+    break;
+  case 'H':
+    pt = cur;
+    if (!readNumber(pt.x))
+      return fail("Invalid argument given to H/h command");
+    pt.x += rel ? cur.x : 0.;
+    path.lineTo(pt.x, pt.y);
+    break;
+  case 'V':
+    pt = cur;
+    if (!readNumber(pt.y))
+      return fail("Invalid argument given to V/v command");
+    pt.y += rel ? cur.y : 0.;
+    path.lineTo(pt.x, pt.y);
+    break;
+  case 'C':
+    if (!readPoint(c1, rel) || !readPoint(c2, rel) || !readPoint(pt, rel))
+      return fail("Invalid arguments given to C/c command");
+    cubic(c1, c2, pt);
+    lastCubic = c2;
+    cur = lastQuad = pt;
+    return true;
+  case 'S':
+    if (!readPoint(c2, rel) || !readPoint(pt, rel))
+      return fail("Invalid arguments given to S/s command");
+    c1 = {2 * cur.x - lastCubic.x, 2 * cur.y - lastCubic.y};
+    cubic(c1, c2, pt);
+    lastCubic = c2;
+    cur = lastQuad = pt;
+    return true;
+  case 'Q':
+  case 'T': {
+    Point q;
+    if (upper == 'Q') {
+      if (!readPoint(q, rel) || !readPoint(pt, rel))
+        return fail("Invalid arguments given to Q/q command");
+    } else {
+      if (!readPoint(pt, rel))
+        return fail("Invalid arguments given to T/t command");
+      q = {2 * cur.x - lastQuad.x, 2 * cur.y - lastQuad.y};
+    }
+    // https://stackoverflow.com/a/3162732/1468532
+    c1 = {cur.x + 2. / 3. * (q.x - cur.x), cur.y + 2. / 3. * (q.y - cur.y)};
+    c2 = {pt.x + 2. / 3. * (q.x - pt.x), pt.y + 2. / 3. * (q.y - pt.y)};
+    cubic(c1, c2, pt);
+    lastQuad = q;
+    cur = lastCubic = pt;
+    return true;
+  }
+  case 'A': {
+    double rx, ry, angle;
+    bool largeArc, sweep;
+    if (!readNumber(rx) || !readNumber(ry) || !readNumber(angle) ||
+        !readFlag(largeArc) || !readFlag(sweep) || !readPoint(pt, rel))
+      return fail("Invalid arguments given to A/a command");
+    arc(rx, ry, angle, largeArc, sweep, pt);
+    break;
+  }
+  default:
+    return fail("Unknown path command");
+  }
+  cur = lastCubic = lastQuad = pt;
+  return true;
+}
+
+void PathDataParser::cubic(Point c1, Point c2, Point end) {
+  path.cubicTo(c1.x, c1.y, c2.x, c2.y, end.x, end.y);
+}
+
+// Conversion to center parameterization as in
+// https://www.w3.org/TR/SVG11/implnote.html#ArcConversionEndpointToCenter
+void PathDataParser::arc(double rx, double ry, double angle, bool largeArc,
+                         bool sweep, Point end) {
+  if (end.x == cur.x && end.y == cur.y)
+    return;
+  rx = std::abs(rx);
+  ry = std::abs(ry);
+  if (rx == 0. || ry == 0.) {
+    path.lineTo(end.x, end.y);
+    return;
+  }
+  const double Pi = std::acos(-1.);
+  double phi = angle / 180. * Pi;
+  double cosPhi = std::cos(phi), sinPhi = std::sin(phi);
+  double dx = (cur.x - end.x) / 2., dy = (cur.y - end.y) / 2.;
+  double x1 = cosPhi * dx + sinPhi * dy;
+  double y1 = -sinPhi * dx + cosPhi * dy;
+  // Radii too small to connect the end points are scaled up
+  double lambda = x1 * x1 / (rx * rx) + y1 * y1 / (ry * ry);
+  if (lambda > 1.) {
+    rx *= std::sqrt(lambda);
+    ry *= std::sqrt(lambda);
+  }
+  double num = rx * rx * ry * ry - rx * rx * y1 * y1 - ry * ry * x1 * x1;
+  double den = rx * rx * y1 * y1 + ry * ry * x1 * x1;
+  double coef = std::sqrt(std::max(0., num / den));
+  if (largeArc == sweep)
+    coef = -coef;
+  double cx1 = coef * rx * y1 / ry, cy1 = -coef * ry * x1 / rx;
+  double cx = cosPhi * cx1 - sinPhi * cy1 + (cur.x + end.x) / 2.;
+  double cy = sinPhi * cx1 + cosPhi * cy1 + (cur.y + end.y) / 2.;
+
+  double theta = std::atan2((y1 - cy1) / ry, (x1 - cx1) / rx);
+  double delta = std::atan2((-y1 - cy1) / ry, (-x1 - cx1) / rx) - theta;
+  if (!sweep && delta > 0.)
+    delta -= 2. * Pi;
+  else if (sweep && delta < 0.)
+    delta += 2. * Pi;
+
+  // One curve per quarter circle at most keeps the error below 0.03% of
+  // the radius
+  int n = static_cast<int>(std::ceil(std::abs(delta) / (Pi / 2.) - 1e-9));
+  double step = delta / n;
+  double k = 4. / 3. * std::tan(step / 4.);
+  auto map = [&](double u, double v) {
+    return Point{cx + rx * u * cosPhi - ry * v * sinPhi,
+                 cy + rx * u * sinPhi + ry * v * cosPhi};
+  };
+  for (int i = 0; i < n; ++i) {
+    double a = theta + i * step, b = a + step;
+    double cosA = std::cos(a), sinA = std::sin(a);
+    double cosB = std::cos(b), sinB = std::sin(b);
+    Point c1 = map(cosA - k * sinA, sinA + k * cosA);
+    Point c2 = map(cosB + k * sinB, sinB - k * cosB);
+    // Hit the end point exactly
+    Point to = i + 1 == n ? end : map(cosB, sinB);
+    cubic(c1, c2, to);
+  }
+}
+
+PathData PathData::parse(std::string_view d) {
+  PathData path;
+  PathDataParser(d, path).run();
+  return path;
+}
+
+PathData PathData::fromPoints(std::string_view points, bool close) {
+  std::string d = "M";
+  d.append(points);
+  PathData path = parse(d);
+  // An odd number of coordinates is an error, but everything before it is
+  // drawn
+  if (close && path.verbs.size())
+    path.close();
+  return path;
+}
+
+void PathData::transform(const Matrix &matrix) {
+  double *c = coords.data();
+  size_t numPoints = coords.size() / 2;
+  const double a = matrix.a, b = matrix.b, cx = matrix.c, d = matrix.d,
+               e = matrix.e, f = matrix.f;
+  // Scaling and translation, by far the most common, don't mix x and y
+  if (b == 0. && cx == 0.) {
+    for (size_t i = 0; i < numPoints; ++i) {
+      c[2 * i] = c[2 * i] * a + e;
+      c[2 * i + 1] = c[2 * i + 1] * d + f;
+    }
+    return;
+  }
+  for (size_t i = 0; i < numPoints; ++i) {
+    double x = c[2 * i], y = c[2 * i + 1];
+    c[2 * i] = a * x + cx * y + e;
+    c[2 * i + 1] = b * x + d * y + f;
+  }
+}
+
+std::optional<PathData::Bounds> PathData::getBounds() const {
+  if (coords.empty())
+    return std::nullopt;
+  const double *c = coords.data();
+  size_t numPoints = coords.size() / 2;
+  // Minimum and maximum of x and y side by side, like the coordinates
+  double lo[2] = {c[0], c[1]}, hi[2] = {c[0], c[1]};
+#ifdef __SSE2__
+  // Two points per iteration into separate registers, so consecutive
+  // iterations don't wait for each other. minpd and maxpd return their
+  // second operand if either is NaN, so NaN coordinates are skipped like
+  // in the scalar loop.
+  __m128d lo0 = _mm_loadu_pd(c), hi0 = lo0, lo1 = lo0, hi1 = lo0;
+  size_t i = 1;
+  for (; i + 1 < numPoints; i += 2) {
+    __m128d p0 = _mm_loadu_pd(c + 2 * i), p1 = _mm_loadu_pd(c + 2 * i + 2);
+    lo0 = _mm_min_pd(p0, lo0);
+    hi0 = _mm_max_pd(p0, hi0);
+    lo1 = _mm_min_pd(p1, lo1);
+    hi1 = _mm_max_pd(p1, hi1);
+  }
+  if (i < numPoints) {
+    __m128d p = _mm_loadu_pd(c + 2 * i);
+    lo0 = _mm_min_pd(p, lo0);
+    hi0 = _mm_max_pd(p, hi0);
+  }
+  _mm_storeu_pd(lo, _mm_min_pd(lo1, lo0));
+  _mm_storeu_pd(hi, _mm_max_pd(hi1, hi0));
+#else
+  for (size_t i = 1; i < numPoints; ++i) {
+    lo[0] = c[2 * i] < lo[0] ? c[2 * i] : lo[0];
+    lo[1] = c[2 * i + 1] < lo[1] ? c[2 * i + 1] : lo[1];
+    hi[0] = c[2 * i] > hi[0] ? c[2 * i] : hi[0];
+    hi[1] = c[2 * i + 1] > hi[1] ? c[2 * i + 1] : hi[1];
+  }
+#endif
+  return Bounds{lo[0], lo[1], hi[0], hi[1]};
+}
+
+namespace {
+/// Append @p n lines approximating the cubic curve from @p p0 with the
+/// control and end points @p c to @p verbs and @p coords
+void flattenCubic(const double *p0, const double *c, size_t n,
+                  std::vector<PathData::Verb> &verbs,
+                  std::vector<double> &coords) {
+  // Power basis p0 + t a + t^2 b + t^3 d, so every point is independent of
+  // the others. The coefficients are locals, which the stores to out can't
+  // alias, and the index is an int, which converts to double in vector
+  // registers. Both are needed for the loop to vectorize.
+  const double x0 = p0[0], y0 = p0[1];
+  const double ax = 3. * (c[0] - x0), ay = 3. * (c[1] - y0);
+  const double bx = 3. * (x0 - 2. * c[0] + c[2]),
+               by = 3. * (y0 - 2. * c[1] + c[3]);
+  const double dx = c[4] - x0 + 3. * (c[0] - c[2]),
+               dy = c[5] - y0 + 3. * (c[1] - c[3]);
+  verbs.insert(verbs.end(), n, PathData::Verb::LINE);
+  size_t start = coords.size();
+  coords.resize(start + 2 * n);
+  double *out = coords.data() + start;
+  double step = 1. / static_cast<double>(n);
+  int lines = static_cast<int>(n);
+  for (int i = 0; i + 1 < lines; ++i) {
+    double t = static_cast<double>(i + 1) * step;
+    out[2 * i] = x0 + t * (ax + t * (bx + t * dx));
+    out[2 * i + 1] = y0 + t * (ay + t * (by + t * dy));
+  }
+  // End exactly at the end point
+  out[2 * n - 2] = c[4];
+  out[2 * n - 1] = c[5];
+}
+} // namespace
+
+PathData PathData::flatten(double tolerance) const {
+  // Bounds the work for tiny or invalid tolerances
+  const size_t MaxLines = 1024;
+  PathData res;
+  res.verbs.reserve(verbs.size());
+  res.coords.reserve(coords.size());
+  res.error = error;
+  const double *c = coords.data();
+  double cur[2] = {0., 0.}, start[2] = {0., 0.};
+  for (Verb verb : verbs) {
+    switch (verb) {
+    case Verb::MOVE:
+      start[0] = c[0];
+      start[1] = c[1];
+      res.moveTo(c[0], c[1]);
+      break;
+    case Verb::LINE:
+      res.lineTo(c[0], c[1]);
+      break;
+    case Verb::CUBIC: {
+      // n lines deviate at most 3/4 of the largest second difference of
+      // the control points over n^2 from the curve
+      double dd = 0.;
+      for (int k = 0; k < 2; ++k) {
+        double first = cur[k] - 2. * c[k] + c[2 + k];
+        double second = c[k] - 2. * c[2 + k] + c[4 + k];
+        dd += std::max(first * first, second * second);
+      }
+      double lines = std::min(std::ceil(std::sqrt(0.75 * std::sqrt(dd) /
+                                                  tolerance)),
+                              static_cast<double>(MaxLines));
+      size_t n = lines >= 1. ? static_cast<size_t>(lines) : 1;
+      flattenCubic(cur, c, n, res.verbs, res.coords);
+      break;
+    }
+    case Verb::CLOSE:
+      res.close();
+      cur[0] = start[0];
+      cur[1] = start[1];
+      break;
+    }
+    if (verb != Verb::CLOSE) {
+      size_t num = numCoords(verb);
+      cur[0] = c[num - 2];
+      cur[1] = c[num - 1];
+    }
+    c += numCoords(verb);
+  }
+  return res;
+}
+
+namespace {
+/// Squared distance of the point @p p from the line segment from @p a to
+/// @p b
+double segmentDistance2(const double *p, const double *a, const double *b) {
+  double dx = b[0] - a[0], dy = b[1] - a[1];
+  double len2 = dx * dx + dy * dy;
+  double t = 0.;
+  if (len2 > 0.)
+    t = std::clamp(((p[0] - a[0]) * dx + (p[1] - a[1]) * dy) / len2, 0., 1.);
+  double x = a[0] + t * dx - p[0], y = a[1] + t * dy - p[1];
+  return x * x + y * y;
+}
+
+/// Append the polyline @p points (x and y side by side) to @p path,
+/// leaving out all points within sqrt(@p maxDist2) of the simplified line.
+/// Closed polylines end with their first point again.
+void appendSimplified(std::vector<double> &points, bool closed,
+                      double maxDist2, PathData &path) {
+  size_t n = points.size() / 2;
+  if (!n)
+    return;
+  if (closed && n > 1) {
+    points.push_back(points[0]);
+    points.push_back(points[1]);
+    ++n;
+  }
+  std::vector<bool> keep(n, false);
+  keep.front() = keep.back() = true;
+  std::vector<std::pair<size_t, size_t>> ranges;
+  if (n > 2)
+    ranges.emplace_back(0, n - 1);
+  while (ranges.size()) {
+    auto [first, last] = ranges.back();
+    ranges.pop_back();
+    const double *a = &points[2 * first], *b = &points[2 * last];
+    double maxDist = 0.;
+    size_t farthest = first;
+    for (size_t i = first + 1; i < last; ++i) {
+      double dist = segmentDistance2(&points[2 * i], a, b);
+      if (dist > maxDist) {
+        maxDist = dist;
+        farthest = i;
+      }
+    }
+    if (maxDist <= maxDist2)
+      continue;
+    keep[farthest] = true;
+    if (farthest - first > 1)
+      ranges.emplace_back(first, farthest);
+    if (last - farthest > 1)
+      ranges.emplace_back(farthest, last);
+  }
+  path.moveTo(points[0], points[1]);
+  // The point closing the polyline is the first one
+  size_t end = closed && n > 1 ? n - 1 : n;
+  for (size_t i = 1; i < end; ++i)
+    if (keep[i])
+      path.lineTo(points[2 * i], points[2 * i + 1]);
+  if (closed)
+    path.close();
+  points.clear();
+}
+} // namespace
+
+PathData PathData::simplify(double tolerance) const {
+  // Half of the error is spent on flattening and half on removing vertices
+  PathData flat = flatten(tolerance / 2.);
+  double maxDist2 = tolerance * tolerance / 4.;
+  PathData res;
+  res.error = error;
+  std::vector<double> points;
+  const double *c = flat.coords.data();
+  double start[2] = {0., 0.};
+  for (Verb verb : flat.verbs) {
+    // Subpaths following a closed one start where it started
+    if (verb != Verb::MOVE && points.empty())
+      points.insert(points.end(), start, start + 2);
+    switch (verb) {
+    case Verb::MOVE:
+      appendSimplified(points, false, maxDist2, res);
+      start[0] = c[0];
+      start[1] = c[1];
+      points.insert(points.end(), c, c + 2);
+      break;
+    case Verb::LINE:
+      points.insert(points.end(), c, c + 2);
+      break;
+    case Verb::CUBIC:
+      svg_unreachable("Flattened paths have no curves");
+    case Verb::CLOSE:
+      appendSimplified(points, true, maxDist2, res);
+      break;
+    }
+    c += numCoords(verb);
+  }
+  appendSimplified(points, false, maxDist2, res);
+  return res;
+}
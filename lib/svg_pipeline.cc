@@ -0,0 +1,95 @@
+#include "svgutils/svg_pipeline.h"
+
+#include <algorithm>
+
+using namespace svg;
+
+SVGPipelineWriter::~SVGPipelineWriter() { stop(); }
+
+void SVGPipelineWriter::setOptions(const Options &options) {
+  assert(!running && "Cannot change pipeline options while running");
+  this->options = options;
+}
+
+SVGPipelineWriter::Statistics SVGPipelineWriter::getStatistics() const {
+  Statistics stats;
+  stats.events = events;
+  stats.producerStalls = producerStalls;
+  stats.consumerStalls = consumerStalls;
+  stats.maxOccupancy = maxOccupancy;
+  if (events)
+    stats.avgOccupancy = static_cast<double>(occupancySum) / events;
+  return stats;
+}
+
+void SVGPipelineWriter::wait() const {
+  SPSCWait{options.backpressure, options.sleepTime}();
+}
+
+void SVGPipelineWriter::start() {
+  queue = std::make_unique<SPSCQueue<SVGEvent>>(options.queueSize);
+  stopping.store(false, std::memory_order_relaxed);
+  running = true;
+  consumer = std::thread([this]() { work(); });
+}
+
+void SVGPipelineWriter::stop() {
+  if (!running)
+    return;
+  stopping.store(true, std::memory_order_release);
+  consumer.join();
+  running = false;
+}
+
+void SVGPipelineWriter::work() {
+  SVGEvent event;
+  for (;;) {
+    if (!queue->tryPop(event)) {
+      // Everything pushed before `stopping` was set is visible after the
+      // acquire, so an empty queue then means we are done
+      if (stopping.load(std::memory_order_acquire)) {
+        if (!queue->tryPop(event))
+          return;
+      } else {
+        ++consumerStalls;
+        wait();
+        continue;
+      }
+    }
+    // Keep draining the queue after an error so that the producer never
+    // blocks on a full queue
+    if (error)
+      continue;
+    if (auto res = event.replay(writer)) {
+      error = res.to_error();
+      failed.store(true, std::memory_order_release);
+    }
+  }
+}
+
+SVGPipelineWriter::RetTy SVGPipelineWriter::post(SVGEvent &&event) {
+  if (!running)
+    start();
+  if (!queue->tryPush(std::move(event))) {
+    ++producerStalls;
+    do
+      wait();
+    while (!queue->tryPush(std::move(event)));
+  }
+  size_t occupancy = queue->size();
+  ++events;
+  occupancySum += occupancy;
+  maxOccupancy = std::max(maxOccupancy, occupancy);
+  if (failed.load(std::memory_order_acquire))
+    return *error;
+  return {};
+}
+
+SVGPipelineWriter::RetTy SVGPipelineWriter::finish() {
+  post(SVGEvent(SVGEvent::Kind::FINISH));
+  // Wait for the consumer to complete before reporting
+  stop();
+  if (error)
+    return *error;
+  return {};
+}
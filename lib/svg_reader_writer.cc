@@ -38,8 +38,10 @@ MaybeError SVGReaderWriterBase::parse(instream_t &is) {
   if (parents.size())
     return ParseError("Not all tags were closed");
   // Required because closing tags are only written when strictly
-  // necessary to allow for multiple enter()/leave() calls
-  writer.finish();
+  // necessary to allow for multiple enter()/leave() calls. Writers running
+  // asynchronously (e.g. SVGPipelineWriter) report their errors here.
+  if (auto res = writer.finish())
+    return ParseError(res.to_error().what());
   return ParseSuccess;
 }
 
@@ -160,7 +162,7 @@ MaybeError SVGReaderWriterBase::parseTag(instream_t &is) {
     if (tag != TagType::CUSTOM)
       dispatchTag(tag, {});
     else
-      writer.custom_tag(name.c_str(), {});
+      writer.custom_tag(internCustomTagName(name), {});
     enter(tag);
   } else if (Tok == '/') {
     is.get(Tok);
@@ -170,7 +172,7 @@ MaybeError SVGReaderWriterBase::parseTag(instream_t &is) {
     if (tag != TagType::CUSTOM)
       dispatchTag(tag, {});
     else
-      writer.custom_tag(name.c_str(), {});
+      writer.custom_tag(internCustomTagName(name), {});
   } else if (std::isspace(Tok)) {
     std::vector<RawAttr> RawAttrs;
     std::vector<SVGAttribute> Attrs;
@@ -188,7 +190,7 @@ MaybeError SVGReaderWriterBase::parseTag(instream_t &is) {
     if (tag != TagType::CUSTOM)
       dispatchTag(tag, Attrs);
     else
-      writer.custom_tag(name.c_str(), Attrs);
+      writer.custom_tag(internCustomTagName(name), Attrs);
     if (!isClosed)
       enter(tag);
   } else if (is.eof()) {
@@ -260,6 +262,9 @@ MaybeError SVGReaderWriterBase::parseAttrValue(instream_t &is,
   val = value.str();
   return ParseSuccess;
 }
+const char *SVGReaderWriterBase::internCustomTagName(const std::string &name) {
+  return customTagNames.insert(name).first->c_str();
+}
 std::string SVGReaderWriterBase::parseName(instream_t &is) {
   std::stringstream namestr;
   for (; !is.eof() && Tok != '>' && Tok != '/' && Tok != '=' &&
@@ -0,0 +1,127 @@
+#include "svgutils/svg_style_resolver.h"
+#include "svgutils/css_stylesheet.h"
+#include "svgutils/utils.h"
+
+#include <algorithm>
+
+using namespace svg;
+
+SVGComputedStyle SVGComputedStyle::from(const StyleTracker &styles) {
+  SVGComputedStyle res;
+  res.color = styles.getColor();
+  res.fill = styles.getFill();
+  res.stroke = styles.getStroke();
+  res.strokeWidth = styles.getStrokeWidth();
+  res.strokeDasharray = styles.getStrokeDasharray();
+  res.fontSize = styles.getFontSize();
+  res.fontFamily = std::string(styles.getFontFamily());
+  res.textAnchor = styles.getTextAnchor();
+  res.width = styles.getWidth();
+  res.height = styles.getHeight();
+  return res;
+}
+
+namespace {
+std::vector<SVGAttribute> getAttrs(const SVGNode &node) {
+  std::vector<SVGAttribute> attrs;
+  attrs.reserve(node.attrs.size());
+  for (const SVGNode::Attr &attr : node.attrs)
+    attrs.emplace_back(
+        SVGAttribute::Create(attr.first.c_str(), attr.second.c_str()));
+  return attrs;
+}
+} // namespace
+
+size_t SVGStyleResolver::number(const SVGNode &node, std::string &css) {
+  size_t index = nodes.size();
+  if (node.isElement()) {
+    nodes.push_back(&node);
+    sizes.push_back(0);
+    indices.emplace(&node, index);
+  }
+  for (const auto &child : node.children) {
+    if (node.is(SVGNode::TagType::style) &&
+        child->kind == SVGNode::Kind::CONTENT) {
+      css += child->name;
+      css += '\n';
+    }
+    number(*child, css);
+  }
+  size_t size = nodes.size() - index;
+  if (node.isElement())
+    sizes[index] = size;
+  return size;
+}
+
+void SVGStyleResolver::plan(const SVGNode &node, StyleTracker &tracker,
+                            size_t grain, std::vector<Task> &tasks) {
+  Task *open = nullptr;
+  size_t openSize = 0;
+  for (const auto &child : node.children) {
+    if (!child->isElement())
+      continue;
+    size_t index = indices.at(child.get());
+    size_t size = sizes[index];
+    if (size <= grain) {
+      // Small siblings are batched until the task is large enough
+      if (!open || openSize + size > grain) {
+        open = &tasks.emplace_back(Task{{}, index, tracker.fork()});
+        openSize = 0;
+      }
+      open->roots.push_back(child.get());
+      openSize += size;
+      continue;
+    }
+    // Resolve the root of a large subtree here and split its children
+    open = nullptr;
+    tracker.push(getAttrs(*child), child->name.c_str());
+    styles[index] = SVGComputedStyle::from(tracker);
+    plan(*child, tracker, grain, tasks);
+    tracker.pop();
+  }
+}
+
+void SVGStyleResolver::resolveSubtree(const SVGNode &node,
+                                      StyleTracker &tracker, size_t &index) {
+  tracker.push(getAttrs(node), node.name.c_str());
+  styles[index++] = SVGComputedStyle::from(tracker);
+  for (const auto &child : node.children)
+    if (child->isElement())
+      resolveSubtree(*child, tracker, index);
+  tracker.pop();
+}
+
+SVGStyleResolver::Statistics
+SVGStyleResolver::resolve(const SVGDocument &document) {
+  nodes.clear();
+  sizes.clear();
+  indices.clear();
+  std::string css;
+  number(document.getRoot(), css);
+  styles.assign(nodes.size(), SVGComputedStyle());
+
+  Statistics stats;
+  stats.elements = nodes.size();
+  StyleTracker tracker;
+  if (css.size())
+    tracker.addStylesheet(css);
+  // Enough tasks per thread to even out subtrees of different cost
+  size_t numThreads = std::max(options.numThreads, 1u);
+  size_t grain =
+      std::max(options.minTaskElements, nodes.size() / (numThreads * 8));
+  std::vector<Task> tasks;
+  plan(document.getRoot(), tracker, grain, tasks);
+  stats.styles = tracker.getStatistics();
+  stats.tasks = tasks.size();
+
+  stats.threads = parallelFor(tasks.size(), numThreads, [&](size_t i) {
+    // The roots of a task are consecutive siblings, so their elements are
+    // numbered consecutively as well
+    size_t index = tasks[i].index;
+    for (const SVGNode *root : tasks[i].roots)
+      resolveSubtree(*root, tasks[i].styles, index);
+  });
+  for (const Task &task : tasks)
+    stats.styles += task.styles.getStatistics();
+  return stats;
+}
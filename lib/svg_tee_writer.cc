@@ -0,0 +1,135 @@
+#include "svgutils/svg_tee_writer.h"
+
+using namespace svg;
+
+SVGDynamicTeeWriter::SVGDynamicTeeWriter(Mode mode, size_t queueSize,
+                                         const SPSCWait &wait)
+    : mode(mode), queueSize(queueSize), wait(wait) {}
+
+SVGDynamicTeeWriter::~SVGDynamicTeeWriter() { stopWorkers(); }
+
+void SVGDynamicTeeWriter::addWriter(WriterConcept &writer) {
+  assert(!running && "Cannot add writers after the first call");
+  backends.emplace_back();
+  backends.back().writer = &writer;
+}
+
+void SVGDynamicTeeWriter::work(Backend &backend, SPSCWait wait) {
+  for (;;) {
+    EventPtr event = backend.queue->pop(wait);
+    if (!event)
+      return;
+    // Keep draining the queue after an error so that the producer never
+    // blocks on a full queue
+    if (backend.error)
+      continue;
+    if (auto res = event->replay(*backend.writer)) {
+      backend.error = res.to_error();
+      backend.failed.store(true, std::memory_order_release);
+    }
+  }
+}
+
+void SVGDynamicTeeWriter::startWorkers() {
+  running = true;
+  if (mode != Mode::THREADED)
+    return;
+  for (Backend &backend : backends) {
+    backend.queue = std::make_unique<SPSCQueue<EventPtr>>(queueSize);
+    backend.worker = std::thread(work, std::ref(backend), wait);
+  }
+}
+
+void SVGDynamicTeeWriter::stopWorkers() {
+  if (!running)
+    return;
+  running = false;
+  if (mode != Mode::THREADED)
+    return;
+  // An empty event pointer tells the workers to shut down
+  for (Backend &backend : backends)
+    backend.queue->push(nullptr, wait);
+  for (Backend &backend : backends)
+    backend.worker.join();
+}
+
+template <typename FnTy>
+SVGDynamicTeeWriter::RetTy SVGDynamicTeeWriter::forEach(FnTy &&fn) {
+  if (!running)
+    startWorkers();
+  std::optional<SVGWriterError> err;
+  for (Backend &backend : backends) {
+    RetTy res = fn(*backend.writer);
+    if (res && !err)
+      err = res.to_error();
+  }
+  if (err)
+    return *err;
+  return {};
+}
+
+SVGDynamicTeeWriter::RetTy SVGDynamicTeeWriter::post(SVGEvent &&event) {
+  if (!running)
+    startWorkers();
+  // All queues share the same immutable event
+  EventPtr shared = std::make_shared<const SVGEvent>(std::move(event));
+  for (Backend &backend : backends)
+    backend.queue->push(shared, wait);
+  for (Backend &backend : backends)
+    if (backend.failed.load(std::memory_order_acquire))
+      return *backend.error;
+  return {};
+}
+
+#define SVG_TAG(NAME, STR, ...)                                                \
+  SVGDynamicTeeWriter::RetTy SVGDynamicTeeWriter::NAME(                        \
+      const std::vector<SVGAttribute> &attrs) {                                \
+    if (mode == Mode::THREADED)                                                \
+      return post(SVGEvent(SVGEvent::TagType::NAME, attrs));                   \
+    return forEach(                                                            \
+        [&attrs](WriterConcept &writer) { return writer.NAME(attrs); });       \
+  }
+#include "svgutils/svg_entities.def"
+
+SVGDynamicTeeWriter::RetTy
+SVGDynamicTeeWriter::custom_tag(const char *tag,
+                                const std::vector<SVGAttribute> &attrs) {
+  if (mode == Mode::THREADED)
+    return post(SVGEvent(tag, attrs));
+  return forEach([tag, &attrs](WriterConcept &writer) {
+    return writer.custom_tag(tag, attrs);
+  });
+}
+SVGDynamicTeeWriter::RetTy SVGDynamicTeeWriter::enter() {
+  if (mode == Mode::THREADED)
+    return post(SVGEvent(SVGEvent::Kind::ENTER));
+  return forEach([](WriterConcept &writer) { return writer.enter(); });
+}
+SVGDynamicTeeWriter::RetTy SVGDynamicTeeWriter::leave() {
+  if (mode == Mode::THREADED)
+    return post(SVGEvent(SVGEvent::Kind::LEAVE));
+  return forEach([](WriterConcept &writer) { return writer.leave(); });
+}
+SVGDynamicTeeWriter::RetTy SVGDynamicTeeWriter::content(const char *text) {
+  if (mode == Mode::THREADED)
+    return post(SVGEvent(SVGEvent::Kind::CONTENT, text));
+  return forEach(
+      [text](WriterConcept &writer) { return writer.content(text); });
+}
+SVGDynamicTeeWriter::RetTy SVGDynamicTeeWriter::comment(const char *text) {
+  if (mode == Mode::THREADED)
+    return post(SVGEvent(SVGEvent::Kind::COMMENT, text));
+  return forEach(
+      [text](WriterConcept &writer) { return writer.comment(text); });
+}
+SVGDynamicTeeWriter::RetTy SVGDynamicTeeWriter::finish() {
+  if (mode != Mode::THREADED)
+    return forEach([](WriterConcept &writer) { return writer.finish(); });
+  post(SVGEvent(SVGEvent::Kind::FINISH));
+  // Wait for all backends to complete before reporting
+  stopWorkers();
+  for (Backend &backend : backends)
+    if (backend.error)
+      return *backend.error;
+  return {};
+}
@@ -30,7 +30,11 @@ std::string SVGAttribute::getValueStr() const {
         using T = std::decay_t<decltype(value)>;
         if constexpr (std::is_same_v<T, const char *>)
           s = value;
-        else
+        else if constexpr (std::is_same_v<T, SVGNumberTuple>) {
+          std::stringstream ss;
+          ss << value;
+          s = ss.str();
+        } else
           s = std::to_string(value);
       },
       value);
@@ -56,7 +60,10 @@ double SVGAttribute::toDouble() const {
         using T = std::decay_t<decltype(value)>;
         if constexpr (std::is_same_v<T, const char *>)
           res = std::stod(value);
-        else
+        else if constexpr (std::is_same_v<T, SVGNumberTuple>) {
+          assert(value.size() == 1 && "Cannot convert tuple to double");
+          res = value[0];
+        } else
           res = value;
       },
       value);
@@ -74,6 +81,14 @@ const char *SVGAttribute::GetUniqueNameFor(const char *name) {
   return name;
 }
 
+bool SVGAttribute::IsUniqueName(const char *name) {
+#define SVG_ATTR(NAME, STR, DEFAULT)                                           \
+  if (name == NAME::tagName)                                                   \
+    return true;
+#include "svgutils/svg_entities.def"
+  return false;
+}
+
 SVGAttribute SVGAttribute::Create(const char *name, const char *value) {
   return SVGAttribute(GetUniqueNameFor(name), value);
 }
@@ -83,3 +98,7 @@ SVGAttribute SVGAttribute::Create(const char *name, int64_t value) {
 SVGAttribute SVGAttribute::Create(const char *name, double value) {
   return SVGAttribute(GetUniqueNameFor(name), value);
 }
+SVGAttribute SVGAttribute::Create(const char *name,
+                                  const SVGNumberTuple &value) {
+  return SVGAttribute(GetUniqueNameFor(name), value);
+}
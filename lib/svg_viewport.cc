@@ -0,0 +1,180 @@
+#include "svgutils/svg_viewport.h"
+#include "svgutils/utils.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+
+using namespace svg;
+
+namespace {
+void skipSeparators(std::string_view &str) {
+  while (str.size() && (std::isspace(static_cast<unsigned char>(str.front())) ||
+                        str.front() == ','))
+    str.remove_prefix(1);
+}
+
+/// Offset of content of @p size in @p space aligned by @p align
+double alignOffset(SVGPreserveAspectRatio::Align align, double space,
+                   double size) {
+  switch (align) {
+  case SVGPreserveAspectRatio::Align::MIN:
+    return 0.;
+  case SVGPreserveAspectRatio::Align::MID:
+    return (space - size) / 2.;
+  case SVGPreserveAspectRatio::Align::MAX:
+    return space - size;
+  }
+  svg_unreachable("Encountered unexpected alignment");
+}
+} // namespace
+
+std::optional<SVGViewBox> SVGViewBox::parse(const SVGAttribute &attr) {
+  double numbers[4];
+  if (const SVGNumberTuple *tuple = attr.tupleOrNull()) {
+    if (tuple->size() != 4 || tuple->getFunction())
+      return std::nullopt;
+    std::copy(tuple->begin(), tuple->end(), numbers);
+  } else if (const char *cstr = attr.cstrOrNull()) {
+    std::string_view str = cstr;
+    for (double &number : numbers) {
+      skipSeparators(str);
+      size_t len = strview_scan_number(str);
+      if (!len)
+        return std::nullopt;
+      number = *strview_to_double(str.substr(0, len));
+      str.remove_prefix(len);
+    }
+    skipSeparators(str);
+    if (str.size())
+      return std::nullopt;
+  } else
+    return std::nullopt;
+  if (numbers[2] <= 0. || numbers[3] <= 0.)
+    return std::nullopt;
+  return SVGViewBox{numbers[0], numbers[1], numbers[2], numbers[3]};
+}
+
+SVGPreserveAspectRatio SVGPreserveAspectRatio::parse(std::string_view value) {
+  SVGPreserveAspectRatio res;
+  auto nextWord = [&value]() {
+    value = strview_trim(value);
+    size_t len = 0;
+    while (len < value.size() &&
+           !std::isspace(static_cast<unsigned char>(value[len])))
+      ++len;
+    std::string_view word = value.substr(0, len);
+    value.remove_prefix(len);
+    return word;
+  };
+  std::string_view word = nextWord();
+  // Only applies to images
+  if (word == "defer")
+    word = nextWord();
+  if (word == "none") {
+    res.none = true;
+  } else {
+    auto align = [](std::string_view name) -> std::optional<Align> {
+      if (name == "Min")
+        return Align::MIN;
+      if (name == "Mid")
+        return Align::MID;
+      if (name == "Max")
+        return Align::MAX;
+      return std::nullopt;
+    };
+    if (word.size() != 8 || word[0] != 'x' || word[4] != 'Y')
+      return {};
+    std::optional<Align> x = align(word.substr(1, 3));
+    std::optional<Align> y = align(word.substr(5, 3));
+    if (!x || !y)
+      return {};
+    res.x = *x;
+    res.y = *y;
+  }
+  word = nextWord();
+  if (word == "slice")
+    res.slice = true;
+  else if (word.size() && word != "meet")
+    return {};
+  if (nextWord().size())
+    return {};
+  return res;
+}
+
+PathData::Matrix
+SVGPreserveAspectRatio::getTransform(const SVGViewBox &viewBox, double width,
+                                     double height) const {
+  double sx = width / viewBox.width, sy = height / viewBox.height;
+  if (!none)
+    sx = sy = slice ? std::max(sx, sy) : std::min(sx, sy);
+  double tx = alignOffset(x, width, viewBox.width * sx);
+  double ty = alignOffset(y, height, viewBox.height * sy);
+  return {sx, 0., 0., sy, tx - viewBox.x * sx, ty - viewBox.y * sy};
+}
+
+SVGViewport SVGViewport::compute(double docWidth, double docHeight,
+                                 const std::optional<SVGViewBox> &viewBox,
+                                 const SVGPreserveAspectRatio &aspect,
+                                 double width, double height, Fit fit,
+                                 double dfltWidth, double dfltHeight) {
+  if (viewBox) {
+    if (!docWidth && !docHeight) {
+      docWidth = viewBox->width;
+      docHeight = viewBox->height;
+    } else if (!docWidth)
+      docWidth = docHeight * viewBox->width / viewBox->height;
+    else if (!docHeight)
+      docHeight = docWidth * viewBox->height / viewBox->width;
+  }
+  if (!docWidth)
+    docWidth = dfltWidth;
+  if (!docHeight)
+    docHeight = dfltHeight;
+
+  // The viewport and its offset on the output, and how much the document
+  // is scaled to it
+  SVGViewport res;
+  double viewportWidth = docWidth, viewportHeight = docHeight;
+  double x = 0., y = 0., scale = 1.;
+  if (!width && !height) {
+    res.width = docWidth;
+    res.height = docHeight;
+  } else if (fit == Fit::VIEWPORT) {
+    res.width = width ? width : dfltWidth;
+    res.height = height ? height : dfltHeight;
+    viewportWidth = res.width;
+    viewportHeight = res.height;
+  } else {
+    double sx = width / docWidth, sy = height / docHeight;
+    if (!width || !height)
+      scale = !width ? sy : sx;
+    else
+      scale = fit == Fit::FIT ? std::min(sx, sy) : std::max(sx, sy);
+    viewportWidth = docWidth * scale;
+    viewportHeight = docHeight * scale;
+    if (fit == Fit::FIT || !width || !height) {
+      res.width = std::max(1., std::round(viewportWidth));
+      res.height = std::max(1., std::round(viewportHeight));
+    } else {
+      res.width = width;
+      res.height = height;
+      x = (width - viewportWidth) / 2;
+      y = (height - viewportHeight) / 2;
+    }
+  }
+
+  res.transform =
+      viewBox ? aspect.getTransform(*viewBox, viewportWidth, viewportHeight)
+              : PathData::Matrix::scale(scale, scale);
+  res.transform.e += x;
+  res.transform.f += y;
+  res.userWidth = viewBox ? viewBox->width : viewportWidth / scale;
+  res.userHeight = viewBox ? viewBox->height : viewportHeight / scale;
+  return res;
+}
+
+double SVGViewport::getScale() const {
+  return std::sqrt(
+      std::abs(transform.a * transform.d - transform.b * transform.c));
+}
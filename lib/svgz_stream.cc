@@ -0,0 +1,166 @@
+#include "svgutils/svgz_stream.h"
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cctype>
+#include <fstream>
+#include <string_view>
+
+using namespace svg;
+
+// Add 32 to decode both gzip and zlib headers, add 16 to write gzip
+static constexpr int InflateWindowBits = MAX_WBITS + 32;
+static constexpr int DeflateWindowBits = MAX_WBITS + 16;
+
+InflateStreamBuf::InflateStreamBuf(std::istream &source, size_t bufferSize)
+    : source(source), zs(std::make_unique<z_stream>()), in(bufferSize),
+      out(bufferSize) {
+  if (inflateInit2(zs.get(), InflateWindowBits) != Z_OK) {
+    error = "Failed to initialize zlib";
+    done = true;
+  }
+}
+
+InflateStreamBuf::~InflateStreamBuf() { inflateEnd(zs.get()); }
+
+InflateStreamBuf::int_type InflateStreamBuf::underflow() {
+  if (gptr() < egptr())
+    return traits_type::to_int_type(*gptr());
+  while (!done) {
+    if (!zs->avail_in) {
+      source.read(in.data(), in.size());
+      zs->next_in = reinterpret_cast<Bytef *>(in.data());
+      zs->avail_in = static_cast<uInt>(source.gcount());
+      if (!zs->avail_in) {
+        if (!streamEnded)
+          error = "Unexpected end of compressed data";
+        done = true;
+        break;
+      }
+    }
+    if (streamEnded) {
+      // Another gzip member follows
+      inflateReset(zs.get());
+      streamEnded = false;
+    }
+    zs->next_out = reinterpret_cast<Bytef *>(out.data());
+    zs->avail_out = static_cast<uInt>(out.size());
+    int ret = inflate(zs.get(), Z_NO_FLUSH);
+    if (ret == Z_STREAM_END)
+      streamEnded = true;
+    else if (ret != Z_OK && ret != Z_BUF_ERROR) {
+      // The output of this call is still delivered, the next one ends the
+      // stream
+      error = zs->msg ? zs->msg : "Corrupt compressed data";
+      done = true;
+    }
+    size_t produced = out.size() - zs->avail_out;
+    if (produced) {
+      setg(out.data(), out.data(), out.data() + produced);
+      return traits_type::to_int_type(*gptr());
+    }
+  }
+  return traits_type::eof();
+}
+
+DeflateStreamBuf::DeflateStreamBuf(std::ostream &sink, int level,
+                                   size_t bufferSize)
+    : sink(sink), zs(std::make_unique<z_stream>()), in(bufferSize),
+      out(bufferSize) {
+  assert(level >= -1 && level <= 9 && "Invalid compression level");
+  if (deflateInit2(zs.get(), level, Z_DEFLATED, DeflateWindowBits, 8,
+                   Z_DEFAULT_STRATEGY) != Z_OK) {
+    closed = true;
+    sink.setstate(std::ios::badbit);
+  }
+  // Leave room for the character passed to overflow()
+  setp(in.data(), in.data() + in.size() - 1);
+}
+
+DeflateStreamBuf::~DeflateStreamBuf() {
+  close();
+  deflateEnd(zs.get());
+}
+
+bool DeflateStreamBuf::compress(int flush) {
+  zs->next_in = reinterpret_cast<Bytef *>(pbase());
+  zs->avail_in = static_cast<uInt>(pptr() - pbase());
+  int ret;
+  do {
+    zs->next_out = reinterpret_cast<Bytef *>(out.data());
+    zs->avail_out = static_cast<uInt>(out.size());
+    ret = deflate(zs.get(), flush);
+    if (ret == Z_STREAM_ERROR)
+      return false;
+    sink.write(out.data(), out.size() - zs->avail_out);
+  } while (!zs->avail_out || (flush == Z_FINISH && ret != Z_STREAM_END));
+  setp(in.data(), in.data() + in.size() - 1);
+  return !!sink;
+}
+
+DeflateStreamBuf::int_type DeflateStreamBuf::overflow(int_type c) {
+  if (closed)
+    return traits_type::eof();
+  if (!traits_type::eq_int_type(c, traits_type::eof())) {
+    *pptr() = traits_type::to_char_type(c);
+    pbump(1);
+  }
+  if (!compress(Z_NO_FLUSH))
+    return traits_type::eof();
+  return traits_type::not_eof(c);
+}
+
+int DeflateStreamBuf::sync() {
+  if (closed)
+    return 0;
+  if (!compress(Z_NO_FLUSH))
+    return -1;
+  return sink.flush() ? 0 : -1;
+}
+
+bool DeflateStreamBuf::close() {
+  if (closed)
+    return true;
+  closed = true;
+  bool success = compress(Z_FINISH);
+  sink.flush();
+  return success && sink;
+}
+
+bool svg::isSVGZPath(const std::string &path) {
+  static constexpr std::string_view Ext = ".svgz";
+  if (path.size() < Ext.size())
+    return false;
+  return std::equal(Ext.begin(), Ext.end(), path.end() - Ext.size(),
+                    [](char a, char b) {
+                      return a == std::tolower(static_cast<unsigned char>(b));
+                    });
+}
+
+std::unique_ptr<std::istream> svg::openSVGInput(const std::string &path) {
+  auto file = std::make_unique<std::ifstream>(path, std::ios::binary);
+  if (!*file)
+    return nullptr;
+  // Detect the gzip magic bytes instead of trusting the extension
+  char magic[2] = {};
+  file->read(magic, sizeof(magic));
+  bool compressed = file->gcount() == 2 && magic[0] == '\x1f' &&
+                    magic[1] == static_cast<char>('\x8b');
+  file->clear();
+  file->seekg(0);
+  if (compressed)
+    return std::make_unique<GzipInputStream>(std::move(file));
+  return file;
+}
+
+std::unique_ptr<std::ostream> svg::openSVGOutput(const std::string &path,
+                                                 int level) {
+  auto file = std::make_unique<std::ofstream>(path, std::ios::binary);
+  if (!*file)
+    return nullptr;
+  if (isSVGZPath(path))
+    return std::make_unique<GzipOutputStream>(std::move(file), level);
+  return file;
+}
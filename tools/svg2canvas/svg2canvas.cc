@@ -0,0 +1,66 @@
+#include "svgutils/canvas_writer.h"
+#include "svgutils/cli_args.h"
+#include "svgutils/svg_reader_writer.h"
+#include "svgutils/svgz_stream.h"
+
+#include <filesystem>
+#include <fstream>
+
+using namespace svg;
+namespace fs = std::filesystem;
+
+static cl::opt<fs::path> Infile(cl::meta("Input"), cl::required());
+static cl::opt<fs::path> Outfile(cl::name("o"), cl::init("-"));
+static cl::opt<bool> Verbose(cl::name("v"), cl::init(false));
+/// Write canvas calls instead of a command table and its replay function
+static cl::opt<bool> Calls(cl::name("calls"), cl::init(false));
+/// Name of the variable holding the canvas' 2D context
+static cl::opt<std::string> Context(cl::name("context"), cl::init("ctx"));
+/// Decimals kept of coordinates
+static cl::opt<unsigned> Precision(
+    cl::name("precision"), cl::init(SVGCanvasWriter::DefaultPrecision));
+
+static const char *TOOLNAME = "svg2canvas";
+static const char *TOOLDESC =
+    "Convert SVG files to JavaScript drawing them on an HTML canvas";
+
+int main(int argc, const char **argv) {
+  cl::ParseArgs(TOOLNAME, TOOLDESC, argc, argv);
+  if (!fs::exists(Infile)) {
+    std::cerr << "Input file does not exist" << std::endl;
+    return 1;
+  }
+  // Transparently decompresses .svgz files
+  std::unique_ptr<std::istream> in = openSVGInput(Infile->string());
+  if (!in) {
+    std::cerr << "Unable to read input file" << std::endl;
+    return 1;
+  }
+  std::ofstream outfile;
+  std::ostream *out = &std::cout;
+  if (*Outfile != "-") {
+    outfile.open(*Outfile);
+    if (!outfile) {
+      std::cerr << "Unable to create output file" << std::endl;
+      return 1;
+    }
+    out = &outfile;
+  }
+
+  auto mode =
+      Calls ? SVGCanvasWriter::Mode::CALLS : SVGCanvasWriter::Mode::COMMANDS;
+  SVGReaderWriter<SVGCanvasWriter> Reader(*out, mode, Context->c_str(),
+                                          Precision);
+  if (auto err = Reader.parse(*in)) {
+    std::cerr << "An error occurred:\n" << *err << std::endl;
+    return 1;
+  }
+  if (Verbose)
+    std::cerr << "Styles: " << Reader.getWriter().getStyleStatistics()
+              << std::endl;
+  if (!*out) {
+    std::cerr << "Failed to write output" << std::endl;
+    return 1;
+  }
+  return 0;
+}
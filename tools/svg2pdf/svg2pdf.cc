@@ -1,9 +1,12 @@
 #include "svgutils/cli_args.h"
+#include "svgutils/svg_pipeline.h"
 #include "svgutils/svg_reader_writer.h"
+#include "svgutils/svgz_stream.h"
 #include "svgcairo/svg_cairo.h"
 
 #include <filesystem>
-#include <fstream>
+#include <memory>
+#include <type_traits>
 
 using namespace svg;
 namespace fs = std::filesystem;
@@ -15,30 +18,68 @@ static cl::opt<unsigned> Width(cl::name("w"), cl::init(0));
 static cl::opt<unsigned> Height(cl::name("h"), cl::init(0));
 static cl::opt<unsigned> DefaultWidth(cl::name("W"), cl::init(300));
 static cl::opt<unsigned> DefaultHeight(cl::name("H"), cl::init(200));
+/// Parse and render on separate threads
+static cl::opt<bool> Pipelined(cl::name("pipelined"), cl::init(false));
+static cl::opt<unsigned> QueueSize(cl::name("queue-size"), cl::init(4096));
 
 static const char *TOOLNAME = "svg2pdf";
 static const char *TOOLDESC = "Convert SVG documents to PDF files";
 
-int main(int argc, const char **argv) {
-  cl::ParseArgs(TOOLNAME, TOOLDESC, argc, argv);
-  if (!fs::exists(Infile)) {
-    std::cerr << "Input file does not exist" << std::endl;
-    return 1;
-  }
-  std::fstream in(Infile->c_str(), in.in);
+template <template <typename> class ReaderTy>
+static int convert(std::istream &in) {
+  std::unique_ptr<ReaderTy<CairoSVGWriter>> Reader;
   if (!Width && !Height) {
-    SVGReaderWriter<CairoSVGWriter> Reader(Outfile, CairoSVGWriter::PDF);
-    CairoSVGWriter &cairo = Reader.getWriter();
+    Reader = std::make_unique<ReaderTy<CairoSVGWriter>>(Outfile,
+                                                       CairoSVGWriter::PDF);
+    CairoSVGWriter &cairo = Reader->getWriter();
     cairo.setDefaultWidth(DefaultWidth);
     cairo.setDefaultHeight(DefaultHeight);
-    Reader.parse(in);
   } else {
     if (!Width || !Height) {
       std::cerr << "PDF dimension zero or not set" << std::endl;
       return 1;
     }
-    SVGReaderWriter<CairoSVGWriter> Reader(Outfile, CairoSVGWriter::PDF, Width, Height);
-    Reader.parse(in);
+    Reader = std::make_unique<ReaderTy<CairoSVGWriter>>(
+        Outfile, CairoSVGWriter::PDF, Width, Height);
+  }
+  if constexpr (std::is_same_v<ReaderTy<CairoSVGWriter>,
+                               SVGPipelinedReaderWriter<CairoSVGWriter>>) {
+    SVGPipelineWriter::Options options;
+    options.queueSize = QueueSize;
+    Reader->getPipeline().setOptions(options);
+  }
+  if (auto err_opt = Reader->parse(in)) {
+    std::cerr << "An Error occurred\n";
+    std::cerr << *err_opt << '\n';
+    return 1;
+  }
+  if constexpr (std::is_same_v<ReaderTy<CairoSVGWriter>,
+                               SVGPipelinedReaderWriter<CairoSVGWriter>>) {
+    if (Verbose)
+      std::cerr << "Pipeline: " << Reader->getPipeline().getStatistics()
+                << '\n';
   }
   return 0;
 }
+
+int main(int argc, const char **argv) {
+  cl::ParseArgs(TOOLNAME, TOOLDESC, argc, argv);
+  if (!fs::exists(Infile)) {
+    std::cerr << "Input file does not exist" << std::endl;
+    return 1;
+  }
+  // Transparently decompresses .svgz files
+  std::unique_ptr<std::istream> in = openSVGInput(Infile->string());
+  if (!in) {
+    std::cerr << "Unable to read input file" << std::endl;
+    return 1;
+  }
+  int res = Pipelined ? convert<SVGPipelinedReaderWriter>(*in)
+                      : convert<SVGReaderWriter>(*in);
+  if (auto *gz = dynamic_cast<GzipInputStream *>(in.get());
+      gz && gz->failed()) {
+    std::cerr << "Decompression failed: " << gz->getError() << std::endl;
+    return 1;
+  }
+  return res;
+}
@@ -1,9 +1,13 @@
 #include "svgutils/cli_args.h"
+#include "svgutils/svg_pipeline.h"
 #include "svgutils/svg_reader_writer.h"
+#include "svgutils/svgz_stream.h"
+#include "svgcairo/cairo_display_list.h"
 #include "svgcairo/svg_cairo.h"
 
 #include <filesystem>
-#include <fstream>
+#include <memory>
+#include <type_traits>
 
 using namespace svg;
 namespace fs = std::filesystem;
@@ -13,40 +17,144 @@ static cl::opt<fs::path> Outfile(cl::name("o"), cl::required());
 static cl::opt<bool> Verbose(cl::name("v"), cl::init(false));
 static cl::opt<unsigned> Width(cl::name("w"), cl::init(0));
 static cl::opt<unsigned> Height(cl::name("h"), cl::init(0));
+/// Scale the document to fit into or fill -w and -h, keeping its aspect
+/// ratio. Only the output pixels are rasterized. With -fit, one of the
+/// dimensions may be left out.
+static cl::opt<bool> Fit(cl::name("fit"), cl::init(false));
+static cl::opt<bool> Fill(cl::name("fill"), cl::init(false));
 static cl::opt<unsigned> DefaultWidth(cl::name("W"), cl::init(300));
 static cl::opt<unsigned> DefaultHeight(cl::name("H"), cl::init(200));
+/// Parse and render on separate threads
+static cl::opt<bool> Pipelined(cl::name("pipelined"), cl::init(false));
+static cl::opt<unsigned> QueueSize(cl::name("queue-size"), cl::init(4096));
+/// Rasterize in tiles on this many threads. 1 renders to the image directly.
+/// With -sizes, the number of images rendered at the same time.
+static cl::opt<unsigned> NumThreads(cl::name("j"), cl::init(1));
+/// Also write images of these widths (e.g. thumbnails) to
+/// `<output>-<width>.png`. The document is recorded once into a display list
+/// and all images are rendered from it.
+static cl::list<unsigned> Sizes(cl::name("sizes"));
+/// Level of detail with -sizes: Simplify paths to this many pixels and drop
+/// shapes smaller than -min-size pixels
+static cl::opt<double> Simplify(cl::name("simplify"), cl::init(0.));
+static cl::opt<double> MinSize(cl::name("min-size"), cl::init(0.));
+static cl::opt<unsigned>
+    TileSize(cl::name("tile-size"), cl::init(CairoSVGWriter::DefaultTileSize));
 
 static const char *TOOLNAME = "svg2png";
 static const char *TOOLDESC = "Convert SVG documents to PNG images";
 
-int main(int argc, const char **argv) {
-  cl::ParseArgs(TOOLNAME, TOOLDESC, argc, argv);
-  if (!fs::exists(Infile)) {
-    std::cerr << "Input file does not exist" << std::endl;
-    return 1;
-  }
-  std::fstream in(Infile->c_str(), in.in);
+template <template <typename> class ReaderTy>
+static int convert(std::istream &in) {
+  std::unique_ptr<ReaderTy<CairoSVGWriter>> Reader;
   if (!Width && !Height) {
-    SVGReaderWriter<CairoSVGWriter> Reader(Outfile, CairoSVGWriter::PNG);
-    CairoSVGWriter &cairo = Reader.getWriter();
+    Reader = std::make_unique<ReaderTy<CairoSVGWriter>>(Outfile,
+                                                       CairoSVGWriter::PNG);
+    CairoSVGWriter &cairo = Reader->getWriter();
     cairo.setDefaultWidth(DefaultWidth);
     cairo.setDefaultHeight(DefaultHeight);
-    if (auto err_opt = Reader.parse(in)) {
-      std::cerr << "An Error occurred\n";
-      std::cerr << *err_opt << '\n';
-      return 1;
-    }
   } else {
-    if (!Width || !Height) {
-      std::cerr << "PNG dimension zero or not set" << std::endl;
+    if (Fit && Fill) {
+      std::cerr << "-fit and -fill can't be combined" << std::endl;
       return 1;
     }
-    SVGReaderWriter<CairoSVGWriter> Reader(Outfile, CairoSVGWriter::PNG, Width, Height);
-    if (auto err_opt = Reader.parse(in)) {
-      std::cerr << "An Error occurred\n";
-      std::cerr << *err_opt << '\n';
+    if ((!Width || !Height) && !Fit) {
+      std::cerr << "PNG dimension zero or not set" << std::endl;
       return 1;
     }
+    Reader = std::make_unique<ReaderTy<CairoSVGWriter>>(
+        Outfile, CairoSVGWriter::PNG, Width, Height);
+    if (Fit || Fill)
+      Reader->getWriter().setFit(Fit ? CairoSVGWriter::Fit::FIT
+                                     : CairoSVGWriter::Fit::FILL);
+  }
+  if (NumThreads > 1)
+    Reader->getWriter().setTiling(NumThreads, TileSize);
+  if constexpr (std::is_same_v<ReaderTy<CairoSVGWriter>,
+                               SVGPipelinedReaderWriter<CairoSVGWriter>>) {
+    SVGPipelineWriter::Options options;
+    options.queueSize = QueueSize;
+    Reader->getPipeline().setOptions(options);
+  }
+  if (auto err_opt = Reader->parse(in)) {
+    std::cerr << "An Error occurred\n";
+    std::cerr << *err_opt << '\n';
+    return 1;
+  }
+  if (Verbose) {
+    std::cerr << "Styles: " << Reader->getWriter().getStyleStatistics()
+              << '\n';
+    std::cerr << "Paths: " << Reader->getWriter().getPathCacheStatistics()
+              << '\n';
+    std::cerr << "Culling: " << Reader->getWriter().getCullingStatistics()
+              << '\n';
+  }
+  if constexpr (std::is_same_v<ReaderTy<CairoSVGWriter>,
+                               SVGPipelinedReaderWriter<CairoSVGWriter>>) {
+    if (Verbose)
+      std::cerr << "Pipeline: " << Reader->getPipeline().getStatistics()
+                << '\n';
   }
   return 0;
 }
+
+static int convertSizes(std::istream &in) {
+  if (Width || Height) {
+    std::cerr << "-sizes can't be combined with fixed dimensions" << std::endl;
+    return 1;
+  }
+  SVGDisplayListBuilder builder;
+  builder.setDefaultSize(DefaultWidth, DefaultHeight);
+  SVGReaderWriterBase reader(builder);
+  if (auto err_opt = reader.parse(in)) {
+    std::cerr << "An Error occurred\n";
+    std::cerr << *err_opt << '\n';
+    return 1;
+  }
+  const SVGDisplayList &list = builder.getDisplayList();
+  std::vector<CairoDisplayListRenderer::Target> targets;
+  targets.push_back({*Outfile, CairoSVGWriter::PNG, 1.});
+  for (unsigned size : Sizes) {
+    fs::path outfile = *Outfile;
+    outfile.replace_filename(Outfile->stem().string() + "-" +
+                             std::to_string(size) +
+                             Outfile->extension().string());
+    targets.push_back({outfile, CairoSVGWriter::PNG, size / list.getWidth()});
+  }
+  if (Verbose) {
+    std::cerr << "Styles: " << builder.getStyleStatistics() << '\n';
+    std::cerr << "Display list: " << list.getItems().size() << " items, "
+              << list.getPaints().size() << " paints, "
+              << list.getMemoryUsage() << " bytes\n";
+  }
+  CairoDisplayListRenderer renderer(list);
+  renderer.setLevelOfDetail({Simplify, MinSize});
+  CairoDisplayListRenderer::Statistics stats;
+  bool success = renderer.render(targets, NumThreads, &stats);
+  if (Verbose)
+    std::cerr << "Rendering: " << stats << '\n';
+  return success ? 0 : 1;
+}
+
+int main(int argc, const char **argv) {
+  cl::ParseArgs(TOOLNAME, TOOLDESC, argc, argv);
+  if (!fs::exists(Infile)) {
+    std::cerr << "Input file does not exist" << std::endl;
+    return 1;
+  }
+  // Transparently decompresses .svgz files
+  std::unique_ptr<std::istream> in = openSVGInput(Infile->string());
+  if (!in) {
+    std::cerr << "Unable to read input file" << std::endl;
+    return 1;
+  }
+  int res = !Sizes->empty() ? convertSizes(*in)
+            : Pipelined      ? convert<SVGPipelinedReaderWriter>(*in)
+                             : convert<SVGReaderWriter>(*in);
+  if (auto *gz = dynamic_cast<GzipInputStream *>(in.get());
+      gz && gz->failed()) {
+    std::cerr << "Decompression failed: " << gz->getError() << std::endl;
+    return 1;
+  }
+  return res;
+}
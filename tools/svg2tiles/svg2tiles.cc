@@ -0,0 +1,88 @@
+#include "svgutils/cli_args.h"
+#include "svgutils/svg_reader_writer.h"
+#include "svgutils/svgz_stream.h"
+#include "svgcairo/cairo_tile_pyramid.h"
+
+#include <filesystem>
+#include <memory>
+
+using namespace svg;
+namespace fs = std::filesystem;
+
+static cl::opt<fs::path> Infile(cl::meta("Input"), cl::required());
+/// Tiles are written to `<output>/<zoom>/<x>/<y>.png`
+static cl::opt<fs::path> Outdir(cl::name("o"), cl::required());
+static cl::opt<bool> Verbose(cl::name("v"), cl::init(false));
+static cl::opt<unsigned> DefaultWidth(cl::name("W"), cl::init(300));
+static cl::opt<unsigned> DefaultHeight(cl::name("H"), cl::init(200));
+static cl::opt<unsigned> MinZoom(cl::name("min-zoom"), cl::init(0));
+static cl::opt<unsigned> MaxZoom(cl::name("max-zoom"), cl::init(4));
+static cl::opt<unsigned>
+    TileSize(cl::name("tile-size"),
+             cl::init(CairoTilePyramid::DefaultTileSize));
+/// Number of tiles rendered at the same time
+static cl::opt<unsigned>
+    NumThreads(cl::name("j"), cl::init(std::thread::hardware_concurrency()));
+/// Simplify paths to this many pixels and drop shapes smaller than
+/// -min-size pixels
+static cl::opt<double> Simplify(cl::name("simplify"), cl::init(0.));
+static cl::opt<double> MinSize(cl::name("min-size"), cl::init(0.));
+
+static const char *TOOLNAME = "svg2tiles";
+static const char *TOOLDESC =
+    "Render SVG documents to a pyramid of PNG map tiles";
+
+int main(int argc, const char **argv) {
+  cl::ParseArgs(TOOLNAME, TOOLDESC, argc, argv);
+  if (!fs::exists(Infile)) {
+    std::cerr << "Input file does not exist" << std::endl;
+    return 1;
+  }
+  if (MinZoom > MaxZoom || !TileSize) {
+    std::cerr << "No tiles to render" << std::endl;
+    return 1;
+  }
+  if (MaxZoom > CairoTilePyramid::MaxZoomLevel) {
+    std::cerr << "The maximum zoom level is "
+              << CairoTilePyramid::MaxZoomLevel << std::endl;
+    return 1;
+  }
+  // Transparently decompresses .svgz files
+  std::unique_ptr<std::istream> in = openSVGInput(Infile->string());
+  if (!in) {
+    std::cerr << "Unable to read input file" << std::endl;
+    return 1;
+  }
+  SVGDisplayListBuilder builder;
+  builder.setDefaultSize(DefaultWidth, DefaultHeight);
+  SVGReaderWriterBase reader(builder);
+  if (auto err_opt = reader.parse(*in)) {
+    std::cerr << "An Error occurred\n";
+    std::cerr << *err_opt << '\n';
+    return 1;
+  }
+  if (auto *gz = dynamic_cast<GzipInputStream *>(in.get());
+      gz && gz->failed()) {
+    std::cerr << "Decompression failed: " << gz->getError() << std::endl;
+    return 1;
+  }
+
+  const SVGDisplayList &list = builder.getDisplayList();
+  CairoTilePyramid pyramid(list, MaxZoom, TileSize);
+  pyramid.setLevelOfDetail({Simplify, MinSize});
+  if (Verbose) {
+    size_t numTiles = 0;
+    for (unsigned z = MinZoom; z <= MaxZoom; ++z)
+      numTiles += pyramid.getNumTiles(z);
+    std::cerr << "Styles: " << builder.getStyleStatistics() << '\n';
+    std::cerr << "Display list: " << list.getItems().size() << " items, "
+              << list.getMemoryUsage() << " bytes, index: "
+              << pyramid.getIndex().getMemoryUsage() << " bytes\n";
+    std::cerr << "Tiles: " << numTiles << '\n';
+  }
+  CairoDisplayListRenderer::Statistics stats;
+  bool success = pyramid.render(MinZoom, Outdir, NumThreads, &stats);
+  if (Verbose)
+    std::cerr << "Rendering: " << stats << '\n';
+  return success ? 0 : 1;
+}
@@ -1,10 +1,10 @@
 #include "svgutils/cli_args.h"
 #include "svgutils/svg_formatted_writer.h"
+#include "svgutils/svg_minifying_writer.h"
 #include "svgutils/svg_reader_writer.h"
+#include "svgutils/svgz_stream.h"
 
 #include <filesystem>
-#include <fstream>
-#include <variant>
 
 using namespace svg;
 namespace fs = std::filesystem;
@@ -12,6 +12,13 @@ namespace fs = std::filesystem;
 static cl::opt<fs::path> Infile(cl::meta("Input"), cl::required());
 static cl::opt<fs::path> Outfile(cl::name("o"), cl::init("-"));
 static cl::opt<bool> Verbose(cl::name("v"), cl::init(false));
+/// Compression level for .svgz output (0-9)
+static cl::opt<unsigned> Level(cl::name("z"), cl::init(6));
+/// Write the smallest equivalent document instead of formatting it
+static cl::opt<bool> Minify(cl::name("minify"), cl::init(false));
+/// Decimals kept by -minify
+static cl::opt<unsigned> Precision(
+    cl::name("precision"), cl::init(SVGMinifyingWriter::DefaultPrecision));
 
 static const char *TOOLNAME = "svgfmt";
 static const char *TOOLDESC = "Format SVG documents";
@@ -22,19 +29,47 @@ int main(int argc, const char **argv) {
     std::cerr << "Input file does not exist" << std::endl;
     return 1;
   }
-  std::fstream in(Infile->c_str(), in.in);
-  std::optional<std::fstream> out_storage;
-  std::ostream *out = nullptr;
-  if (*Outfile == "-")
-    out = &std::cout;
-  else {
-    out_storage = std::fstream(Outfile->c_str(), std::fstream::out);
-    out = &*out_storage;
+  if (Level > 9) {
+    std::cerr << "Compression level must be between 0 and 9" << std::endl;
+    return 1;
+  }
+  // Transparently decompresses .svgz files
+  std::unique_ptr<std::istream> in = openSVGInput(Infile->string());
+  if (!in) {
+    std::cerr << "Unable to read input file" << std::endl;
+    return 1;
+  }
+  std::unique_ptr<std::ostream> out_storage;
+  std::ostream *out = &std::cout;
+  if (*Outfile != "-") {
+    // Compresses output to .svgz files
+    out_storage = openSVGOutput(Outfile->string(), Level);
+    if (!out_storage) {
+      std::cerr << "Unable to create output file" << std::endl;
+      return 1;
+    }
+    out = out_storage.get();
   }
 
-  SVGReaderWriter<SVGFormattedWriter> Reader(*out);
-  if (auto err = Reader.parse(in)) {
+  SVGReaderWriterBase::MaybeError err;
+  if (Minify) {
+    SVGReaderWriter<SVGMinifyingWriter> Reader(*out, Precision);
+    err = Reader.parse(*in);
+  } else {
+    SVGReaderWriter<SVGFormattedWriter> Reader(*out);
+    err = Reader.parse(*in);
+  }
+  if (err)
     std::cerr << "An error occurred:\n" << *err << std::endl;
+  auto *gz = dynamic_cast<GzipInputStream *>(in.get());
+  if (gz && gz->failed())
+    std::cerr << "Decompression failed: " << gz->getError() << std::endl;
+  if (err || (gz && gz->failed()))
+    return 1;
+  if (auto *gz = dynamic_cast<GzipOutputStream *>(out_storage.get()))
+    gz->close();
+  if (!*out) {
+    std::cerr << "Failed to write output" << std::endl;
     return 1;
   }
   return 0;
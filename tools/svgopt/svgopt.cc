@@ -0,0 +1,107 @@
+#include "svgutils/cli_args.h"
+#include "svgutils/svg_dedup_writer.h"
+#include "svgutils/svg_document.h"
+#include "svgutils/svg_formatted_writer.h"
+#include "svgutils/svg_minifying_writer.h"
+#include "svgutils/svg_optimizer.h"
+#include "svgutils/svg_reader_writer.h"
+#include "svgutils/svgz_stream.h"
+
+#include <filesystem>
+
+using namespace svg;
+namespace fs = std::filesystem;
+
+static cl::opt<fs::path> Infile(cl::meta("Input"), cl::required());
+static cl::opt<fs::path> Outfile(cl::name("o"), cl::init("-"));
+/// Print statistics of the optimization passes
+static cl::opt<bool> Verbose(cl::name("v"), cl::init(false));
+/// Compression level for .svgz output (0-9)
+static cl::opt<unsigned> Level(cl::name("z"), cl::init(6));
+/// Write the smallest equivalent document instead of formatting it
+static cl::opt<bool> Minify(cl::name("minify"), cl::init(false));
+/// Decimals kept by -minify
+static cl::opt<unsigned> Precision(
+    cl::name("precision"), cl::init(SVGMinifyingWriter::DefaultPrecision));
+/// Replace repeated subtrees with <use> elements. The renderers of this
+/// project don't draw <use> yet, so a warning is printed if there are any.
+static cl::opt<bool> Dedup(cl::name("dedup"), cl::init(false));
+/// Number of threads used for optimizing subtrees
+static cl::opt<unsigned>
+    NumThreads(cl::name("j"), cl::init(std::thread::hardware_concurrency()));
+
+static const char *TOOLNAME = "svgopt";
+static const char *TOOLDESC = "Optimize the structure of SVG documents";
+
+int main(int argc, const char **argv) {
+  cl::ParseArgs(TOOLNAME, TOOLDESC, argc, argv);
+  if (!fs::exists(Infile)) {
+    std::cerr << "Input file does not exist" << std::endl;
+    return 1;
+  }
+  if (Level > 9) {
+    std::cerr << "Compression level must be between 0 and 9" << std::endl;
+    return 1;
+  }
+  // Transparently decompresses .svgz files
+  std::unique_ptr<std::istream> in = openSVGInput(Infile->string());
+  if (!in) {
+    std::cerr << "Unable to read input file" << std::endl;
+    return 1;
+  }
+
+  SVGDocumentBuilder builder;
+  SVGReaderWriterBase reader(builder);
+  auto err = reader.parse(*in);
+  if (err)
+    std::cerr << "An error occurred:\n" << *err << std::endl;
+  auto *gz = dynamic_cast<GzipInputStream *>(in.get());
+  if (gz && gz->failed())
+    std::cerr << "Decompression failed: " << gz->getError() << std::endl;
+  if (err || (gz && gz->failed()))
+    return 1;
+  SVGDocument &document = builder.getDocument();
+
+  SVGOptimizer::Options options;
+  options.numThreads = std::max(*NumThreads, 1u);
+  SVGOptimizer::Statistics stats = SVGOptimizer(options).optimize(document);
+  if (Verbose)
+    std::cerr << stats << std::endl;
+
+  std::unique_ptr<std::ostream> out_storage;
+  std::ostream *out = &std::cout;
+  if (*Outfile != "-") {
+    // Compresses output to .svgz files
+    out_storage = openSVGOutput(Outfile->string(), Level);
+    if (!out_storage) {
+      std::cerr << "Unable to create output file" << std::endl;
+      return 1;
+    }
+    out = out_storage.get();
+  }
+  std::unique_ptr<WriterConcept> writer;
+  if (Minify)
+    writer = std::make_unique<WriterModel<SVGMinifyingWriter>>(*out, Precision);
+  else
+    writer = std::make_unique<WriterModel<SVGFormattedWriter>>(*out);
+  std::unique_ptr<SVGDedupWriter> dedup;
+  if (Dedup)
+    dedup = std::make_unique<SVGDedupWriter>(*writer);
+  if (auto res = document.write(dedup ? *dedup : *writer)) {
+    std::cerr << "An error occurred:\n" << res.to_error().what() << std::endl;
+    return 1;
+  }
+  if (Verbose && dedup)
+    std::cerr << dedup->getStatistics() << std::endl;
+  if (dedup && dedup->getStatistics().uses)
+    std::cerr << "Warning: The output uses <use> elements, which svg2png, "
+                 "svg2pdf and svg2canvas don't draw yet"
+              << std::endl;
+  if (auto *gz = dynamic_cast<GzipOutputStream *>(out_storage.get()))
+    gz->close();
+  if (!*out) {
+    std::cerr << "Failed to write output" << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,59 @@
+#include "svgcairo/cairo_display_list.h"
+#include "svgcairo/freetype.h"
+#include "svgutils/svg_reader_writer.h"
+#include "gtest/gtest.h"
+#include <cairo/cairo.h>
+
+#include <cstring>
+#include <sstream>
+
+using namespace ::svg;
+
+namespace {
+/// An image surface to draw on, compared by its pixels
+struct Image {
+  Image() {
+    surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, 80, 20);
+    cr = cairo_create(surface);
+  }
+  ~Image() {
+    cairo_destroy(cr);
+    cairo_surface_destroy(surface);
+  }
+  bool operator==(const Image &other) const {
+    cairo_surface_flush(surface);
+    cairo_surface_flush(other.surface);
+    size_t size = static_cast<size_t>(cairo_image_surface_get_stride(surface)) *
+                  cairo_image_surface_get_height(surface);
+    return !std::memcmp(cairo_image_surface_get_data(surface),
+                        cairo_image_surface_get_data(other.surface), size);
+  }
+
+  cairo_surface_t *surface;
+  cairo_t *cr;
+};
+} // namespace
+
+TEST(CairoDisplayListTest, ContinuedText) {
+  // The second run continues after the first, with a rect in between
+  std::stringstream in("<svg width=\"80\" height=\"20\" fill=\"black\">"
+                       "<rect x=\"70\" width=\"5\" height=\"5\"/>"
+                       "<text x=\"2\" y=\"15\" font-size=\"12\">ab"
+                       "<rect width=\"1\" height=\"1\"/>cd</text></svg>");
+  SVGDisplayListBuilder builder;
+  SVGReaderWriterBase reader(builder);
+  ASSERT_FALSE(reader.parse(in));
+  const SVGDisplayList &list = builder.getDisplayList();
+  ASSERT_EQ(list.getItems().size(), 4u);
+  ASSERT_EQ(list.getItems()[2].kind, SVGDisplayList::Kind::PATH);
+
+  std::optional<Freetype> fonts = Freetype::Create();
+  ASSERT_TRUE(fonts);
+  CairoDisplayListRenderer renderer(list);
+  Image direct, split;
+  renderer.draw(direct.cr, *fonts);
+  // Drawn on its own, the continued run still starts after the first one
+  renderer.draw(split.cr, *fonts, {0, 1, 2});
+  renderer.draw(split.cr, *fonts, {3});
+  EXPECT_TRUE(direct == split);
+}
@@ -0,0 +1,133 @@
+#include "svgcairo/cairo_path_cache.h"
+#include "gtest/gtest.h"
+#include <cairo/cairo.h>
+
+#include <vector>
+
+namespace svg {
+class CairoPathCacheTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, 10, 10);
+    cr = cairo_create(surface);
+  }
+  void TearDown() override {
+    cairo_destroy(cr);
+    cairo_surface_destroy(surface);
+  }
+
+  /// A path with @p points line segments
+  cairo_path_t *makePath(int points) {
+    cairo_new_path(cr);
+    cairo_move_to(cr, 0., 0.);
+    for (int i = 1; i <= points; ++i)
+      cairo_line_to(cr, i, i % 2);
+    cairo_close_path(cr);
+    return cairo_copy_path(cr);
+  }
+
+  static size_t getBytes(std::string_view d, const cairo_path_t *path) {
+    return CairoPathCache::getBytes(d, path);
+  }
+  static const cairo_path_t *find(CairoPathCache &cache, size_t key,
+                                  std::string_view d, double scale) {
+    return cache.find(key, d, scale);
+  }
+  static void insert(CairoPathCache &cache, size_t key, std::string_view d,
+                     double scale, cairo_path_t *path) {
+    cache.insert(key, d, scale, path);
+  }
+
+  cairo_surface_t *surface;
+  cairo_t *cr;
+};
+
+TEST_F(CairoPathCacheTest, Bytes) {
+  CairoPathCache cache;
+  cairo_path_t *a = makePath(1), *b = makePath(5);
+  size_t bytes = getBytes("M0 0", a) + getBytes("M0 0L1 1", b);
+  EXPECT_LT(getBytes("M0 0", a), getBytes("M0 0", b));
+  cache.insert("M0 0", 1., a);
+  cache.insert("M0 0L1 1", 1., b);
+  EXPECT_EQ(cache.getStatistics().entries, 2u);
+  EXPECT_EQ(cache.getStatistics().bytes, bytes);
+  cache.clear();
+  EXPECT_EQ(cache.getStatistics().entries, 0u);
+  EXPECT_EQ(cache.getStatistics().bytes, 0u);
+}
+
+TEST_F(CairoPathCacheTest, Eviction) {
+  cairo_path_t *path = makePath(1);
+  size_t bytes = getBytes("a", path);
+  cairo_path_destroy(path);
+  // Room for exactly two paths
+  CairoPathCache cache(2 * bytes);
+  cache.insert("a", 1., makePath(1));
+  cache.insert("b", 1., makePath(1));
+  // Using a makes b the least recently used
+  EXPECT_TRUE(cache.find("a", 1.));
+  cache.insert("c", 1., makePath(1));
+  EXPECT_EQ(cache.getStatistics().evictions, 1u);
+  EXPECT_EQ(cache.getStatistics().entries, 2u);
+  EXPECT_EQ(cache.getStatistics().bytes, 2 * bytes);
+  EXPECT_TRUE(cache.find("a", 1.));
+  EXPECT_FALSE(cache.find("b", 1.));
+  EXPECT_TRUE(cache.find("c", 1.));
+  // The scale is part of the key
+  EXPECT_FALSE(cache.find("a", 2.));
+  EXPECT_EQ(cache.getStatistics().hits, 3u);
+  EXPECT_EQ(cache.getStatistics().misses, 2u);
+}
+
+TEST_F(CairoPathCacheTest, Oversized) {
+  cairo_path_t *small = makePath(1);
+  CairoPathCache cache(getBytes("a", small));
+  cache.insert("a", 1., small);
+  // Paths larger than the whole cache aren't kept and evict nothing
+  cache.insert("b", 1., makePath(10));
+  EXPECT_FALSE(cache.find("b", 1.));
+  EXPECT_TRUE(cache.find("a", 1.));
+  EXPECT_EQ(cache.getStatistics().evictions, 0u);
+  EXPECT_EQ(cache.getStatistics().entries, 1u);
+}
+
+TEST_F(CairoPathCacheTest, HashCollision) {
+  CairoPathCache cache;
+  cairo_path_t *a = makePath(1), *b = makePath(2), *c = makePath(3);
+  insert(cache, 42, "a", 1., a);
+  insert(cache, 42, "b", 1., b);
+  insert(cache, 42, "a", 2., c);
+  EXPECT_EQ(find(cache, 42, "a", 1.), a);
+  EXPECT_EQ(find(cache, 42, "b", 1.), b);
+  EXPECT_EQ(find(cache, 42, "a", 2.), c);
+  EXPECT_FALSE(find(cache, 42, "c", 1.));
+  EXPECT_FALSE(find(cache, 43, "a", 1.));
+  cache.clear();
+  EXPECT_FALSE(find(cache, 42, "a", 1.));
+}
+
+TEST_F(CairoPathCacheTest, DrawsSamePath) {
+  CairoPathCache cache;
+  cairo_path_t *path = makePath(3);
+  std::vector<cairo_path_data_t> expected(path->data,
+                                          path->data + path->num_data);
+  cache.insert("M0 0L1 1L2 0L3 1Z", 1., path);
+  const cairo_path_t *cached = cache.find("M0 0L1 1L2 0L3 1Z", 1.);
+  ASSERT_TRUE(cached);
+  cairo_new_path(cr);
+  cairo_append_path(cr, cached);
+  cairo_path_t *drawn = cairo_copy_path(cr);
+  ASSERT_EQ(drawn->num_data, static_cast<int>(expected.size()));
+  for (int i = 0; i < drawn->num_data;) {
+    const cairo_path_data_t &header = drawn->data[i];
+    EXPECT_EQ(header.header.type, expected[i].header.type);
+    ASSERT_EQ(header.header.length, expected[i].header.length);
+    for (int j = 1; j < header.header.length; ++j) {
+      EXPECT_EQ(drawn->data[i + j].point.x, expected[i + j].point.x);
+      EXPECT_EQ(drawn->data[i + j].point.y, expected[i + j].point.y);
+    }
+    i += header.header.length;
+  }
+  cairo_path_destroy(drawn);
+}
+} // namespace svg
@@ -0,0 +1,59 @@
+#include "svgutils/canvas_writer.h"
+#include "svgutils/svg_reader_writer.h"
+#include "gtest/gtest.h"
+
+#include <cstring>
+#include <sstream>
+
+using namespace ::svg;
+
+static std::string draw(const std::string &body, SVGCanvasWriter::Mode mode) {
+  std::stringstream in("<svg width=\"100\" height=\"50\">" + body + "</svg>");
+  std::stringstream out;
+  SVGReaderWriter<SVGCanvasWriter> reader(out, mode, "ctx", 2);
+  EXPECT_FALSE(reader.parse(in));
+  return out.str();
+}
+
+TEST(CanvasWriterTest, Calls) {
+  EXPECT_EQ(draw("<rect x=\"1\" y=\"2\" width=\"50%\" height=\"4\" "
+                 "fill=\"red\"/>"
+                 "<g stroke=\"blue\"><path d=\"M0 0l10 0q5 5 0 10z\"/>"
+                 "<circle cx=\"5\" cy=\"5\" r=\"2\" stroke-width=\"2\"/></g>",
+                 SVGCanvasWriter::Mode::CALLS),
+            "(function(c) {\n"
+            "c.beginPath();c.rect(1,2,50,4);c.fillStyle=\"#ff0000\";c.fill();\n"
+            "c.beginPath();c.moveTo(0,0);c.lineTo(10,0);"
+            "c.bezierCurveTo(13.33,3.33,13.33,6.67,10,10);c.closePath();"
+            "c.strokeStyle=\"#0000ff\";c.stroke();\n"
+            "c.beginPath();c.ellipse(5,5,2,2,0,0,2*Math.PI);c.lineWidth=2;"
+            "c.stroke();\n"
+            "})(ctx);\n");
+}
+
+TEST(CanvasWriterTest, Commands) {
+  // Unchanged canvas state isn't set again and defs aren't drawn
+  std::string out =
+      draw("<rect width=\"1\" height=\"1\" fill=\"red\"/>"
+           "<rect width=\"2\" height=\"2\" fill=\"red\"/>"
+           "<defs><rect width=\"3\" height=\"3\" fill=\"red\"/></defs>"
+           "<text x=\"1\" y=\"2\" fill=\"red\">Hi</text>",
+           SVGCanvasWriter::Mode::COMMANDS);
+  ASSERT_EQ(out.find(SVGCanvasWriter::Interpreter), 0u);
+  EXPECT_EQ(out.substr(std::strlen(SVGCanvasWriter::Interpreter)),
+            "SVGCanvasReplay(ctx,\n"
+            "[0,4,0,0,1,1,9,0,7,0,4,0,0,2,2,7,13,1,14,2,15,3,1,2],\n"
+            "[\"#ff0000\",\"12px serif\",\"start\",\"Hi\"]);\n");
+}
+
+TEST(CanvasWriterTest, StrokePercentages) {
+  // Percentages refer to the normalized diagonal, sqrt((100² + 50²) / 2)
+  EXPECT_EQ(draw("<line x2=\"10\" stroke=\"red\" stroke-width=\"10%\" "
+                 "stroke-dasharray=\"10% 5\"/>",
+                 SVGCanvasWriter::Mode::CALLS),
+            "(function(c) {\n"
+            "c.beginPath();c.moveTo(0,0);c.lineTo(10,0);"
+            "c.strokeStyle=\"#ff0000\";c.lineWidth=7.91;"
+            "c.setLineDash([7.91,5]);c.stroke();\n"
+            "})(ctx);\n");
+}
@@ -0,0 +1,40 @@
+#include "svgutils/css_utils.h"
+#include "gtest/gtest.h"
+
+using namespace ::svg;
+
+static void expectColor(const CSSColor &color, double r, double g, double b,
+                        double a = 1.) {
+  EXPECT_NEAR(color.r, r, 1e-6);
+  EXPECT_NEAR(color.g, g, 1e-6);
+  EXPECT_NEAR(color.b, b, 1e-6);
+  EXPECT_NEAR(color.a, a, 1e-6);
+}
+
+TEST(CSSColorTest, NamedColors) {
+  expectColor(CSSColor::parse("red"), 1., 0., 0.);
+  expectColor(CSSColor::parse("LightGoldenRodYellow"), 250. / 255.,
+              250. / 255., 210. / 255.);
+  expectColor(CSSColor::parse("transparent"), 0., 0., 0., 0.);
+  EXPECT_FALSE(CSSColor::fromName("reddish"));
+  EXPECT_FALSE(CSSColor::fromName(""));
+  // Every name is found in the hash table
+#define CSS_COLOR(NAME, VALUE)                                                 \
+  EXPECT_TRUE(CSSColor::fromName(NAME)) << NAME;
+#include "svgutils/css_colors.def"
+}
+
+TEST(CSSColorTest, ColorFunctions) {
+  expectColor(CSSColor::parse("#abc"), 0xaa / 255., 0xbb / 255., 0xcc / 255.);
+  expectColor(CSSColor::parse("#11223344"), 0x11 / 255., 0x22 / 255.,
+              0x33 / 255., 0x44 / 255.);
+  expectColor(CSSColor::parse("rgb(255, 0, 51)"), 1., 0., .2);
+  expectColor(CSSColor::parse("rgba(100%,50%,0%,.5)"), 1., .5, 0., .5);
+  expectColor(CSSColor::parse("rgb(0 255 0 / 25%)"), 0., 1., 0., .25);
+  expectColor(CSSColor::parse("hsl(120, 100%, 50%)"), 0., 1., 0.);
+  expectColor(CSSColor::parse("hsla(-120deg 100% 25% / .5)"), 0., 0., .5,
+              .5);
+  // Invalid colors are black
+  expectColor(CSSColor::parse("#12"), 0., 0., 0.);
+  expectColor(CSSColor::parse("rgb(1, 2)"), 0., 0., 0.);
+}
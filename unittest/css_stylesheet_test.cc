@@ -0,0 +1,65 @@
+#include "svgutils/css_stylesheet.h"
+#include "svgutils/svg_writer.h"
+#include "gtest/gtest.h"
+
+using namespace ::svg;
+
+/// Indices of the rules matching @p element
+static std::vector<uint32_t> match(const CSSStylesheet &sheet,
+                                   CSSStylesheet::Element element) {
+  std::vector<CSSStylesheet::Match> matches;
+  sheet.match(element, matches);
+  std::vector<uint32_t> rules;
+  for (const auto &match : matches)
+    rules.push_back(match.second);
+  return rules;
+}
+
+TEST(CSSStylesheetTest, Parse) {
+  CSSStylesheet sheet;
+  sheet.parse("/* comment { fill: red } */ @import url(a.css);"
+              "@media print { path { fill: blue } }"
+              ".a, .b, g > .c, .d:hover { fill: red; stroke: blue !important }"
+              "#x { unknown-property: 1 }"
+              "path.a#y { stroke-width: 2 }");
+  // Unsupported selectors are skipped, rules without known properties too
+  EXPECT_EQ(sheet.getNumRules(), 2u);
+  EXPECT_EQ(sheet.getNumSelectors(), 3u);
+  const auto &decls = sheet.getDeclarations(0);
+  ASSERT_EQ(decls.size(), 2u);
+  EXPECT_EQ(decls[1].style, StyleTracker::Style::STROKE);
+  EXPECT_EQ(decls[1].value, "blue");
+}
+
+TEST(CSSStylesheetTest, MatchInCascadeOrder) {
+  CSSStylesheet sheet;
+  sheet.parse("path.a#y { fill: red }"   // 0
+              ".a.b { fill: blue }"      // 1
+              "* { fill: green }"        // 2
+              "path { fill: black }"     // 3
+              ".b { fill: white }"       // 4
+              "#y { fill: gray }");      // 5
+  EXPECT_EQ(match(sheet, {"path", "y", "b a"}),
+            (std::vector<uint32_t>{2, 3, 4, 1, 5, 0}));
+  EXPECT_EQ(match(sheet, {"rect", "", " b  b "}),
+            (std::vector<uint32_t>{2, 4}));
+  EXPECT_EQ(match(sheet, {"path", "x", "ab"}),
+            (std::vector<uint32_t>{2, 3}));
+}
+
+TEST(CSSStylesheetTest, StyleTrackerCascade) {
+  StyleTracker styles;
+  styles.addStylesheet(".land { fill: #00f; stroke: red }"
+                       "path.land { stroke-width: 3 }");
+  styles.push({class_("land"), fill("green"), stroke_width(1)}, "path");
+  // Rules override presentation attributes
+  EXPECT_EQ(styles.getFill().b, 1.);
+  EXPECT_EQ(styles.getStrokeWidth().length, 3.);
+  styles.push({class_("land"), style("fill: red")}, "rect");
+  // Inline styles override rules
+  EXPECT_EQ(styles.getFill().r, 1.);
+  EXPECT_EQ(styles.getStrokeWidth().length, 3.);
+  styles.pop();
+  styles.pop();
+  EXPECT_FALSE(styles.getFill());
+}
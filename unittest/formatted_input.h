@@ -0,0 +1,24 @@
+#ifndef SVGUTILS_UNITTEST_FORMATTED_INPUT_H
+#define SVGUTILS_UNITTEST_FORMATTED_INPUT_H
+
+#include "svgutils/svg_formatted_writer.h"
+#include "svgutils/svg_reader_writer.h"
+#include "gtest/gtest.h"
+
+#include <sstream>
+
+/// Document with nested, custom and text elements and a comment, for tests
+/// of writers forwarding calls to other writers
+static const char *Input = "<svg width=\"300\" height=\"200\">"
+                           "<g fill=\"red\"><custom foo=\"bar\"/>"
+                           "<rect x=\"1\" y=\"2\"/></g>"
+                           "<!-- note --><text>Hello</text></svg>";
+
+/// Input written by SVGFormattedWriter without anything in between
+static std::string formatDirectly() {
+  std::stringstream in(Input), out;
+  svg::SVGReaderWriter<svg::SVGFormattedWriter> Reader(out);
+  EXPECT_FALSE(Reader.parse(in));
+  return out.str();
+}
+#endif // SVGUTILS_UNITTEST_FORMATTED_INPUT_H
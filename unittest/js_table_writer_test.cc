@@ -0,0 +1,43 @@
+#include "svgutils/js_writer.h"
+#include "gtest/gtest.h"
+
+#include <sstream>
+
+using namespace ::svg;
+
+/// The part of the output after the interpreter
+static std::string table(const std::string &out) {
+  size_t pos = out.find("SVGWriterTable(", 100);
+  EXPECT_NE(pos, std::string::npos);
+  return out.substr(pos);
+}
+
+TEST(JSTableWriterTest, OpsAndStrings) {
+  std::stringstream out;
+  SVGJSTableWriter writer(out, "tags");
+  writer.svg(xmlns(), width(10))
+      ->enter()
+      ->rect(width(10), fill("red"))
+      ->rect(fill("red"), width(10))
+      ->text()
+      ->enter()
+      ->content("a<b")
+      ->comment("dropped")
+      ->leave()
+      ->leave()
+      ->finish();
+  EXPECT_EQ(table(out.str()),
+            "SVGWriterTable(tags,\n"
+            "[0,0,1,1,2,1,0,3,2,1,2,4,5,0,3,2,4,5,1,2,0,6,0,1,3,7,2,2],\n"
+            "[\"svg\",\"width\",\"10\",\"rect\",\"fill\",\"red\",\"text\","
+            "\"a\\x3cb\"]);\n");
+}
+
+TEST(JSTableWriterTest, Unused) {
+  // Writers that never write anything (e.g. replaced by continueAs) produce
+  // no output at all
+  std::stringstream out;
+  SVGJSTableWriter writer(out);
+  writer.finish();
+  EXPECT_EQ(out.str(), "");
+}
@@ -0,0 +1,84 @@
+#include "svgutils/css_utils.h"
+#include "svgutils/svg_writer.h"
+#include "gtest/gtest.h"
+
+using namespace ::svg;
+
+TEST(StyleTrackerTest, PopRestoresParentStyles) {
+  StyleTracker styles;
+  EXPECT_EQ(styles.getStrokeWidth().length, 1.);
+  EXPECT_EQ(styles.getFontFamily(), "serif");
+
+  styles.push({fill("red"), stroke_width(3)});
+  styles.push({style("fill: blue; stroke-width: 5px"), fill("green")});
+  // The style attribute overrides presentation attributes
+  EXPECT_EQ(styles.getFill().b, 1.);
+  EXPECT_EQ(styles.getStrokeWidth().length, 5.);
+  styles.pop();
+
+  EXPECT_EQ(styles.getFill().r, 1.);
+  EXPECT_EQ(styles.getFill().g, 0.);
+  EXPECT_EQ(styles.getStrokeWidth().length, 3.);
+  styles.pop();
+  EXPECT_EQ(styles.getStrokeWidth().length, 1.);
+}
+
+TEST(StyleTrackerTest, DefaultsForUnsetStyles) {
+  StyleTracker styles;
+  styles.push({color("red")});
+  EXPECT_EQ(styles.getWidth().length, 0.);
+  // Initially, neither fill nor stroke are painted
+  EXPECT_EQ(styles.getFill().a, 0.);
+  styles.set(StyleTracker::Style::FILL, "#f00");
+  EXPECT_EQ(styles.getFill().r, 1.);
+  styles.pop();
+  EXPECT_EQ(styles.getColor().r, 0.);
+}
+
+TEST(StyleTrackerTest, ParsedValuesAreReused) {
+  StyleTracker styles;
+  styles.push({stroke("blue"), stroke_width(2)});
+  for (int i = 0; i < 3; ++i) {
+    styles.push({x(i)});
+    EXPECT_EQ(styles.getStroke().b, 1.);
+    EXPECT_EQ(styles.getStrokeWidth().length, 2.);
+    styles.pop();
+  }
+  EXPECT_EQ(styles.getStatistics().lookups, 6u);
+  EXPECT_EQ(styles.getStatistics().parses, 2u);
+
+  styles.push({stroke_width(4)});
+  EXPECT_EQ(styles.getStrokeWidth().length, 4.);
+  styles.pop();
+  // The parent's parsed value is restored
+  EXPECT_EQ(styles.getStrokeWidth().length, 2.);
+  EXPECT_EQ(styles.getStatistics().parses, 3u);
+}
+
+TEST(StyleTrackerTest, SiblingsShareStyles) {
+  StyleTracker styles;
+  styles.addStylesheet(".land { stroke: red }");
+  styles.push({}, "g");
+  for (int i = 0; i < 3; ++i) {
+    styles.push({id(i), class_("land"), fill("#00f")}, "path");
+    EXPECT_EQ(styles.getFill().b, 1.);
+    EXPECT_EQ(styles.getStroke().r, 1.);
+    styles.pop();
+  }
+  styles.push({class_("land"), fill("#0f0")}, "path");
+  EXPECT_EQ(styles.getFill().g, 1.);
+  styles.pop();
+  styles.pop();
+  // Only the first path and the differently filled one are resolved
+  EXPECT_EQ(styles.getStatistics().sharingHits, 2u);
+  EXPECT_EQ(styles.getStatistics().sharingMisses, 3u);
+  EXPECT_EQ(styles.getStatistics().parses, 3u);
+
+  // The second group shares the styles of the first one, but its path is
+  // resolved again under the new parent
+  styles.push({}, "g");
+  styles.push({class_("land"), fill("#0f0")}, "path");
+  EXPECT_EQ(styles.getFill().g, 1.);
+  EXPECT_EQ(styles.getStatistics().sharingHits, 3u);
+  EXPECT_EQ(styles.getStatistics().sharingMisses, 4u);
+}
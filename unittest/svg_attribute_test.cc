@@ -0,0 +1,33 @@
+#include "svgutils/svg_writer.h"
+#include "gtest/gtest.h"
+
+#include <sstream>
+
+using namespace ::svg;
+
+TEST(SVGAttributeTest, NumberTupleFormatting) {
+  std::stringstream ss;
+  SVGWriter svg(ss);
+  svg.svg(width(300), viewBox(SVGNumberTuple::List(0, 0, 300, 200)))
+      ->enter()
+      ->g(id("a"), transform(SVGNumberTuple::Translate(10, -2.5)))
+      ->finish();
+  EXPECT_EQ(ss.str(), "<svg width=\"300\" viewBox=\"0 0 300 200\">"
+                      "<g id=\"a\" transform=\"translate(10 -2.5)\"></g>"
+                      "</svg>");
+}
+
+TEST(SVGAttributeTest, NumberTupleAccess) {
+  SVGAttribute attr = transform(SVGNumberTuple::Matrix(1, 0, 0, -1, 0, 5));
+  EXPECT_EQ(attr.cstrOrNull(), nullptr);
+  const SVGNumberTuple *tuple = attr.tupleOrNull();
+  ASSERT_NE(tuple, nullptr);
+  EXPECT_STREQ(tuple->getFunction(), "matrix");
+  ASSERT_EQ(tuple->size(), 6u);
+  EXPECT_EQ((*tuple)[3], -1.);
+  EXPECT_EQ((*tuple)[5], 5.);
+  EXPECT_EQ(attr.getValueStr(), "matrix(1 0 0 -1 0 5)");
+
+  SVGAttribute text = transform("scale(2)");
+  EXPECT_EQ(text.tupleOrNull(), nullptr);
+}
@@ -0,0 +1,107 @@
+#include "svgutils/svg_dedup_writer.h"
+#include "svgutils/svg_minifying_writer.h"
+#include "gtest/gtest.h"
+
+#include <sstream>
+
+using namespace ::svg;
+
+static const std::string Star =
+    "<path fill=\"gold\" stroke=\"orange\" "
+    "d=\"M10 0 13 7 20 7 14 12 16 20 10 15 4 20 6 12 0 7 7 7z\"/>";
+static const std::string StarMin =
+    "<path fill=\"gold\" stroke=\"orange\" "
+    "d=\"M10 0l3 7h7l-6 5 2 8-6-5-6 5 2-8L0 7H7z\"/>";
+static const std::string StarDef =
+    "<path id=\"dedup0\" fill=\"gold\" stroke=\"orange\" "
+    "d=\"M10 0l3 7h7l-6 5 2 8-6-5-6 5 2-8L0 7H7z\"/>";
+
+static const std::string XLinkDecl =
+    "xmlns:xlink=\"http://www.w3.org/1999/xlink\"";
+
+/// The whole deduplicated document
+static std::string dedupDocument(const std::string &svg,
+                                 SVGDedupWriter::Statistics *stats = nullptr,
+                                 const SVGDedupWriter::Options &options = {}) {
+  std::stringstream in(svg);
+  std::stringstream out;
+  WriterModel<SVGMinifyingWriter> writer(out);
+  SVGDedupWriter dedup(writer, options);
+  SVGReaderWriterBase reader(dedup);
+  EXPECT_FALSE(reader.parse(in));
+  if (stats)
+    *stats = dedup.getStatistics();
+  return out.str();
+}
+
+/// The deduplicated @p body of a document, without the root element
+static std::string dedup(const std::string &body,
+                         SVGDedupWriter::Statistics *stats = nullptr,
+                         const SVGDedupWriter::Options &options = {}) {
+  std::string str = dedupDocument("<svg>" + body + "</svg>", stats, options);
+  size_t start = str.find('>') + 1;
+  return str.substr(start, str.size() - start - 6);
+}
+
+TEST(DedupWriterTest, RepeatedSubtrees) {
+  SVGDedupWriter::Statistics stats;
+  EXPECT_EQ(dedup(Star + "<rect/>" + Star + Star, &stats),
+            "<use xlink:href=\"#dedup0\"/><rect/><use xlink:href=\"#dedup0\"/>"
+            "<use xlink:href=\"#dedup0\"/><defs>" +
+                StarDef + "</defs>");
+  EXPECT_EQ(stats.defs, 1u);
+  EXPECT_EQ(stats.uses, 3u);
+
+  // Only the outermost repeated subtree is defined. Transforms stay on the
+  // <use>, so copies at different positions are shared.
+  auto group = [](const char *x) {
+    return "<g transform=\"translate(" + std::string(x) + ")\">" + Star +
+           "<rect/></g>";
+  };
+  EXPECT_EQ(dedup(group("0") + group("50"), &stats),
+            "<use xlink:href=\"#dedup1\" transform=\"translate(0)\"/>"
+            "<use xlink:href=\"#dedup1\" transform=\"translate(50)\"/><defs>"
+            "<g id=\"dedup1\">" +
+                StarMin + "<rect/></g></defs>");
+  EXPECT_EQ(stats.defs, 1u);
+  EXPECT_EQ(stats.uses, 2u);
+}
+
+TEST(DedupWriterTest, Ineligible) {
+  // Too small, referenced, styled, or in a container without <use>
+  EXPECT_EQ(dedup("<rect/><rect/>"), "<rect/><rect/>");
+  std::string withId = Star;
+  withId.insert(5, " id=\"a\"");
+  EXPECT_EQ(dedup(withId + Star).find("<use"), std::string::npos);
+  std::string clip = "<clipPath>" + Star + "</clipPath>";
+  EXPECT_EQ(dedup(clip + clip).find("<use"), std::string::npos);
+}
+
+TEST(DedupWriterTest, BoundedBuffer) {
+  SVGDedupWriter::Options options;
+  options.bufferSize = 2;
+  SVGDedupWriter::Statistics stats;
+  // The first instance has already been written when the repeat shows up
+  // The root element was written before the <use>, which declares the xlink
+  // namespace itself
+  EXPECT_EQ(dedup(Star + "<rect/><rect/>" + Star, &stats, options),
+            StarMin + "<rect/><rect/><use " + XLinkDecl +
+                " xlink:href=\"#dedup0\"/><defs>" + StarDef + "</defs>");
+  EXPECT_EQ(stats.uses, 1u);
+
+  // Without room for candidates, nothing is deduplicated
+  options = {};
+  options.candidateBudget = 0;
+  EXPECT_EQ(dedup(Star + Star, &stats, options), StarMin + StarMin);
+  EXPECT_EQ(stats.candidates, 0u);
+}
+
+TEST(DedupWriterTest, XLinkDeclaration) {
+  // Only documents with a <use> declare the namespace, and only once
+  EXPECT_EQ(dedupDocument("<svg><rect/></svg>"), "<svg><rect/></svg>");
+  std::string out = dedupDocument("<svg>" + Star + Star + "</svg>");
+  EXPECT_EQ(out.find("<svg " + XLinkDecl + ">"), 0u);
+  EXPECT_EQ(out.find("xmlns", 6), std::string::npos);
+  std::string declared = "<svg " + XLinkDecl + ">" + Star + Star + "</svg>";
+  EXPECT_EQ(dedupDocument(declared), out);
+}
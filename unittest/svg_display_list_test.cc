@@ -0,0 +1,209 @@
+#include "svgutils/svg_display_list.h"
+#include "svgutils/svg_reader_writer.h"
+#include "gtest/gtest.h"
+
+#include <sstream>
+
+using namespace ::svg;
+
+static void parse(const std::string &svg, SVGDisplayListBuilder &builder) {
+  std::stringstream in(svg);
+  SVGReaderWriterBase reader(builder);
+  EXPECT_FALSE(reader.parse(in));
+}
+
+namespace {
+struct Recorder {
+  std::string out;
+  void moveTo(double x, double y) {
+    out += "M" + std::to_string(int(x)) + "," + std::to_string(int(y));
+  }
+  void lineTo(double x, double y) {
+    out += "L" + std::to_string(int(x)) + "," + std::to_string(int(y));
+  }
+  void cubicTo(double, double, double, double, double x, double y) {
+    out += "C" + std::to_string(int(x)) + "," + std::to_string(int(y));
+  }
+  void close() { out += "Z"; }
+};
+} // namespace
+
+TEST(SVGDisplayListTest, Shapes) {
+  SVGDisplayListBuilder builder;
+  parse("<svg width=\"400\" height=\"100\">"
+        "<style>.s { stroke: blue; stroke-width: 2 }</style>"
+        "<rect x=\"1\" y=\"2\" width=\"50%\" height=\"10\" fill=\"red\"/>"
+        "<defs><rect width=\"5\" height=\"5\"/></defs>"
+        "<circle cx=\"10\" cy=\"20\" r=\"5\" class=\"s\"/>"
+        "<line x1=\"0\" y1=\"0\" x2=\"4\" y2=\"4\" class=\"s\"/>"
+        "<path d=\"M0 0h3v3\" fill=\"none\"/>"
+        "<text x=\"5\" y=\"6\" font-size=\"12\">Hi</text></svg>",
+        builder);
+  const SVGDisplayList &list = builder.getDisplayList();
+  EXPECT_EQ(list.getWidth(), 400.);
+  EXPECT_EQ(list.getHeight(), 100.);
+  // The path is neither filled nor stroked, the rect in defs is ignored
+  ASSERT_EQ(list.getItems().size(), 4u);
+
+  const auto &items = list.getItems();
+  Recorder rect;
+  list.visitPath(items[0], rect);
+  EXPECT_EQ(rect.out, "M1,2L201,2L201,12L1,12Z");
+  const SVGDisplayList::Paint &rectPaint = list.getPaints()[items[0].paint];
+  EXPECT_EQ(rectPaint.fill.r, 1.);
+  EXPECT_FALSE(rectPaint.hasStroke());
+
+  Recorder circle;
+  list.visitPath(items[1], circle);
+  EXPECT_EQ(circle.out, "M15,20C10,25C5,20C10,15C15,20Z");
+  const SVGDisplayList::Paint &circlePaint = list.getPaints()[items[1].paint];
+  EXPECT_FALSE(circlePaint.hasFill());
+  EXPECT_TRUE(circlePaint.hasStroke());
+  EXPECT_EQ(circlePaint.strokeWidth, 2.);
+  EXPECT_EQ(items[2].paint, items[1].paint);
+
+  ASSERT_EQ(items[3].kind, SVGDisplayList::Kind::TEXT);
+  const SVGDisplayList::TextRun &run = list.getTextRuns()[items[3].first];
+  EXPECT_EQ(run.text, "Hi");
+  EXPECT_EQ(run.x, 5.);
+  EXPECT_EQ(run.y, 6.);
+  EXPECT_EQ(run.fontSize, 12.);
+  EXPECT_FALSE(run.continues);
+  // The text shares the paint of the path, which isn't drawn
+  EXPECT_EQ(list.getPaints().size(), 3u);
+}
+
+TEST(SVGDisplayListTest, TextChildren) {
+  // Children of text are drawn between its runs, which continue each other
+  SVGDisplayListBuilder builder;
+  parse("<svg fill=\"red\"><text x=\"5\" y=\"6\">a"
+        "<rect width=\"1\" height=\"1\"/>b</text></svg>",
+        builder);
+  const SVGDisplayList &list = builder.getDisplayList();
+  const auto &items = list.getItems();
+  ASSERT_EQ(items.size(), 3u);
+  EXPECT_EQ(items[0].kind, SVGDisplayList::Kind::TEXT);
+  EXPECT_EQ(items[1].kind, SVGDisplayList::Kind::PATH);
+  ASSERT_EQ(items[2].kind, SVGDisplayList::Kind::TEXT);
+  EXPECT_FALSE(list.getTextRuns()[items[0].first].continues);
+  EXPECT_TRUE(list.getTextRuns()[items[2].first].continues);
+}
+
+TEST(SVGDisplayListTest, SharedPaints) {
+  std::string svg = "<svg>";
+  for (int i = 0; i < 100; ++i)
+    svg += "<path d=\"M" + std::to_string(i) + " 0l1 1\" fill=\"" +
+           (i % 2 ? "red" : "green") + "\" stroke-dasharray=\"1 2\"" +
+           " stroke=\"black\"/>";
+  svg += "</svg>";
+  SVGDisplayListBuilder builder;
+  parse(svg, builder);
+  const SVGDisplayList &list = builder.getDisplayList();
+  EXPECT_EQ(list.getItems().size(), 100u);
+  ASSERT_EQ(list.getPaints().size(), 2u);
+  EXPECT_EQ(list.getDashes().size(), 4u);
+  EXPECT_EQ(list.getVerbs().size(), 200u);
+  EXPECT_EQ(list.getCoords().size(), 400u);
+  EXPECT_EQ(list.getPaints()[1].numDashes, 2u);
+  EXPECT_EQ(list.getDashes()[3], 2.);
+}
+
+TEST(SVGDisplayListTest, ViewBox) {
+  // The viewBox is fit into the middle of the document, and everything is
+  // recorded in px of the document
+  SVGDisplayListBuilder builder;
+  parse("<svg width=\"200\" height=\"100\" viewBox=\"0 0 20 20\">"
+        "<rect width=\"100%\" height=\"20\" fill=\"red\" stroke=\"blue\"/>"
+        "<text x=\"2\" y=\"4\" font-size=\"2\">Hi</text></svg>",
+        builder);
+  const SVGDisplayList &list = builder.getDisplayList();
+  EXPECT_EQ(list.getWidth(), 200.);
+  EXPECT_EQ(list.getHeight(), 100.);
+  const auto &items = list.getItems();
+  ASSERT_EQ(items.size(), 2u);
+  Recorder rect;
+  list.visitPath(items[0], rect);
+  EXPECT_EQ(rect.out, "M50,0L150,0L150,100L50,100Z");
+  EXPECT_EQ(list.getPaints()[items[0].paint].strokeWidth, 5.);
+  const SVGDisplayList::TextRun &run = list.getTextRuns()[items[1].first];
+  EXPECT_EQ(run.x, 60.);
+  EXPECT_EQ(run.y, 20.);
+  EXPECT_EQ(run.fontSize, 10.);
+
+  // Without dimensions the document has the size of the viewBox
+  SVGDisplayListBuilder sized;
+  parse("<svg viewBox=\"0 0 40 30\" preserveAspectRatio=\"none\"/>", sized);
+  EXPECT_EQ(sized.getDisplayList().getWidth(), 40.);
+  EXPECT_EQ(sized.getDisplayList().getHeight(), 30.);
+}
+
+TEST(SVGDisplayListTest, StrokePercentages) {
+  // Percentages refer to sqrt((70^2 + 10^2) / 2) = 50
+  SVGDisplayListBuilder builder;
+  parse("<svg width=\"70\" height=\"10\"><path d=\"M0 0h10\" stroke=\"red\" "
+        "stroke-width=\"10%\" stroke-dasharray=\"20% 4\"/></svg>",
+        builder);
+  const SVGDisplayList &list = builder.getDisplayList();
+  ASSERT_EQ(list.getPaints().size(), 1u);
+  EXPECT_DOUBLE_EQ(list.getPaints()[0].strokeWidth, 5.);
+  ASSERT_EQ(list.getDashes().size(), 2u);
+  EXPECT_DOUBLE_EQ(list.getDashes()[0], 10.);
+  EXPECT_EQ(list.getDashes()[1], 4.);
+}
+
+TEST(SVGDisplayListTest, Bounds) {
+  SVGDisplayListBuilder builder;
+  parse("<svg><g><rect x=\"10\" y=\"20\" width=\"5\" height=\"5\" "
+        "fill=\"red\"/><g stroke=\"black\" stroke-width=\"2\">"
+        "<line x1=\"0\" y1=\"0\" x2=\"4\" y2=\"-4\"/><g></g></g><g/></g>"
+        "<circle cx=\"100\" cy=\"100\" r=\"10\" stroke=\"red\"/></svg>",
+        builder);
+  const auto &items = builder.getDisplayList().getItems();
+  // Empty groups are dropped
+  ASSERT_EQ(items.size(), 5u);
+  ASSERT_EQ(items[0].kind, SVGDisplayList::Kind::GROUP);
+  EXPECT_EQ(items[0].first, 3u);
+  ASSERT_EQ(items[2].kind, SVGDisplayList::Kind::GROUP);
+  EXPECT_EQ(items[2].first, 1u);
+
+  const PathData::Bounds &rect = items[1].bounds;
+  EXPECT_EQ(rect.x0, 10.);
+  EXPECT_EQ(rect.y1, 25.);
+  // Lines have no joins, so the stroke adds half its width
+  const PathData::Bounds &line = items[3].bounds;
+  EXPECT_EQ(line.x0, -1.);
+  EXPECT_EQ(line.y0, -5.);
+  EXPECT_EQ(line.x1, 5.);
+  EXPECT_EQ(line.y1, 1.);
+  EXPECT_EQ(items[2].bounds.x0, -1.);
+
+  const PathData::Bounds &group = items[0].bounds;
+  EXPECT_EQ(group.x0, -1.);
+  EXPECT_EQ(group.y0, -5.);
+  EXPECT_EQ(group.x1, 15.);
+  EXPECT_EQ(group.y1, 25.);
+  EXPECT_FALSE(group.intersects(items[4].bounds));
+  EXPECT_EQ(items[4].bounds.x1, 110.5);
+}
+
+TEST(SVGDisplayListTest, Index) {
+  SVGDisplayListBuilder builder;
+  parse("<svg width=\"100\" height=\"100\" fill=\"red\">"
+        "<rect x=\"5\" y=\"5\" width=\"10\" height=\"10\"/>"
+        "<g><rect x=\"5\" y=\"50\" width=\"90\" height=\"10\"/>"
+        "<rect x=\"80\" y=\"80\" width=\"10\" height=\"10\"/></g>"
+        "<rect x=\"-50\" y=\"-50\" width=\"20\" height=\"20\"/></svg>",
+        builder);
+  const SVGDisplayList &list = builder.getDisplayList();
+  SVGDisplayListIndex index(list, 25.);
+  EXPECT_EQ(index.getNumItems(), 4u);
+
+  using Items = std::vector<uint32_t>;
+  EXPECT_EQ(index.query({0., 0., 100., 100.}), (Items{0, 2, 3}));
+  EXPECT_EQ(index.query({0., 0., 20., 20.}), Items{0});
+  // The long rect covers several cells, but is found once
+  EXPECT_EQ(index.query({0., 40., 100., 100.}), (Items{2, 3}));
+  EXPECT_EQ(index.query({20., 20., 40., 40.}), Items{});
+  // Items beyond the document are found as well
+  EXPECT_EQ(index.query({-100., -100., -40., -40.}), Items{4});
+}
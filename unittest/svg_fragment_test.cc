@@ -0,0 +1,74 @@
+#include "svgutils/svg_formatted_writer.h"
+#include "svgutils/svg_fragments.h"
+#include "gtest/gtest.h"
+
+#include <sstream>
+
+using namespace ::svg;
+
+template <typename WriterTy> static void writePanel(size_t idx, WriterTy &w) {
+  w.g(id(static_cast<int64_t>(idx)), fill("red"));
+  w.enter();
+  w.rect(x(static_cast<int64_t>(idx)), y(2));
+  w.circle(r(3), cx(4));
+  w.leave();
+}
+
+template <typename WriterTy> static void writeDocument(WriterTy &w) {
+  w.svg(width(300), height(200));
+  w.enter();
+  w.title(id("before"), fill("none"));
+}
+
+template <typename WriterTy> static std::string generateSerially() {
+  std::stringstream out;
+  WriterTy w(out);
+  writeDocument(w);
+  for (size_t i = 0; i < 50; ++i)
+    writePanel(i, w);
+  w.finish();
+  return out.str();
+}
+
+template <typename WriterTy> static std::string generateInParallel() {
+  std::stringstream out;
+  WriterTy w(out);
+  writeDocument(w);
+  EXPECT_FALSE(generateFragments(
+      w, 50, [](size_t i, WriterTy &child) { writePanel(i, child); }, 4));
+  w.finish();
+  return out.str();
+}
+
+TEST(FragmentTest, Plain) {
+  EXPECT_EQ(generateInParallel<SVGWriter>(), generateSerially<SVGWriter>());
+}
+
+TEST(FragmentTest, Formatted) {
+  std::string expected = generateSerially<SVGFormattedWriter>();
+  EXPECT_EQ(generateInParallel<SVGFormattedWriter>(), expected);
+  EXPECT_NE(expected.find("\n    <rect x=\"49\""), std::string::npos);
+}
+
+TEST(FragmentTest, ManualSplice) {
+  std::stringstream out;
+  SVGFormattedWriter w(out);
+  w.svg(width(300), height(200));
+  w.enter();
+  SVGFragment<SVGFormattedWriter> second = w.fork();
+  SVGFragment<SVGFormattedWriter> first = w.fork();
+  writePanel(1, second.getWriter());
+  writePanel(0, first.getWriter());
+  ASSERT_FALSE(w.splice(first));
+  ASSERT_FALSE(w.splice(second));
+  w.finish();
+
+  std::stringstream expected;
+  SVGFormattedWriter serial(expected);
+  serial.svg(width(300), height(200));
+  serial.enter();
+  writePanel(0, serial);
+  writePanel(1, serial);
+  serial.finish();
+  EXPECT_EQ(out.str(), expected.str());
+}
@@ -0,0 +1,73 @@
+#include "svgutils/svg_minifying_writer.h"
+#include "svgutils/svg_reader_writer.h"
+#include "gtest/gtest.h"
+
+#include <cstdlib>
+#include <sstream>
+
+using namespace ::svg;
+
+static std::string minifyPath(const char *d, unsigned precision = 3) {
+  return SVGMinifyingWriter::minifyPathData(d, precision);
+}
+
+TEST(MinifyingWriterTest, Numbers) {
+  EXPECT_EQ(SVGMinifyingWriter::formatNumber(0.5, 3), ".5");
+  EXPECT_EQ(SVGMinifyingWriter::formatNumber(-0.25, 3), "-.25");
+  EXPECT_EQ(SVGMinifyingWriter::formatNumber(12.00049, 3), "12");
+  EXPECT_EQ(SVGMinifyingWriter::formatNumber(-0.0001, 3), "0");
+  EXPECT_EQ(SVGMinifyingWriter::formatNumber(1.23456, 2), "1.23");
+  EXPECT_EQ(SVGMinifyingWriter::minifyNumbers("0, 0, 100.0000, 50.5", 3),
+            "0 0 100 50.5");
+  EXPECT_EQ(SVGMinifyingWriter::minifyNumbers(
+                " translate( 10.0001 , 20 ) rotate(45.0)", 3),
+            "translate(10 20)rotate(45)");
+  EXPECT_EQ(SVGMinifyingWriter::minifyNumbers("12.000px", 3), "12px");
+  EXPECT_EQ(SVGMinifyingWriter::minifyNumbers("url(#a)", 3), "url(#a)");
+  // Numbers longer than the formatting buffers
+  std::string large = SVGMinifyingWriter::formatNumber(1e80, 2);
+  EXPECT_EQ(large.size(), 81u);
+  EXPECT_DOUBLE_EQ(std::strtod(large.c_str(), nullptr), 1e80);
+  EXPECT_EQ(SVGMinifyingWriter::minifyNumbers(std::string(70, '0') + "12.5", 3),
+            "12.5");
+}
+
+TEST(MinifyingWriterTest, Colors) {
+  EXPECT_EQ(SVGMinifyingWriter::minifyColor("#FF0000"), "red");
+  EXPECT_EQ(SVGMinifyingWriter::minifyColor("#aabbcc"), "#abc");
+  EXPECT_EQ(SVGMinifyingWriter::minifyColor("rgb(0, 0, 128)"), "navy");
+  EXPECT_EQ(SVGMinifyingWriter::minifyColor("rgb(100%,100%,100%)"), "#fff");
+  EXPECT_EQ(SVGMinifyingWriter::minifyColor("White"), "#fff");
+  EXPECT_EQ(SVGMinifyingWriter::minifyColor("#123456"), "#123456");
+  EXPECT_EQ(SVGMinifyingWriter::minifyColor("none"), "none");
+  EXPECT_EQ(SVGMinifyingWriter::minifyColor("url(#grad)"), "url(#grad)");
+}
+
+TEST(MinifyingWriterTest, PathData) {
+  EXPECT_EQ(minifyPath("M 10.0001 20 L 30 40 L 50 60"), "M10 20 30 40 50 60");
+  EXPECT_EQ(minifyPath("M100,100 L100.5,100.5 L 101,101"),
+            "M100 100l.5.5.5.5");
+  EXPECT_EQ(minifyPath("M 0 0 L 10 0 L 10 10 Z"), "M0 0H10V10z");
+  EXPECT_EQ(minifyPath("m 1 1 c 0 0.5 0.5 1 1 1 s 1 1 2 2"),
+            "M1 1c0 .5.5 1 1 1S3 3 4 4");
+  EXPECT_EQ(minifyPath("M0,0 A 10 10 0 0 1 -20 0"), "M0 0A10 10 0 01-20 0");
+  // Relative coordinates must be based on the rounded position
+  EXPECT_EQ(minifyPath("M 0.4 0.4 l 0.4 0.4 l 0.4 0.4", 0), "M0 0 1 1H1");
+  // Invalid data is kept as is
+  EXPECT_EQ(minifyPath("M 10 L 20 20"), "M 10 L 20 20");
+}
+
+TEST(MinifyingWriterTest, Document) {
+  std::stringstream in("<svg xmlns=\"http://www.w3.org/2000/svg\" "
+                       "version=\"1.1\" width=\"300.0\" height=\"200\">"
+                       "<!-- dropped --><g fill=\"#ff0000\">"
+                       "<rect x=\"1.00001\" y=\"2\"/></g><g></g>"
+                       "<text x=\"5\">Hi</text></svg>");
+  std::stringstream out;
+  SVGReaderWriter<SVGMinifyingWriter> Reader(out);
+  ASSERT_FALSE(Reader.parse(in));
+  EXPECT_EQ(out.str(), "<svg xmlns=\"http://www.w3.org/2000/svg\" "
+                       "width=\"300\" height=\"200\"><g fill=\"red\">"
+                       "<rect x=\"1\" y=\"2\"/></g><g/>"
+                       "<text x=\"5\">Hi</text></svg>");
+}
@@ -0,0 +1,161 @@
+#include "svgutils/svg_minifying_writer.h"
+#include "svgutils/svg_optimizer.h"
+#include "svgutils/svg_reader_writer.h"
+#include "gtest/gtest.h"
+
+#include <sstream>
+
+using namespace ::svg;
+
+static std::string optimize(const std::string &body,
+                            SVGOptimizer::Statistics *stats = nullptr,
+                            unsigned numThreads = 1) {
+  std::stringstream in("<svg>" + body + "</svg>");
+  SVGDocumentBuilder builder;
+  SVGReaderWriterBase reader(builder);
+  EXPECT_FALSE(reader.parse(in));
+
+  SVGOptimizer::Options options;
+  options.numThreads = numThreads;
+  SVGOptimizer::Statistics res =
+      SVGOptimizer(options).optimize(builder.getDocument());
+  if (stats)
+    *stats = res;
+
+  std::stringstream out;
+  WriterModel<SVGMinifyingWriter> writer(out, SVGMinifyingWriter::MaxPrecision);
+  EXPECT_FALSE(builder.getDocument().write(writer));
+  std::string str = out.str();
+  return str.substr(5, str.size() - 11);
+}
+
+TEST(SVGDocumentTest, RoundTrip) {
+  std::stringstream in("<svg width=\"10\"><!-- c --><g fill=\"red\">"
+                       "<rect x=\"1\"/><custom a=\"b\"/></g>"
+                       "<text>Hello</text></svg>");
+  SVGDocumentBuilder builder;
+  SVGReaderWriterBase reader(builder);
+  ASSERT_FALSE(reader.parse(in));
+  SVGDocument &document = builder.getDocument();
+  EXPECT_EQ(document.countElements(), 5u);
+
+  const SVGNode &svgNode = *document.getRoot().children.front();
+  ASSERT_TRUE(svgNode.is(SVGNode::TagType::svg));
+  ASSERT_EQ(svgNode.children.size(), 3u);
+  EXPECT_EQ(svgNode.children[0]->kind, SVGNode::Kind::COMMENT);
+  const SVGNode &group = *svgNode.children[1];
+  ASSERT_NE(group.getAttr("fill"), nullptr);
+  EXPECT_EQ(*group.getAttr("fill"), "red");
+  EXPECT_EQ(group.children[1]->tag, SVGNode::TagType::NONE);
+  EXPECT_EQ(group.children[1]->name, "custom");
+  EXPECT_EQ(group.children[0]->parent, &group);
+
+  std::stringstream out;
+  WriterModel<SVGMinifyingWriter> writer(out);
+  EXPECT_FALSE(document.write(writer));
+  EXPECT_EQ(out.str(), "<svg width=\"10\"><g fill=\"red\"><rect x=\"1\"/>"
+                       "<custom a=\"b\"/></g><text>Hello</text></svg>");
+}
+
+TEST(SVGOptimizerTest, CollapseGroups) {
+  SVGOptimizer::Statistics stats;
+  // Groups without attributes
+  EXPECT_EQ(optimize("<g><g><rect/><circle/></g></g>", &stats),
+            "<rect/><circle/>");
+  EXPECT_EQ(stats.groupsCollapsed, 2u);
+  // Inherited attributes move to a single child, the child's own value wins
+  EXPECT_EQ(optimize("<g fill=\"red\" stroke=\"blue\"><rect fill=\"green\"/>"
+                     "</g>"),
+            "<rect fill=\"green\" stroke=\"#00f\"/>");
+  EXPECT_EQ(optimize("<g transform=\"scale(2)\"><rect transform=\"rotate(1)\"/>"
+                     "</g>"),
+            "<rect transform=\"scale(2)rotate(1)\"/>");
+  // Referenced or styled groups and non-inherited attributes stay
+  EXPECT_EQ(optimize("<g id=\"a\"><rect/></g>"), "<g id=\"a\"><rect/></g>");
+  EXPECT_EQ(optimize("<g class=\"c\"><rect/></g>"),
+            "<g class=\"c\"><rect/></g>");
+  EXPECT_EQ(optimize("<g clip-path=\"url(#c)\"><rect/></g>"),
+            "<g clip-path=\"url(#c)\"><rect/></g>");
+  EXPECT_EQ(optimize("<g opacity=\".5\"><rect opacity=\".5\"/></g>"),
+            "<g opacity=\".5\"><rect opacity=\".5\"/></g>");
+  // Titles and descriptions describe the group
+  EXPECT_EQ(optimize("<g><title>T</title><rect/></g>"),
+            "<g><title>T</title><rect/></g>");
+  EXPECT_EQ(optimize("<g fill=\"red\"><desc>D</desc><rect/></g>"),
+            "<g fill=\"red\"><desc>D</desc><rect/></g>");
+}
+
+TEST(SVGOptimizerTest, FoldAttributes) {
+  SVGOptimizer::Statistics stats;
+  EXPECT_EQ(optimize("<g id=\"g\"><rect fill=\"red\" x=\"1\"/>"
+                     "<circle fill=\"red\" stroke=\"blue\"/></g>",
+                     &stats),
+            "<g id=\"g\" fill=\"red\"><rect x=\"1\"/>"
+            "<circle stroke=\"#00f\"/></g>");
+  EXPECT_EQ(stats.attributesFolded, 1u);
+  // Referenced children keep their attributes
+  EXPECT_EQ(optimize("<g id=\"g\"><rect id=\"r\" fill=\"red\"/>"
+                     "<circle fill=\"red\"/></g>"),
+            "<g id=\"g\"><rect id=\"r\" fill=\"red\"/>"
+            "<circle fill=\"red\"/></g>");
+  // Values the group already has stay, relative values of the children
+  // depend on them
+  EXPECT_EQ(optimize("<g id=\"g\" font-size=\"10\">"
+                     "<text font-size=\"2em\">a</text>"
+                     "<text font-size=\"2em\">b</text></g>",
+                     &stats),
+            "<g id=\"g\" font-size=\"10\"><text font-size=\"2em\">a</text>"
+            "<text font-size=\"2em\">b</text></g>");
+  EXPECT_EQ(stats.attributesFolded, 0u);
+}
+
+TEST(SVGOptimizerTest, MergePaths) {
+  SVGOptimizer::Statistics stats;
+  EXPECT_EQ(optimize("<path fill=\"red\" d=\"M0 0h1v1z\"/>"
+                     "<path fill=\"red\" d=\"m10 10 1 0 0 1z\"/>"
+                     "<path fill=\"blue\" d=\"M20 20h1v1z\"/>",
+                     &stats),
+            "<path fill=\"red\" d=\"M0 0H1V1zM10 10h1v1z\"/>"
+            "<path fill=\"#00f\" d=\"M20 20h1v1z\"/>");
+  EXPECT_EQ(stats.pathsMerged, 1u);
+  // Overlapping paths are painted in order
+  EXPECT_EQ(optimize("<path d=\"M0 0h5v5z\"/><path d=\"M3 3h5v5z\"/>"),
+            "<path d=\"M0 0H5V5z\"/><path d=\"M3 3H8V8z\"/>");
+  // Arcs are bounded by the curves approximating them
+  EXPECT_EQ(optimize("<path d=\"M0 0a1 1 0 0 1 1 1\"/><path d=\"M9 9h1\"/>"),
+            "<path d=\"M0 0A1 1 0 011 1M9 9h1\"/>");
+  EXPECT_EQ(optimize("<path d=\"M0 0a5 5 0 0 1 0 8\"/><path d=\"M3 1h1\"/>"),
+            "<path d=\"M0 0A5 5 0 010 8\"/><path d=\"M3 1H4\"/>");
+}
+
+TEST(SVGOptimizerTest, RemoveUnusedDefs) {
+  SVGOptimizer::Statistics stats;
+  EXPECT_EQ(optimize("<defs><linearGradient id=\"a\"/>"
+                     "<linearGradient id=\"b\" href=\"#a\"/>"
+                     "<linearGradient id=\"c\"/></defs>"
+                     "<rect fill=\"url(#b)\"/>",
+                     &stats),
+            "<defs><linearGradient id=\"a\"/>"
+            "<linearGradient id=\"b\" href=\"#a\"/></defs>"
+            "<rect fill=\"url(#b)\"/>");
+  EXPECT_EQ(stats.defsRemoved, 1u);
+  // Definitions only referenced by unused definitions go as well
+  EXPECT_EQ(optimize("<defs><linearGradient id=\"a\"/>"
+                     "<linearGradient id=\"b\" href=\"#a\"/></defs><rect/>",
+                     &stats),
+            "<rect/>");
+  EXPECT_EQ(stats.defsRemoved, 3u);
+}
+
+TEST(SVGOptimizerTest, Parallel) {
+  std::string body;
+  for (unsigned i = 0; i < 64; ++i)
+    body += "<g><g fill=\"red\"><path d=\"M0 0h1\"/></g>"
+            "<path fill=\"red\" d=\"M5 5h1\"/></g>";
+  SVGOptimizer::Statistics serial, parallel;
+  std::string expected = optimize(body, &serial, 1);
+  EXPECT_EQ(optimize(body, &parallel, 8), expected);
+  EXPECT_EQ(parallel.groupsCollapsed, serial.groupsCollapsed);
+  EXPECT_EQ(parallel.pathsMerged, 64u);
+  EXPECT_EQ(parallel.elementsAfter, 65u);
+}
@@ -0,0 +1,188 @@
+#include "svgutils/svg_path_data.h"
+#include "gtest/gtest.h"
+
+#include <cmath>
+#include <sstream>
+
+using namespace ::svg;
+
+/// Segments of @p path as absolute path data with rounded coordinates
+static std::string toString(const PathData &path) {
+  struct Printer {
+    std::stringstream ss;
+    void point(double x, double y) {
+      ss << " " << std::round(x * 100) / 100;
+      ss << " " << std::round(y * 100) / 100;
+    }
+    void moveTo(double x, double y) {
+      ss << "M";
+      point(x, y);
+    }
+    void lineTo(double x, double y) {
+      ss << "L";
+      point(x, y);
+    }
+    void cubicTo(double x1, double y1, double x2, double y2, double x,
+                 double y) {
+      ss << "C";
+      point(x1, y1);
+      point(x2, y2);
+      point(x, y);
+    }
+    void close() { ss << "Z"; }
+  } printer;
+  path.visit(printer);
+  return printer.ss.str();
+}
+
+TEST(PathDataTest, Normalize) {
+  EXPECT_EQ(toString(PathData::parse("m1 2 3 4h1v-1zl1 1")),
+            "M 1 2L 4 6L 5 6L 5 5ZL 2 3");
+  // Quadratic curves are raised, smooth curves reflect the last control
+  // point
+  EXPECT_EQ(toString(PathData::parse("M0 0Q3 3 6 0T12 0")),
+            "M 0 0C 2 2 4 2 6 0C 8 -2 10 -2 12 0");
+  EXPECT_EQ(toString(PathData::parse("M0 0C0 1 1 1 1 0s2-1 2 0")),
+            "M 0 0C 0 1 1 1 1 0C 1 -1 3 -1 3 0");
+  EXPECT_EQ(toString(PathData::fromPoints("0,0 1,0 1,1", true)),
+            "M 0 0L 1 0L 1 1Z");
+}
+
+TEST(PathDataTest, Arcs) {
+  // A half circle becomes two quarter circles
+  PathData half = PathData::parse("M0 0A5 5 0 0 1 10 0");
+  EXPECT_EQ(toString(half), "M 0 0C 0 -2.76 2.24 -5 5 -5C 7.76 -5 10 -2.76 "
+                            "10 0");
+  // Radii that are too small are scaled up
+  EXPECT_EQ(toString(PathData::parse("M0 0A1 1 0 0 1 10 0")), toString(half));
+  EXPECT_EQ(toString(PathData::parse("M0 0A0 1 0 0 1 10 0")), "M 0 0L 10 0");
+}
+
+TEST(PathDataTest, Errors) {
+  // Everything up to the error is kept
+  PathData path = PathData::parse("M0 0L1 1L2");
+  EXPECT_EQ(toString(path), "M 0 0L 1 1");
+  EXPECT_FALSE(path.getError().empty());
+  EXPECT_TRUE(PathData::parse("M0 0").getError().empty());
+  EXPECT_TRUE(PathData::parse("0 0").empty());
+}
+
+TEST(PathDataTest, Transform) {
+  PathData path = PathData::parse("M1 2L3 4C0 0 1 1 2 2Z");
+  path.transform(PathData::Matrix::scale(2., 3.));
+  EXPECT_EQ(toString(path), "M 2 6L 6 12C 0 0 2 3 4 6Z");
+  path.transform(PathData::Matrix::translate(1., -1.));
+  EXPECT_EQ(toString(path), "M 3 5L 7 11C 1 -1 3 2 5 5Z");
+  // A quarter turn
+  path = PathData::parse("M1 0L0 2");
+  path.transform({0., 1., -1., 0., 0., 0.});
+  EXPECT_EQ(toString(path), "M 0 1L -2 0");
+}
+
+TEST(PathDataTest, Bounds) {
+  EXPECT_FALSE(PathData().getBounds());
+  // Control points are included
+  auto bounds = PathData::parse("M1 1L4 2C0 -3 2 5 3 3").getBounds();
+  ASSERT_TRUE(bounds);
+  EXPECT_EQ(bounds->x0, 0.);
+  EXPECT_EQ(bounds->y0, -3.);
+  EXPECT_EQ(bounds->x1, 4.);
+  EXPECT_EQ(bounds->y1, 5.);
+  // Extremes in the first, last, even and odd points
+  struct {
+    const char *d;
+    PathData::Bounds expected;
+  } cases[] = {{"M9 0L0 9", {0., 0., 9., 9.}},
+               {"M0 0L1 -1L2 2L-3 1", {-3., -1., 2., 2.}},
+               {"M0 5L2 0L1 1", {0., 0., 2., 5.}}};
+  for (const auto &test : cases) {
+    bounds = PathData::parse(test.d).getBounds();
+    ASSERT_TRUE(bounds);
+    EXPECT_EQ(bounds->x0, test.expected.x0) << test.d;
+    EXPECT_EQ(bounds->y0, test.expected.y0) << test.d;
+    EXPECT_EQ(bounds->x1, test.expected.x1) << test.d;
+    EXPECT_EQ(bounds->y1, test.expected.y1) << test.d;
+  }
+}
+
+TEST(PathDataTest, Flatten) {
+  // Lines stay as they are
+  EXPECT_EQ(toString(PathData::parse("M0 0L1 1Z").flatten(0.1)),
+            "M 0 0L 1 1Z");
+  PathData half = PathData::parse("M0 0A5 5 0 0 1 10 0Z");
+  for (double tolerance : {1., 0.1, 0.01}) {
+    PathData flat = half.flatten(tolerance);
+    const auto &verbs = flat.getVerbs();
+    ASSERT_EQ(verbs.front(), PathData::Verb::MOVE);
+    ASSERT_EQ(verbs.back(), PathData::Verb::CLOSE);
+    const auto &coords = flat.getCoords();
+    // All points lie on the circle, and the lines between them stay within
+    // the tolerance
+    for (size_t i = 2; i < coords.size(); i += 2) {
+      double x = coords[i] - 5., y = coords[i + 1];
+      EXPECT_NEAR(std::hypot(x, y), 5., 0.01);
+      double mx = (coords[i] + coords[i - 2]) / 2. - 5.;
+      double my = (coords[i + 1] + coords[i - 1]) / 2.;
+      EXPECT_LT(5. - std::hypot(mx, my), tolerance);
+    }
+    EXPECT_EQ(coords[coords.size() - 2], 10.);
+  }
+  EXPECT_GT(half.flatten(0.01).getVerbs().size(),
+            half.flatten(1.).getVerbs().size());
+}
+
+TEST(PathDataTest, Simplify) {
+  // Points close to the line between their neighbors are removed
+  EXPECT_EQ(toString(PathData::parse("M0 0L1 0.1L2 0L3 5").simplify(0.5)),
+            "M 0 0L 2 0L 3 5");
+  EXPECT_EQ(toString(PathData::parse("M0 0L1 0.1L2 0L3 5").simplify(0.1)),
+            "M 0 0L 1 0.1L 2 0L 3 5");
+  // Closed subpaths keep their corners, and the next subpath starts where
+  // the closed one did
+  EXPECT_EQ(toString(PathData::parse("M0 0h5h5v10h-10zl1 1").simplify(1.)),
+            "M 0 0L 10 0L 10 10L 0 10ZM 0 0L 1 1");
+
+  // Curves are flattened within the tolerance
+  PathData circle = PathData::parse("M0 5A5 5 0 0 1 10 5A5 5 0 0 1 0 5Z");
+  for (double tolerance : {1., 0.1}) {
+    PathData simple = circle.simplify(tolerance);
+    for (PathData::Verb verb : simple.getVerbs())
+      EXPECT_NE(verb, PathData::Verb::CUBIC);
+    const auto &coords = simple.getCoords();
+    for (size_t i = 0; i < coords.size(); i += 2)
+      EXPECT_NEAR(std::hypot(coords[i] - 5., coords[i + 1] - 5.), 5., 0.01);
+    EXPECT_LT(simple.getCoords().size(),
+              circle.flatten(tolerance / 2.).getCoords().size());
+  }
+  EXPECT_LT(circle.simplify(1.).getCoords().size(),
+            circle.simplify(0.1).getCoords().size());
+}
+
+TEST(PathDataTest, Tokens) {
+  // Numbers don't need separators if they can't be read as one
+  EXPECT_EQ(toString(PathData::parse("M.5.5-1-1e1L1e+1,2E-1")),
+            "M 0.5 0.5L -1 -10L 10 0.2");
+  // Neither do arc flags
+  EXPECT_EQ(toString(PathData::parse("M0 0a5 5 0 0110 0")),
+            toString(PathData::parse("M0 0a5 5 0 0 1 10 0")));
+  // Tokens reaching across blocks of the tokenizer
+  std::string d = "M0 0";
+  for (int i = 0; i < 20; ++i)
+    d += "L" + std::to_string(i) + ".125," + std::to_string(-i) + ".5 ";
+  PathData path = PathData::parse(d);
+  EXPECT_TRUE(path.getError().empty());
+  ASSERT_EQ(path.getCoords().size(), 42u);
+  EXPECT_EQ(path.getCoords()[40], 19.125);
+  EXPECT_EQ(path.getCoords()[41], -19.5);
+  // Numbers convert like strtod
+  path = PathData::parse("M0.1 123456789012345678901 1e-30 3.14159265358979");
+  ASSERT_EQ(path.getCoords().size(), 4u);
+  EXPECT_EQ(path.getCoords()[0], 0.1);
+  EXPECT_EQ(path.getCoords()[1], 123456789012345678901.);
+  EXPECT_EQ(path.getCoords()[2], 1e-30);
+  EXPECT_EQ(path.getCoords()[3], 3.14159265358979);
+
+  path = PathData::parse("M0 0L1 1#2 2");
+  EXPECT_EQ(toString(path), "M 0 0L 1 1");
+  EXPECT_FALSE(path.getError().empty());
+}
@@ -0,0 +1,80 @@
+#include "svgutils/svg_formatted_writer.h"
+#include "svgutils/svg_pipeline.h"
+#include "formatted_input.h"
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <sstream>
+
+using namespace ::svg;
+
+TEST(PipelineTest, SameOutput) {
+  using BP = SVGPipelineWriter::Backpressure;
+  for (BP backpressure : {BP::SPIN, BP::YIELD, BP::SLEEP}) {
+    std::stringstream in(Input), out;
+    SVGPipelinedReaderWriter<SVGFormattedWriter> Reader(out);
+    SVGPipelineWriter::Options options;
+    // Use a tiny queue to exercise the full-queue path
+    options.queueSize = 2;
+    options.backpressure = backpressure;
+    Reader.getPipeline().setOptions(options);
+    ASSERT_FALSE(Reader.parse(in));
+    EXPECT_EQ(out.str(), formatDirectly());
+
+    SVGPipelineWriter::Statistics stats = Reader.getPipeline().getStatistics();
+    EXPECT_GT(stats.events, 0u);
+    EXPECT_LE(stats.maxOccupancy, 2u);
+  }
+}
+
+namespace {
+/// Formats the document, but takes its time for the first element it
+/// enters
+struct SlowWriter : public WriterModel<SVGFormattedWriter> {
+  using WriterModel::WriterModel;
+  RetTy enter() override {
+    if (!entered) {
+      entered = true;
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    return WriterModel::enter();
+  }
+  bool entered = false;
+};
+
+/// Formats the document, but fails on rects
+struct FailingWriter : public WriterModel<SVGFormattedWriter> {
+  using WriterModel::WriterModel;
+  RetTy rect(const std::vector<SVGAttribute> &) override {
+    return SVGWriterError("Cannot write rects");
+  }
+};
+} // namespace
+
+TEST(PipelineTest, Backpressure) {
+  std::stringstream in(Input), out;
+  SlowWriter writer(out);
+  SVGPipelineWriter::Options options;
+  // Rounded up to the smallest queue possible
+  options.queueSize = 1;
+  SVGPipelineWriter pipeline(writer, options);
+  SVGReaderWriterBase Reader(pipeline);
+  ASSERT_FALSE(Reader.parse(in));
+  EXPECT_EQ(out.str(), formatDirectly());
+
+  // The parser had to wait for the writer instead of queueing everything
+  SVGPipelineWriter::Statistics stats = pipeline.getStatistics();
+  EXPECT_GT(stats.producerStalls, 0u);
+  EXPECT_LE(stats.maxOccupancy, 2u);
+}
+
+TEST(PipelineTest, WriterError) {
+  std::stringstream in(Input), out;
+  FailingWriter writer(out);
+  SVGPipelineWriter pipeline(writer);
+  SVGReaderWriterBase Reader(pipeline);
+  // The error happens on the consumer thread and is reported by parse()
+  auto err = Reader.parse(in);
+  ASSERT_TRUE(err);
+  EXPECT_EQ(err->what, "Cannot write rects");
+}
@@ -0,0 +1,90 @@
+#include "svgutils/svg_reader_writer.h"
+#include "svgutils/svg_style_resolver.h"
+#include "gtest/gtest.h"
+
+#include <sstream>
+
+using namespace ::svg;
+
+static void parse(const std::string &svg, SVGDocumentBuilder &builder) {
+  std::stringstream in(svg);
+  SVGReaderWriterBase reader(builder);
+  EXPECT_FALSE(reader.parse(in));
+}
+
+static bool operator==(const CSSColor &a, const CSSColor &b) {
+  return a.r == b.r && a.g == b.g && a.b == b.b && a.a == b.a;
+}
+
+TEST(SVGStyleResolverTest, Cascade) {
+  SVGDocumentBuilder builder;
+  parse("<svg><style>.land { fill: green } #fr { stroke: blue }</style>"
+        "<g fill=\"red\" stroke-width=\"3\"><rect/>"
+        "<path class=\"land\" id=\"fr\" style=\"stroke-width: 2\"/></g>"
+        "<circle/></svg>",
+        builder);
+  SVGStyleResolver resolver;
+  SVGStyleResolver::Statistics stats = resolver.resolve(builder.getDocument());
+  EXPECT_EQ(stats.elements, 6u);
+  ASSERT_EQ(resolver.getNodes().size(), 6u);
+
+  const SVGNode &svgNode = *builder.getDocument().getRoot().children.front();
+  const SVGNode &group = *svgNode.children[1];
+  const SVGComputedStyle *rect = resolver.get(*group.children[0]);
+  ASSERT_NE(rect, nullptr);
+  EXPECT_TRUE(rect->fill == CSSColor(1., 0., 0.));
+  EXPECT_EQ(rect->strokeWidth.length, 3.);
+
+  const SVGComputedStyle *path = resolver.get(*group.children[1]);
+  ASSERT_NE(path, nullptr);
+  EXPECT_TRUE(path->fill == CSSColor(0., 128. / 255., 0.));
+  EXPECT_TRUE(path->stroke == CSSColor(0., 0., 1.));
+  EXPECT_EQ(path->strokeWidth.length, 2.);
+
+  const SVGComputedStyle *circle = resolver.get(*svgNode.children[2]);
+  ASSERT_NE(circle, nullptr);
+  EXPECT_EQ(circle->fill.a, 0.);
+  EXPECT_EQ(resolver.get(*svgNode.children[0]->children[0]), nullptr);
+}
+
+TEST(SVGStyleResolverTest, ParallelMatchesSerial) {
+  std::string svg = "<svg><style>.a { stroke: red }</style>";
+  for (int i = 0; i < 50; ++i) {
+    svg += "<g fill=\"#" + std::to_string(100 + i) + "\">";
+    for (int j = 0; j < 20; ++j)
+      svg += "<g stroke-width=\"" + std::to_string(j) + "\"><rect/>" +
+             "<path class=\"" + (j % 3 ? "a" : "b") + "\" font-size=\"" +
+             std::to_string(i) + "px\"/></g>";
+    svg += "</g>";
+  }
+  svg += "</svg>";
+  SVGDocumentBuilder builder;
+  parse(svg, builder);
+
+  SVGStyleResolver::Options options;
+  options.numThreads = 1;
+  SVGStyleResolver serial(options);
+  serial.resolve(builder.getDocument());
+  options.numThreads = 4;
+  options.minTaskElements = 16;
+  SVGStyleResolver parallel(options);
+  SVGStyleResolver::Statistics stats = parallel.resolve(builder.getDocument());
+  EXPECT_GT(stats.tasks, 4u);
+  EXPECT_EQ(stats.threads, 4u);
+
+  ASSERT_EQ(serial.getStyles().size(), parallel.getStyles().size());
+  EXPECT_EQ(serial.getNodes(), parallel.getNodes());
+  for (size_t i = 0; i < serial.getStyles().size(); ++i) {
+    const SVGComputedStyle &a = serial.getStyles()[i];
+    const SVGComputedStyle &b = parallel.getStyles()[i];
+    EXPECT_TRUE(a.fill == b.fill) << i;
+    EXPECT_TRUE(a.stroke == b.stroke) << i;
+    EXPECT_EQ(a.strokeWidth.length, b.strokeWidth.length) << i;
+    EXPECT_EQ(a.fontSize.length, b.fontSize.length) << i;
+  }
+  // Spot check the last path
+  const SVGComputedStyle &last = parallel.getStyles().back();
+  EXPECT_TRUE(last.stroke == CSSColor(1., 0., 0.));
+  EXPECT_EQ(last.strokeWidth.length, 19.);
+  EXPECT_EQ(last.fontSize.length, 49.);
+}
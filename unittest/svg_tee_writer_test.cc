@@ -0,0 +1,39 @@
+#include "svgutils/svg_formatted_writer.h"
+#include "svgutils/svg_reader_writer.h"
+#include "svgutils/svg_tee_writer.h"
+#include "formatted_input.h"
+#include "gtest/gtest.h"
+
+#include <sstream>
+
+using namespace ::svg;
+
+TEST(TeeWriterTest, Static) {
+  std::stringstream in(Input), raw, formatted;
+  using TeeTy = SVGTeeWriter<SVGWriter, SVGFormattedWriter>;
+  SVGReaderWriter<TeeTy> Reader{SVGWriter(raw), SVGFormattedWriter(formatted)};
+  ASSERT_FALSE(Reader.parse(in));
+  EXPECT_EQ(formatted.str(), formatDirectly());
+  EXPECT_NE(raw.str(), formatted.str());
+  EXPECT_NE(raw.str().find("<custom foo=\"bar\"></custom>"), std::string::npos);
+}
+
+TEST(TeeWriterTest, Threaded) {
+  using BP = SPSCBackpressure;
+  std::string expected = formatDirectly();
+  for (BP backpressure : {BP::SPIN, BP::YIELD, BP::SLEEP}) {
+    std::stringstream first, second;
+    // Use a tiny queue to exercise the full-queue path
+    SVGDynamicTeeWriter Tee(SVGDynamicTeeWriter::Mode::THREADED, 2,
+                            {backpressure, std::chrono::microseconds(1)});
+    Tee.emplaceWriter<SVGFormattedWriter>(first);
+    Tee.emplaceWriter<SVGFormattedWriter>(second);
+    {
+      std::stringstream in(Input);
+      SVGReaderWriterBase Reader(Tee);
+      ASSERT_FALSE(Reader.parse(in));
+    }
+    EXPECT_EQ(first.str(), expected);
+    EXPECT_EQ(second.str(), expected);
+  }
+}
@@ -0,0 +1,131 @@
+#include "svgutils/svg_viewport.h"
+#include "gtest/gtest.h"
+
+using namespace ::svg;
+
+TEST(SVGViewportTest, ParseViewBox) {
+  std::optional<SVGViewBox> box =
+      SVGViewBox::parse(viewBox(" -10,20.5 1e2\t50 "));
+  ASSERT_TRUE(box);
+  EXPECT_EQ(box->x, -10.);
+  EXPECT_EQ(box->y, 20.5);
+  EXPECT_EQ(box->width, 100.);
+  EXPECT_EQ(box->height, 50.);
+
+  box = SVGViewBox::parse(viewBox(SVGNumberTuple::List(0., 0., 4., 3.)));
+  ASSERT_TRUE(box);
+  EXPECT_EQ(box->width, 4.);
+
+  EXPECT_FALSE(SVGViewBox::parse(viewBox("0 0 100")));
+  EXPECT_FALSE(SVGViewBox::parse(viewBox("0 0 100 50 1")));
+  EXPECT_FALSE(SVGViewBox::parse(viewBox("0 0 0 50")));
+  EXPECT_FALSE(SVGViewBox::parse(viewBox("0 0 a 50")));
+}
+
+TEST(SVGViewportTest, ParsePreserveAspectRatio) {
+  SVGPreserveAspectRatio aspect = SVGPreserveAspectRatio::parse("xMinYMax");
+  EXPECT_FALSE(aspect.none);
+  EXPECT_EQ(aspect.x, SVGPreserveAspectRatio::Align::MIN);
+  EXPECT_EQ(aspect.y, SVGPreserveAspectRatio::Align::MAX);
+  EXPECT_FALSE(aspect.slice);
+
+  aspect = SVGPreserveAspectRatio::parse(" defer xMaxYMid  slice");
+  EXPECT_EQ(aspect.x, SVGPreserveAspectRatio::Align::MAX);
+  EXPECT_TRUE(aspect.slice);
+  EXPECT_TRUE(SVGPreserveAspectRatio::parse("none").none);
+
+  // Invalid values fall back to xMidYMid meet
+  aspect = SVGPreserveAspectRatio::parse("xMinYMax cover");
+  EXPECT_EQ(aspect.x, SVGPreserveAspectRatio::Align::MID);
+  EXPECT_EQ(aspect.y, SVGPreserveAspectRatio::Align::MID);
+}
+
+TEST(SVGViewportTest, Transform) {
+  SVGViewBox box{10., 0., 200., 100.};
+  // Fit into 100x100: half the size, centered vertically
+  PathData::Matrix m = SVGPreserveAspectRatio().getTransform(box, 100., 100.);
+  EXPECT_EQ(m.a, .5);
+  EXPECT_EQ(m.d, .5);
+  EXPECT_EQ(m.e, -5.);
+  EXPECT_EQ(m.f, 25.);
+
+  SVGPreserveAspectRatio aspect =
+      SVGPreserveAspectRatio::parse("xMaxYMin slice");
+  m = aspect.getTransform(box, 100., 100.);
+  EXPECT_EQ(m.a, 1.);
+  EXPECT_EQ(m.e, -110.);
+  EXPECT_EQ(m.f, 0.);
+
+  m = SVGPreserveAspectRatio::parse("none").getTransform(box, 100., 100.);
+  EXPECT_EQ(m.a, .5);
+  EXPECT_EQ(m.d, 1.);
+}
+
+TEST(SVGViewportTest, Compute) {
+  using Fit = SVGViewport::Fit;
+  SVGPreserveAspectRatio meet;
+  // The output gets the size of the document
+  SVGViewport vp = SVGViewport::compute(100., 50., std::nullopt, meet, 0., 0.,
+                                        Fit::VIEWPORT, 300., 200.);
+  EXPECT_EQ(vp.width, 100.);
+  EXPECT_EQ(vp.height, 50.);
+  EXPECT_EQ(vp.getScale(), 1.);
+  EXPECT_EQ(vp.userWidth, 100.);
+  EXPECT_EQ(vp.userHeight, 50.);
+
+  // Missing dimensions follow from the viewBox or are the default
+  SVGViewBox box{0., 0., 40., 30.};
+  vp = SVGViewport::compute(0., 0., box, meet, 0., 0., Fit::VIEWPORT, 300.,
+                            200.);
+  EXPECT_EQ(vp.width, 40.);
+  EXPECT_EQ(vp.height, 30.);
+  EXPECT_EQ(vp.getScale(), 1.);
+  vp = SVGViewport::compute(80., 0., box, meet, 0., 0., Fit::VIEWPORT, 300.,
+                            200.);
+  EXPECT_EQ(vp.height, 60.);
+  EXPECT_EQ(vp.transform.a, 2.);
+  EXPECT_EQ(vp.userWidth, 40.);
+  vp = SVGViewport::compute(80., 0., std::nullopt, meet, 0., 0.,
+                            Fit::VIEWPORT, 300., 200.);
+  EXPECT_EQ(vp.height, 200.);
+
+  // The output is the viewport, so only the viewBox is scaled into it
+  vp = SVGViewport::compute(100., 50., std::nullopt, meet, 200., 200.,
+                            Fit::VIEWPORT, 300., 200.);
+  EXPECT_EQ(vp.width, 200.);
+  EXPECT_EQ(vp.getScale(), 1.);
+  EXPECT_EQ(vp.userWidth, 200.);
+  vp = SVGViewport::compute(100., 50., SVGViewBox{0., 0., 100., 50.}, meet,
+                            200., 200., Fit::VIEWPORT, 300., 200.);
+  EXPECT_EQ(vp.transform.a, 2.);
+  EXPECT_EQ(vp.transform.e, 0.);
+  EXPECT_EQ(vp.transform.f, 50.);
+  EXPECT_EQ(vp.userWidth, 100.);
+  vp = SVGViewport::compute(100., 50., std::nullopt, meet, 150., 0.,
+                            Fit::VIEWPORT, 300., 200.);
+  EXPECT_EQ(vp.width, 150.);
+  EXPECT_EQ(vp.height, 200.);
+
+  // Fitting takes the size of the scaled document
+  vp = SVGViewport::compute(100., 50., std::nullopt, meet, 200., 200.,
+                            Fit::FIT, 300., 200.);
+  EXPECT_EQ(vp.width, 200.);
+  EXPECT_EQ(vp.height, 100.);
+  EXPECT_EQ(vp.transform.a, 2.);
+  EXPECT_EQ(vp.userWidth, 100.);
+  vp = SVGViewport::compute(100., 50., std::nullopt, meet, 50., 0., Fit::FIT,
+                            300., 200.);
+  EXPECT_EQ(vp.width, 50.);
+  EXPECT_EQ(vp.height, 25.);
+  EXPECT_EQ(vp.transform.d, .5);
+
+  // Filling crops both sides evenly
+  vp = SVGViewport::compute(100., 50., std::nullopt, meet, 200., 200.,
+                            Fit::FILL, 300., 200.);
+  EXPECT_EQ(vp.width, 200.);
+  EXPECT_EQ(vp.height, 200.);
+  EXPECT_EQ(vp.transform.a, 4.);
+  EXPECT_EQ(vp.transform.e, -100.);
+  EXPECT_EQ(vp.transform.f, 0.);
+  EXPECT_EQ(vp.getScale(), 4.);
+}
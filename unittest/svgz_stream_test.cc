@@ -0,0 +1,99 @@
+#include "svgutils/svg_formatted_writer.h"
+#include "svgutils/svg_reader_writer.h"
+#include "svgutils/svgz_stream.h"
+#include "gtest/gtest.h"
+
+#include <sstream>
+
+using namespace ::svg;
+
+static std::string makeDocument() {
+  std::stringstream out;
+  SVGFormattedWriter w(out);
+  w.svg(width(300), height(200));
+  w.enter();
+  for (int i = 0; i < 1000; ++i)
+    w.rect(x(i), y(2 * i), fill("red"));
+  w.finish();
+  return out.str();
+}
+
+static std::string compress(const std::string &data, int level) {
+  std::stringstream compressed;
+  {
+    GzipOutputStream gz(compressed, level);
+    gz << data;
+  }
+  return compressed.str();
+}
+
+TEST(SVGZStreamTest, RoundTrip) {
+  std::string doc = makeDocument();
+  std::stringstream plain(doc), expected;
+  SVGReaderWriter<SVGFormattedWriter> Direct(expected);
+  ASSERT_FALSE(Direct.parse(plain));
+  for (int level : {0, 1, DeflateStreamBuf::DefaultLevel, 9}) {
+    std::string compressed = compress(doc, level);
+    if (level) {
+      EXPECT_LT(compressed.size() * 5, doc.size());
+    }
+
+    std::stringstream source(compressed);
+    GzipInputStream in(source);
+    std::stringstream out;
+    SVGReaderWriter<SVGFormattedWriter> Reader(out);
+    ASSERT_FALSE(Reader.parse(in));
+    EXPECT_FALSE(in.failed());
+    EXPECT_EQ(out.str(), expected.str());
+  }
+}
+
+TEST(SVGZStreamTest, SmallBuffers) {
+  std::string doc = makeDocument();
+  std::stringstream compressed;
+  {
+    DeflateStreamBuf buf(compressed, 9, 7);
+    std::ostream os(&buf);
+    os << doc;
+  }
+  // Concatenated gzip members decompress to the concatenated data
+  compressed << compress("<!-- trailer -->", 6);
+  InflateStreamBuf buf(compressed, 5);
+  std::istream is(&buf);
+  std::stringstream decompressed;
+  decompressed << is.rdbuf();
+  EXPECT_FALSE(buf.failed());
+  EXPECT_EQ(decompressed.str(), doc + "<!-- trailer -->");
+}
+
+TEST(SVGZStreamTest, Truncated) {
+  std::string compressed = compress(makeDocument(), 6);
+  std::stringstream source(compressed.substr(0, compressed.size() / 2));
+  GzipInputStream in(source);
+  std::stringstream out;
+  SVGReaderWriter<SVGFormattedWriter> Reader(out);
+  EXPECT_TRUE(Reader.parse(in));
+  EXPECT_TRUE(in.failed());
+}
+
+TEST(SVGZStreamTest, CorruptTrailer) {
+  // A bad checksum is only noticed after the last block, whose data is still
+  // delivered
+  std::string doc = makeDocument();
+  std::string compressed = compress(doc, 6);
+  compressed[compressed.size() - 8] ^= 1;
+  std::stringstream source(compressed);
+  InflateStreamBuf buf(source);
+  std::istream is(&buf);
+  std::stringstream decompressed;
+  decompressed << is.rdbuf();
+  EXPECT_TRUE(buf.failed());
+  EXPECT_EQ(decompressed.str(), doc);
+}
+
+TEST(SVGZStreamTest, Extension) {
+  EXPECT_TRUE(isSVGZPath("map.svgz"));
+  EXPECT_TRUE(isSVGZPath("dir/MAP.SVGZ"));
+  EXPECT_FALSE(isSVGZPath("map.svg"));
+  EXPECT_FALSE(isSVGZPath("vgz"));
+}